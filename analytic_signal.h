@@ -0,0 +1,304 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <complex>
+#include <vector>
+#include <memory>
+#include "capture_frame.h"
+#include "fft_engine.h"
+#include "task_scheduler.h"
+
+// Circular phase statistics of one channel's analytic signal
+struct PhaseStats
+{
+    double meanPhase = 0.0;
+    double phaseVariance = 0.0;
+};
+
+// Batched analytic-signal (Hilbert) phase analysis for several channels of one
+// frame. The channel windows are extracted together into a structure-of-arrays
+// workspace, two real channels share each forward FFT, and the Hamming window,
+// FFT plan and work buffers are kept between calls, so a frame costs no heap
+// allocation once the batch has been sized. Results match the per-channel
+// computeInstantaneousPhase it replaces; a channel that stays high or low for
+// the whole window is reported as 0/0, as it was there, rather than analysed
+// from the rounding residue of its pair partner.
+// Given a scheduler, window extraction fans out per channel and the
+// transforms per channel pair; every pair has its own work buffers, so the
+// tasks share nothing but the read-only window and plan.
+class AnalyticSignalBatch
+{
+public:
+    explicit AnalyticSignalBatch(int windowSize = 2048)
+        : m_windowSize(windowSize), m_plan(FftPlanCache::get(windowSize)),
+          m_window(windowSize)
+    {
+        // Hamming window to reduce spectral leakage
+        const double pi = 3.14159265358979323846;
+        const double a0 = 0.54;
+        const double a1 = 0.46;
+        for (int i = 0; i < windowSize; ++i)
+        {
+            m_window[i] = a0 - a1 * cos(2 * pi * i / (windowSize - 1));
+        }
+    }
+
+    int windowSize() const
+    {
+        return m_windowSize;
+    }
+
+    // Phase statistics for the given channels of a frame; out must hold
+    // channelCount entries. Without a scheduler everything runs on the
+    // calling thread.
+    void compute(const CaptureFrame &frame, AnalysisLayout layout, const int *channels, int channelCount, PhaseStats *out,
+                 TaskScheduler *scheduler = nullptr)
+    {
+        const int N = static_cast<int>(frame.size());
+        if (channelCount <= 0)
+            return;
+
+        if (N < m_windowSize)
+        {
+            computeDutyCycleFallback(frame, layout, channels, channelCount, out);
+            return;
+        }
+
+        const int pairCount = (channelCount + 1) / 2;
+        reserve(channelCount, pairCount);
+
+        // Holding the derived layouts keeps them alive for the extraction tasks
+        std::shared_ptr<const BitSlicedFrame> bitSliced;
+        std::shared_ptr<const EdgeListFrame> edgeList;
+        if (layout == AnalysisLayout::BITSLICED)
+        {
+            bitSliced = frame.bitSliced();
+        }
+        else if (layout == AnalysisLayout::EDGES)
+        {
+            edgeList = frame.edgeList();
+        }
+        const size_t start = frame.size() - m_windowSize;
+
+        if (scheduler && scheduler->threadCount() > 0)
+        {
+            scheduler->parallelFor(0, channelCount, [&](int c)
+                                   { m_idle[c] = extractWindow(frame, bitSliced.get(), edgeList.get(), start, channels[c], input(c)); });
+            scheduler->parallelFor(0, pairCount, [&](int pair)
+                                   { analyzePair(pair, channelCount, out); });
+        }
+        else
+        {
+            for (int c = 0; c < channelCount; ++c)
+            {
+                m_idle[c] = extractWindow(frame, bitSliced.get(), edgeList.get(), start, channels[c], input(c));
+            }
+            for (int pair = 0; pair < pairCount; ++pair)
+            {
+                analyzePair(pair, channelCount, out);
+            }
+        }
+    }
+
+private:
+    double *input(int c)
+    {
+        return m_input.data() + static_cast<size_t>(c) * m_windowSize;
+    }
+
+    // Duty-cycle based statistics for frames shorter than the window
+    void computeDutyCycleFallback(const CaptureFrame &frame, AnalysisLayout layout, const int *channels,
+                                  int channelCount, PhaseStats *out)
+    {
+        const double pi = 3.14159265358979323846;
+        const int N = static_cast<int>(frame.size());
+        for (int c = 0; c < channelCount; ++c)
+        {
+            const int channel = channels[c];
+            int highCount = 0;
+            if (layout == AnalysisLayout::BITSLICED)
+            {
+                highCount = static_cast<int>(frame.bitSliced()->countHigh(channel, 0, N));
+            }
+            else if (layout == AnalysisLayout::EDGES)
+            {
+                highCount = static_cast<int>(frame.edgeList()->countHigh(channel, 0, N));
+            }
+            else
+            {
+                const uint32_t *samples = frame.data();
+                for (int i = 0; i < N; ++i)
+                {
+                    if (((samples[i] >> channel) & 1) != 0)
+                        highCount++;
+                }
+            }
+
+            // Circular mean and variance calculation for binary signal
+            double sumSin = highCount * sin(pi) + (N - highCount) * sin(0);
+            double sumCos = highCount * cos(pi) + (N - highCount) * cos(0);
+            double R = sqrt(sumSin * sumSin + sumCos * sumCos) / N;
+            out[c].meanPhase = atan2(sumSin, sumCos);
+            out[c].phaseVariance = 1.0 - R;
+        }
+    }
+
+    // Work buffers for one channel pair
+    struct PairWorkspace
+    {
+        std::vector<std::complex<double>> spectrum; // Shared spectrum of the pair
+        std::vector<std::complex<double>> analytic; // Analytic signal of one channel
+    };
+
+    // Size the inputs and pair workspaces; only allocates when the batch grows
+    void reserve(int channelCount, int pairCount)
+    {
+        const size_t needed = static_cast<size_t>(channelCount) * m_windowSize;
+        if (m_input.size() < needed)
+        {
+            m_input.resize(needed);
+        }
+        if (static_cast<int>(m_idle.size()) < channelCount)
+        {
+            m_idle.resize(channelCount);
+        }
+        while (static_cast<int>(m_pairs.size()) < pairCount)
+        {
+            m_pairs.emplace_back();
+            m_pairs.back().spectrum.resize(m_windowSize);
+            m_pairs.back().analytic.resize(m_windowSize);
+        }
+    }
+
+    // Copy the last windowSize samples of a channel as 0/1, remove the DC
+    // offset and apply the window. Returns true when the channel does not
+    // change in the window, which leaves x all zero.
+    bool extractWindow(const CaptureFrame &frame, const BitSlicedFrame *bitSliced, const EdgeListFrame *edgeList,
+                       size_t start, int channel, double *x) const
+    {
+        TraceScope trace("extract window", "phase", "channel", channel);
+        int highCount = 0;
+        if (bitSliced)
+        {
+            bitSliced->extract(channel, start, m_windowSize, x);
+            highCount = static_cast<int>(bitSliced->countHigh(channel, start, start + m_windowSize));
+        }
+        else if (edgeList)
+        {
+            edgeList->extract(channel, start, m_windowSize, x);
+            highCount = static_cast<int>(edgeList->countHigh(channel, start, start + m_windowSize));
+        }
+        else
+        {
+            const uint32_t *samples = frame.data() + start;
+            for (int i = 0; i < m_windowSize; ++i)
+            {
+                const uint32_t bit = (samples[i] >> channel) & 1;
+                x[i] = bit ? 1.0 : 0.0;
+                highCount += static_cast<int>(bit);
+            }
+        }
+
+        // Remove DC offset which can dominate the transform
+        const double meanOffset = static_cast<double>(highCount) / m_windowSize;
+        for (int i = 0; i < m_windowSize; ++i)
+        {
+            x[i] = (x[i] - meanOffset) * m_window[i];
+        }
+        return highCount == 0 || highCount == m_windowSize;
+    }
+
+    // Forward transform of channels 2*pair and 2*pair+1 in one complex FFT,
+    // then the phase statistics of each
+    void analyzePair(int pair, int channelCount, PhaseStats *out)
+    {
+        TraceScope trace("phase pair", "phase", "pair", pair);
+        PairWorkspace &workspace = m_pairs[pair];
+        const int c = pair * 2;
+        const bool paired = c + 1 < channelCount;
+        const double *a = input(c);
+        const double *b = paired ? input(c + 1) : nullptr;
+        double energy = 0.0;
+        for (int i = 0; i < m_windowSize; ++i)
+        {
+            const double bi = paired ? b[i] : 0.0;
+            workspace.spectrum[i] = std::complex<double>(a[i], bi);
+            energy += a[i] * a[i] + bi * bi;
+        }
+        m_plan->transform(workspace.spectrum.data(), 1);
+
+        // Magnitudes below this, relative to the RMS of the pair's inputs, are
+        // rounding residue of the shared spectrum rather than signal and count
+        // as arg(0) == 0
+        const double noiseFloor = 1e-9 * sqrt(energy / m_windowSize);
+        out[c] = m_idle[c] ? PhaseStats() : analyzeSpectrum(workspace, 0, noiseFloor);
+        if (paired)
+        {
+            out[c + 1] = m_idle[c + 1] ? PhaseStats() : analyzeSpectrum(workspace, 1, noiseFloor);
+        }
+    }
+
+    // Separate channel `which` (0 = real part, 1 = imaginary part) from the
+    // shared spectrum, build its analytic signal and reduce it to phase stats
+    PhaseStats analyzeSpectrum(PairWorkspace &workspace, int which, double noiseFloor) const
+    {
+        const std::vector<std::complex<double>> &spectrum = workspace.spectrum;
+        std::vector<std::complex<double>> &analytic = workspace.analytic;
+        const int N = m_windowSize;
+        const int hw = N / 2;
+
+        // Hilbert transform in frequency domain:
+        // positive frequencies doubled, negative frequencies zeroed
+        for (int k = 0; k <= hw; ++k)
+        {
+            const std::complex<double> zk = spectrum[k];
+            const std::complex<double> zr = std::conj(spectrum[(N - k) % N]);
+            std::complex<double> xk = which == 0 ? 0.5 * (zk + zr)
+                                                 : std::complex<double>(0.0, -0.5) * (zk - zr);
+            if (k != 0 && k != hw)
+            {
+                xk *= 2.0;
+            }
+            analytic[k] = xk;
+        }
+        for (int k = hw + 1; k < N; ++k)
+        {
+            analytic[k] = 0.0;
+        }
+
+        m_plan->transform(analytic.data(), -1);
+
+        // sin/cos of the (unwrapped) phase come straight from the normalised
+        // analytic signal; unwrapping by 2 pi does not change them
+        double sumSin = 0.0, sumCos = 0.0;
+        for (int i = 0; i < N; ++i)
+        {
+            const double re = analytic[i].real();
+            const double im = analytic[i].imag();
+            const double magnitude = sqrt(re * re + im * im);
+            if (magnitude > noiseFloor)
+            {
+                sumSin += im / magnitude;
+                sumCos += re / magnitude;
+            }
+            else
+            {
+                sumCos += 1.0; // arg(0) == 0
+            }
+        }
+
+        PhaseStats stats;
+        stats.meanPhase = atan2(sumSin, sumCos);
+        const double R = sqrt(sumSin * sumSin + sumCos * sumCos) / N;
+        stats.phaseVariance = 1.0 - R;
+        return stats;
+    }
+
+    int m_windowSize;
+    std::shared_ptr<const FftPlan> m_plan;
+    std::vector<double> m_window;                    // Hamming coefficients
+    std::vector<double> m_input;                     // [channel][sample] windowed inputs
+    std::vector<PairWorkspace> m_pairs;              // One per channel pair
+    std::vector<char> m_idle;                        // Per channel: no change in the window
+};
@@ -0,0 +1,40 @@
+#pragma once
+// Replaced global operator new/delete that count heap allocations in
+// g_allocations. Each benchmark is a single translation unit, so this
+// header defines the replacements directly; include it once per program.
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<uint64_t> g_allocations(0);
+
+void *operator new(size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+// Kept out of line: GCC would otherwise inline free() into callers and pair
+// it with the operator new call (-Wmismatched-new-delete)
+#ifdef _MSC_VER
+__declspec(noinline)
+#else
+__attribute__((noinline))
+#endif
+void releaseCounted(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p) noexcept
+{
+    releaseCounted(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    releaseCounted(p);
+}
@@ -0,0 +1,347 @@
+// Microbenchmark: the per-frame analysis kernels and the output writers on
+// synthetic frames. Needs neither the device DLL nor main.cpp, so it runs
+// headless on Linux and can be tracked from build to build.
+//
+//   g++ -O2 -std=c++14 -I.. bench_kernels.cpp -o bench_kernels -pthread
+//   cl /O2 /EHsc /std:c++14 /I.. bench_kernels.cpp
+//
+//   bench_kernels [maxDepth] [minMs]
+//
+// Frames sweep depth from 1k samples up to maxDepth (default 32M, x32 per
+// step), 1/12/32 active channels and three edge densities (edges per sample
+// per active channel). For each frame:
+//   count packed      - TransitionCounter::count, the PACKED layout of processData
+//   bitslice          - BitSlicedFrame::fromSamples (the BITSLICED transpose)
+//   count bitsliced   - slice counting on the transposed frame
+//   edge list         - EdgeListFrame::fromSamples (the EDGES scan)
+//   count edges       - slice counting on the edge lists
+//   phase <layout>    - AnalyticSignalBatch::compute over up to 12 channels
+// Edge-list kernels are skipped when a frame would hold more than
+// MAX_EDGES edges. FFT plans and the four output writers of
+// output_writers.h (the ones main.cpp's exporter calls) are timed on their own.
+//
+// Columns: time per call, per input sample, input GB/s (output bytes for
+// the writers) and heap allocations per call, counted through a replaced
+// operator new.
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include "capture_frame.h"
+#include "transition_counter.h"
+#include "fft_engine.h"
+#include "analytic_signal.h"
+#include "live_state.h"
+#include "output_writers.h"
+#include "alloc_counter.h"
+
+typedef std::chrono::steady_clock Clock;
+
+enum
+{
+    SLICES = 5,            // main.cpp's default time slices
+    MAX_EDGES = 1 << 26,   // Edge-list kernels skip frames with more edges
+    MAX_FFT_SIZE = 1 << 22 // Larger plans take more memory than they tell
+};
+
+struct Result
+{
+    double nsPerCall;
+    double allocationsPerCall;
+};
+
+// Repeat body until at least minMs have passed, at least once
+template <typename Body>
+Result measure(int minMs, Body body)
+{
+    const uint64_t allocationsBefore = g_allocations.load();
+    const Clock::time_point start = Clock::now();
+    const Clock::time_point until = start + std::chrono::milliseconds(minMs);
+    uint64_t calls = 0;
+    Clock::time_point now;
+    do
+    {
+        body();
+        calls++;
+        now = Clock::now();
+    } while (now < until);
+    Result result;
+    result.nsPerCall = std::chrono::duration<double, std::nano>(now - start).count() / calls;
+    result.allocationsPerCall = static_cast<double>(g_allocations.load() - allocationsBefore) / calls;
+    return result;
+}
+
+std::string formatCount(uint64_t n)
+{
+    if (n >= (1u << 20) && n % (1u << 20) == 0)
+        return std::to_string(n >> 20) + "M";
+    if (n >= (1u << 10) && n % (1u << 10) == 0)
+        return std::to_string(n >> 10) + "k";
+    return std::to_string(n);
+}
+
+void printHeader(const char *section)
+{
+    std::cout << "\n" << section << "\n  " << std::left << std::setw(18) << "kernel" << std::right << std::setw(6)
+              << "depth" << std::setw(4) << "ch" << std::setw(8) << "density" << std::setw(14) << "ns/call"
+              << std::setw(11) << "ns/sample" << std::setw(9) << "GB/s" << std::setw(12) << "allocs/call" << "\n";
+}
+
+// samples = 0 prints no per-sample figure
+void printResult(const std::string &kernel, const std::string &depth, const std::string &channels,
+                 const std::string &density, const Result &result, uint64_t samples, uint64_t bytes)
+{
+    std::cout << "  " << std::left << std::setw(18) << kernel << std::right << std::setw(6) << depth << std::setw(4)
+              << channels << std::setw(8) << density << std::fixed << std::setprecision(0) << std::setw(14)
+              << result.nsPerCall << std::setprecision(3) << std::setw(11);
+    if (samples)
+        std::cout << result.nsPerCall / samples;
+    else
+        std::cout << "-";
+    std::cout << std::setprecision(2) << std::setw(9) << bytes / result.nsPerCall << std::setw(12)
+              << result.allocationsPerCall << "\n";
+}
+
+// xorshift64*, so every run sees the same frames
+class Random
+{
+public:
+    explicit Random(uint64_t seed) : m_state(seed ? seed : 1) {}
+
+    uint64_t next()
+    {
+        m_state ^= m_state >> 12;
+        m_state ^= m_state << 25;
+        m_state ^= m_state >> 27;
+        return m_state * 2685821657736338717ULL;
+    }
+
+    // Uniform in (0, 1]
+    double unit()
+    {
+        return (static_cast<double>(next() >> 11) + 1.0) / 9007199254740992.0;
+    }
+
+private:
+    uint64_t m_state;
+};
+
+// Channels [0, channels) start at a random level and each sample flips
+// them with probability density; the rest stay low
+std::shared_ptr<CaptureFrame> makeFrame(size_t depth, int channels, double density, uint64_t seed)
+{
+    std::shared_ptr<CaptureFrame> frame = CaptureFrame::create(depth);
+    uint32_t *samples = frame->mutableData();
+    Random random(seed);
+    const uint32_t activeMask = channels >= 32 ? ~0u : ((1u << channels) - 1);
+    samples[0] = static_cast<uint32_t>(random.next()) & activeMask;
+
+    // Mark the flips, with geometric gaps between them, then integrate
+    const double logStay = std::log(1.0 - density);
+    for (int ch = 0; ch < channels; ch++)
+    {
+        size_t position = 0;
+        while (true)
+        {
+            position += 1 + static_cast<size_t>(std::log(random.unit()) / logStay);
+            if (position >= depth)
+                break;
+            samples[position] ^= 1u << ch;
+        }
+    }
+    for (size_t i = 1; i < depth; i++)
+    {
+        samples[i] ^= samples[i - 1];
+    }
+    return frame;
+}
+
+// The writers take an open stream; like the exporter, open the file per call
+template <typename Write>
+void writeFile(const std::string &path, Write write)
+{
+    std::ofstream out(path);
+    write(out);
+}
+
+uint64_t fileSize(const std::string &path)
+{
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    return in ? static_cast<uint64_t>(in.tellg()) : 0;
+}
+
+int main(int argc, char *argv[])
+{
+    const uint64_t maxDepth = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : (32u << 20);
+    const int minMs = argc > 2 ? std::atoi(argv[2]) : 100;
+    std::cout << "AVX2: " << (cpu::hasAvx2() ? "yes" : "no") << " | max depth " << formatCount(maxDepth)
+              << " | " << minMs << " ms per kernel\n";
+
+    const int channelCounts[] = {1, 12, 32};
+    const double densities[] = {0.001, 0.05, 0.5};
+
+    printHeader("Frame kernels");
+    for (uint64_t depth = 1024; depth <= maxDepth; depth *= 32)
+    {
+        for (int channels : channelCounts)
+        {
+            for (double density : densities)
+            {
+                const std::shared_ptr<CaptureFrame> frame = makeFrame(static_cast<size_t>(depth), channels, density,
+                                                                      depth * 131 + channels * 7 + static_cast<uint64_t>(density * 1000));
+                const uint32_t *samples = frame->data();
+                const size_t n = frame->size();
+                const uint64_t bytes = depth * sizeof(uint32_t);
+                const std::string depthText = formatCount(depth);
+                const std::string channelText = std::to_string(channels);
+                std::ostringstream densityText;
+                densityText << density;
+                TransitionCounts counts;
+
+                auto row = [&](const char *kernel, const Result &result, uint64_t kernelSamples, uint64_t kernelBytes)
+                {
+                    printResult(kernel, depthText, channelText, densityText.str(), result, kernelSamples, kernelBytes);
+                };
+
+                row("count packed", measure(minMs, [&]
+                                            { TransitionCounter::count(samples, n, SLICES, counts); }),
+                    depth, bytes);
+
+                row("bitslice", measure(minMs, [&]
+                                        { BitSlicedFrame::fromSamples(samples, n); }),
+                    depth, bytes);
+                const std::shared_ptr<const BitSlicedFrame> bits = frame->bitSliced();
+                row("count bitsliced", measure(minMs, [&]
+                                               { bits->countTransitions(SLICES, counts); }),
+                    depth, bytes);
+
+                const bool edgesFit = static_cast<double>(depth) * channels * density <= MAX_EDGES;
+                if (edgesFit)
+                {
+                    row("edge list", measure(minMs, [&]
+                                             { EdgeListFrame::fromSamples(samples, n); }),
+                        depth, bytes);
+                    const std::shared_ptr<const EdgeListFrame> edges = frame->edgeList();
+                    row("count edges", measure(minMs, [&]
+                                               { edges->countTransitions(SLICES, counts); }),
+                        depth, edges->edgeCount() * sizeof(uint32_t));
+                }
+
+                // Phase analysis only reads the last window of each channel
+                const int phaseChannels = std::min<int>(channels, PHASE_CHANNELS);
+                int phaseList[PHASE_CHANNELS];
+                for (int c = 0; c < phaseChannels; c++)
+                    phaseList[c] = c;
+                PhaseStats phaseStats[PHASE_CHANNELS];
+                AnalyticSignalBatch batch;
+                const uint64_t window = std::min<uint64_t>(depth, static_cast<uint64_t>(batch.windowSize()));
+                const AnalysisLayout layouts[] = {AnalysisLayout::PACKED, AnalysisLayout::BITSLICED, AnalysisLayout::EDGES};
+                const char *layoutKernels[] = {"phase packed", "phase bitsliced", "phase edges"};
+                for (int l = 0; l < 3; l++)
+                {
+                    if (layouts[l] == AnalysisLayout::EDGES && !edgesFit)
+                        continue;
+                    batch.compute(*frame, layouts[l], phaseList, phaseChannels, phaseStats); // Size the workspaces
+                    row(layoutKernels[l], measure(minMs, [&]
+                                                  { batch.compute(*frame, layouts[l], phaseList, phaseChannels, phaseStats); }),
+                        window * phaseChannels, window * sizeof(uint32_t));
+                }
+            }
+        }
+    }
+
+    printHeader("FFT (one forward transform)");
+    for (uint64_t size = 1024; size <= std::min<uint64_t>(maxDepth, MAX_FFT_SIZE); size *= 4)
+    {
+        std::shared_ptr<const FftPlan> plan = FftPlanCache::get(static_cast<size_t>(size));
+        std::vector<std::complex<double>> buffer(static_cast<size_t>(size));
+        Random random(size);
+        for (std::complex<double> &x : buffer)
+            x = std::complex<double>(random.unit() - 0.5, 0.0);
+        const Result result = measure(minMs, [&]
+                                      { plan->transform(buffer.data(), 1); });
+        printResult("fft", formatCount(size), "-", "-", result, size, size * sizeof(std::complex<double>));
+    }
+
+    printHeader("Output writers (bytes written per call)");
+    LiveStateWriter liveState;
+    const int deviceCounts[] = {1, 4, 16};
+    for (int deviceCount : deviceCounts)
+    {
+        const auto now = std::chrono::system_clock::now();
+        std::vector<std::string> serialNumbers(deviceCount);
+        const std::string model = "Hantek 6254BD";
+        std::vector<std::string> channelNames(32);
+        for (int ch = 0; ch < 32; ch++)
+            channelNames[ch] = "Channel " + std::to_string(ch);
+        std::vector<ExportedDevice> devices(deviceCount);
+        Random random(deviceCount);
+        for (int d = 0; d < deviceCount; d++)
+        {
+            ExportedDevice &device = devices[d];
+            serialNumbers[d] = "SN" + std::to_string(100000 + d);
+            device.deviceIndex = d;
+            device.serialNumber = &serialNumbers[d];
+            device.model = &model;
+            DeviceSnapshot &state = device.state;
+            state.connected = true;
+            state.active = true;
+            state.capturesCount = 1000 + d;
+            state.sliceCount = SLICES;
+            state.lastCaptureTime = now;
+            for (int ch = 0; ch < 32; ch++)
+            {
+                ChannelSnapshot &channel = state.channels[ch];
+                channel.currentState = static_cast<uint32_t>(random.next() & 1);
+                channel.transitions = static_cast<int>(random.next() % 5000);
+                channel.totalTransitions = channel.transitions * 100;
+                channel.lastChangeTime = now - std::chrono::milliseconds(random.next() % 4000);
+                if (random.next() & 1)
+                    state.changedMask |= 1u << ch;
+            }
+            for (int ch = 0; ch < PHASE_CHANNELS; ch++)
+            {
+                ChannelSnapshot &channel = state.channels[ch];
+                for (int i = 0; i < SLICES; i++)
+                    channel.sliceActivityLevels[i] = random.unit() * 100.0;
+                channel.meanPhase = random.unit() * 6.28 - 3.14;
+                channel.phaseVariance = random.unit();
+            }
+        }
+
+        const std::string devicesText = std::to_string(deviceCount) + "dev";
+        const std::string paths[] = {"bench_logic_data.txt", "bench_phase_data.txt", "bench_time_sliced_data.txt",
+                                     "bench_live_state.bin"};
+        const Result results[] = {
+            measure(minMs, [&]
+                    { writeFile(paths[0], [&](std::ostream &out)
+                                { output_writers::writeLogicData(out, devices, channelNames, now); }); }),
+            measure(minMs, [&]
+                    { writeFile(paths[1], [&](std::ostream &out)
+                                { output_writers::writePhaseData(out, devices, channelNames, now); }); }),
+            measure(minMs, [&]
+                    { writeFile(paths[2], [&](std::ostream &out)
+                                { output_writers::writeTimeSlicedData(out, devices); }); }),
+            measure(minMs, [&]
+                    {
+                        output_writers::fillLiveState(liveState, devices, now);
+                        if (!liveState.commit(paths[3]))
+                            std::cerr << liveState.getLastError() << "\n";
+                    })};
+        const char *kernels[] = {"logic_data", "phase_data", "time_sliced_data", "live_state"};
+        for (int w = 0; w < 4; w++)
+        {
+            printResult(kernels[w], devicesText, "32", "-", results[w], 0, fileSize(paths[w]));
+            std::remove(paths[w].c_str());
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,242 @@
+// Microbenchmark: TaskScheduler against the mutex-queue ThreadPool it replaced.
+//
+//   g++ -O2 -std=c++14 -I.. bench_scheduler.cpp -o bench_scheduler -pthread
+//   cl /O2 /EHsc /std:c++14 /I.. bench_scheduler.cpp
+//
+//   bench_scheduler [threads] [frames]
+//
+// Three workloads:
+//   tiny tasks   - many empty closures submitted and joined (pure overhead)
+//   fan-out      - per frame, one FFT round trip per channel, joined per frame
+//                  (the shape of the phase analysis)
+//   phase batch  - AnalyticSignalBatch::compute inline and on the scheduler
+// Heap allocations per task are counted through a replaced operator new.
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <chrono>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include "task_scheduler.h"
+#include "analytic_signal.h"
+#include "alloc_counter.h"
+
+// The pool main.cpp used to carry, unchanged
+class ThreadPool {
+public:
+    ThreadPool(size_t threads) : stop(false) {
+        for(size_t i = 0; i < threads; ++i)
+            workers.emplace_back([this] {
+                for(;;) {
+                    std::function<void()> task;
+                    {
+                        std::unique_lock<std::mutex> lock(this->queue_mutex);
+                        this->condition.wait(lock, [this]{
+                            return this->stop || !this->tasks.empty();
+                        });
+                        if(this->stop && this->tasks.empty()) return;
+                        task = std::move(this->tasks.front());
+                        this->tasks.pop();
+                    }
+                    task();
+                }
+            });
+    }
+    template<class F, class... Args>
+    auto enqueue(F&& f, Args&&... args) -> std::future<decltype(f(args...))> {
+        using return_type = decltype(f(args...));
+        auto task = std::make_shared<std::packaged_task<return_type()>>(
+            std::bind(std::forward<F>(f), std::forward<Args>(args)...)
+        );
+        std::future<return_type> res = task->get_future();
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            if(stop) throw std::runtime_error("enqueue on stopped ThreadPool");
+            tasks.emplace([task](){ (*task)(); });
+        }
+        condition.notify_one();
+        return res;
+    }
+    ~ThreadPool() {
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            stop = true;
+        }
+        condition.notify_all();
+        for(std::thread &worker: workers)
+            worker.join();
+    }
+private:
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::mutex queue_mutex;
+    std::condition_variable condition;
+    bool stop;
+};
+
+typedef std::chrono::steady_clock Clock;
+
+struct Result
+{
+    double seconds;
+    double allocationsPerTask;
+};
+
+template <typename Body>
+Result measure(uint64_t tasks, Body body)
+{
+    const uint64_t allocationsBefore = g_allocations.load();
+    const Clock::time_point start = Clock::now();
+    body();
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    Result result;
+    result.seconds = seconds;
+    result.allocationsPerTask = static_cast<double>(g_allocations.load() - allocationsBefore) / tasks;
+    return result;
+}
+
+void printResult(const char *name, uint64_t tasks, const Result &result, double baselineSeconds)
+{
+    std::cout << "  " << std::left << std::setw(26) << name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(10) << result.seconds * 1e9 / tasks << " ns/task" << std::setprecision(2)
+              << std::setw(9) << result.allocationsPerTask << " allocs/task" << std::setw(8)
+              << baselineSeconds / result.seconds << "x\n";
+}
+
+// One forward and one inverse FFT, the bulk of a channel's phase analysis
+double channelKernel(const FftPlan &plan, std::vector<std::complex<double>> &buffer, int channel)
+{
+    for (size_t i = 0; i < buffer.size(); i++)
+    {
+        buffer[i] = std::complex<double>(((i >> (channel % 8)) & 1) ? 1.0 : -1.0, 0.0);
+    }
+    plan.transform(buffer.data(), 1);
+    plan.transform(buffer.data(), -1);
+    return buffer[1].real();
+}
+
+int main(int argc, char *argv[])
+{
+    const unsigned threads = argc > 1 ? static_cast<unsigned>(std::atoi(argv[1]))
+                                      : std::max(1u, std::thread::hardware_concurrency());
+    const int frames = argc > 2 ? std::atoi(argv[2]) : 2000;
+    std::cout << "Threads: " << threads << "\n";
+
+    ThreadPool pool(threads);
+    TaskScheduler scheduler(threads);
+
+    // Tiny tasks: submission and join overhead only
+    {
+        const int TASKS = 200000;
+        std::atomic<int> counter(0);
+        std::cout << "\nTiny tasks (" << TASKS << ")\n";
+        const Result poolResult = measure(TASKS, [&]
+                                          {
+            std::vector<std::future<void>> futures;
+            futures.reserve(TASKS);
+            for (int i = 0; i < TASKS; i++)
+                futures.push_back(pool.enqueue([&counter] { counter.fetch_add(1, std::memory_order_relaxed); }));
+            for (std::future<void> &future : futures)
+                future.get(); });
+        printResult("ThreadPool enqueue/get", TASKS, poolResult, poolResult.seconds);
+
+        const Result groupResult = measure(TASKS, [&]
+                                           {
+            TaskGroup group(scheduler);
+            for (int i = 0; i < TASKS; i++)
+                group.run([&counter] { counter.fetch_add(1, std::memory_order_relaxed); });
+            group.wait(); });
+        printResult("TaskScheduler TaskGroup", TASKS, groupResult, poolResult.seconds);
+    }
+
+    // Per-frame fan-out over the phase channels, joined every frame
+    {
+        const int CHANNELS = 12;
+        const size_t N = 2048;
+        std::shared_ptr<const FftPlan> plan = FftPlanCache::get(N);
+        std::vector<std::vector<std::complex<double>>> buffers(CHANNELS, std::vector<std::complex<double>>(N));
+        std::vector<double> results(CHANNELS);
+        const uint64_t tasks = static_cast<uint64_t>(frames) * CHANNELS;
+        std::cout << "\nFan-out (" << frames << " frames x " << CHANNELS << " channels, FFT " << N << ")\n";
+
+        const Result serialResult = measure(tasks, [&]
+                                            {
+            for (int f = 0; f < frames; f++)
+                for (int c = 0; c < CHANNELS; c++)
+                    results[c] = channelKernel(*plan, buffers[c], c); });
+        printResult("serial", tasks, serialResult, serialResult.seconds);
+
+        const Result poolResult = measure(tasks, [&]
+                                          {
+            std::vector<std::future<void>> futures(CHANNELS);
+            for (int f = 0; f < frames; f++)
+            {
+                for (int c = 0; c < CHANNELS; c++)
+                    futures[c] = pool.enqueue([&, c] { results[c] = channelKernel(*plan, buffers[c], c); });
+                for (std::future<void> &future : futures)
+                    future.get();
+            } });
+        printResult("ThreadPool enqueue/get", tasks, poolResult, serialResult.seconds);
+
+        const Result schedulerResult = measure(tasks, [&]
+                                               {
+            for (int f = 0; f < frames; f++)
+                scheduler.parallelFor(0, CHANNELS, [&](int c)
+                                      { results[c] = channelKernel(*plan, buffers[c], c); }); });
+        printResult("TaskScheduler parallelFor", tasks, schedulerResult, serialResult.seconds);
+    }
+
+    // The real phase analysis on a synthetic frame
+    {
+        const int CHANNELS = 12;
+        std::shared_ptr<CaptureFrame> frame = CaptureFrame::create(65536);
+        uint32_t state = 0x12345678;
+        for (size_t i = 0; i < frame->size(); i++)
+        {
+            state = state * 1664525u + 1013904223u;
+            frame->mutableData()[i] = state;
+        }
+        int channels[CHANNELS];
+        for (int c = 0; c < CHANNELS; c++)
+            channels[c] = c;
+        PhaseStats inlineStats[CHANNELS];
+        PhaseStats scheduledStats[CHANNELS];
+        AnalyticSignalBatch batch;
+        batch.compute(*frame, AnalysisLayout::PACKED, channels, CHANNELS, inlineStats); // Size the workspaces
+
+        const uint64_t tasks = static_cast<uint64_t>(frames) * CHANNELS;
+        std::cout << "\nPhase batch (" << frames << " frames x " << CHANNELS << " channels)\n";
+        const Result inlineResult = measure(tasks, [&]
+                                            {
+            for (int f = 0; f < frames; f++)
+                batch.compute(*frame, AnalysisLayout::PACKED, channels, CHANNELS, inlineStats); });
+        printResult("inline", tasks, inlineResult, inlineResult.seconds);
+
+        const Result scheduledResult = measure(tasks, [&]
+                                               {
+            for (int f = 0; f < frames; f++)
+                batch.compute(*frame, AnalysisLayout::PACKED, channels, CHANNELS, scheduledStats, &scheduler); });
+        printResult("TaskScheduler", tasks, scheduledResult, inlineResult.seconds);
+
+        double maxDifference = 0.0;
+        for (int c = 0; c < CHANNELS; c++)
+        {
+            maxDifference = std::max(maxDifference, std::abs(inlineStats[c].meanPhase - scheduledStats[c].meanPhase));
+            maxDifference = std::max(maxDifference, std::abs(inlineStats[c].phaseVariance - scheduledStats[c].phaseVariance));
+        }
+        std::cout << "  max difference inline vs scheduled: " << std::scientific << maxDifference << "\n";
+    }
+
+    const TaskScheduler::Stats stats = scheduler.stats();
+    std::cout << "\nScheduler: " << stats.executed << " tasks run by workers, " << stats.stolen << " stolen, "
+              << stats.inlined << " inline\n";
+    return 0;
+}
@@ -0,0 +1,397 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include "cpu_features.h"
+#include "transition_counter.h"
+
+// Bit-sliced (transposed) view of a capture frame.
+// Each of the 32 channels is stored as its own packed bitstream of 64-bit words
+// (bit i of word k is sample 64 * k + i), so per-channel analytics become
+// popcount and word operations instead of one shift per sample.
+class BitSlicedFrame
+{
+public:
+    static std::shared_ptr<const BitSlicedFrame> fromSamples(const uint32_t *samples, size_t sampleCount)
+    {
+        std::shared_ptr<BitSlicedFrame> frame(new BitSlicedFrame(sampleCount));
+        if (cpu::hasAvx2())
+        {
+            frame->transposeAvx2(samples);
+        }
+        else
+        {
+            frame->transposeScalar(samples);
+        }
+        return frame;
+    }
+
+    size_t size() const
+    {
+        return m_sampleCount;
+    }
+
+    size_t wordCount() const
+    {
+        return m_wordCount;
+    }
+
+    // Packed bitstream of one channel, wordCount() words long
+    const uint64_t *channel(int ch) const
+    {
+        return m_bits.data() + static_cast<size_t>(ch) * m_wordCount;
+    }
+
+    bool bit(int ch, size_t index) const
+    {
+        return ((channel(ch)[index >> 6] >> (index & 63)) & 1) != 0;
+    }
+
+    // Number of samples in [begin, end) where the channel is high
+    size_t countHigh(int ch, size_t begin, size_t end) const
+    {
+        if (end > m_sampleCount)
+            end = m_sampleCount;
+        if (begin >= end)
+            return 0;
+
+        const uint64_t *words = channel(ch);
+        const size_t first = begin >> 6;
+        const size_t last = (end - 1) >> 6;
+        size_t count = 0;
+        for (size_t k = first; k <= last; k++)
+        {
+            count += cpu::popcount64(words[k] & rangeMask(k, begin, end));
+        }
+        return count;
+    }
+
+    // Number of edges between sample i - 1 and sample i for i in (begin, end),
+    // i.e. the edges strictly inside [begin, end)
+    size_t countTransitions(int ch, size_t begin, size_t end) const
+    {
+        if (end > m_sampleCount)
+            end = m_sampleCount;
+        if (begin + 1 >= end)
+            return 0;
+
+        const uint64_t *words = channel(ch);
+        const size_t edgeBegin = begin + 1;
+        const size_t first = edgeBegin >> 6;
+        const size_t last = (end - 1) >> 6;
+        size_t count = 0;
+        for (size_t k = first; k <= last; k++)
+        {
+            count += cpu::popcount64(edgeWord(words, k) & rangeMask(k, edgeBegin, end));
+        }
+        return count;
+    }
+
+    // Same result as TransitionCounter::count, computed from the channel bitstreams
+    void countTransitions(int numSlices, TransitionCounts &out) const
+    {
+        if (numSlices < 1)
+            numSlices = 1;
+
+        out.transitions.fill(0);
+        out.sliceTransitions.resize(numSlices);
+        out.firstWord = out.lastWord = 0;
+        if (m_sampleCount == 0)
+        {
+            for (auto &slice : out.sliceTransitions)
+            {
+                slice.fill(0);
+            }
+            return;
+        }
+
+        const size_t samplesPerSlice = m_sampleCount / numSlices;
+        for (int ch = 0; ch < 32; ch++)
+        {
+            out.firstWord |= static_cast<uint32_t>(bit(ch, 0)) << ch;
+            out.lastWord |= static_cast<uint32_t>(bit(ch, m_sampleCount - 1)) << ch;
+            uint32_t total = 0;
+            for (int slice = 0; slice < numSlices; slice++)
+            {
+                size_t start = slice * samplesPerSlice;
+                size_t end = (slice == numSlices - 1) ? m_sampleCount : (slice + 1) * samplesPerSlice;
+                const uint32_t inside = static_cast<uint32_t>(countTransitions(ch, start, end));
+                out.sliceTransitions[slice][ch] = inside;
+                total += inside;
+
+                // The edge into a slice only counts toward the frame total
+                if (start >= 1 && bit(ch, start) != bit(ch, start - 1))
+                    total++;
+            }
+            out.transitions[ch] = total;
+        }
+    }
+
+    // Write samples [begin, begin + count) of one channel as 0.0/1.0
+    void extract(int ch, size_t begin, size_t count, double *out) const
+    {
+        const uint64_t *words = channel(ch);
+        for (size_t i = 0; i < count; i++)
+        {
+            const size_t index = begin + i;
+            out[i] = ((words[index >> 6] >> (index & 63)) & 1) ? 1.0 : 0.0;
+        }
+    }
+
+    // Inverse of fromSamples: rebuild one 32-channel word per sample from 32
+    // channel bitstreams laid out wordCount words apart
+    static void packSamples(const uint64_t *channelBits, size_t wordCount, size_t sampleCount, uint32_t *samples)
+    {
+        size_t done = 0;
+        if (cpu::hasAvx2())
+        {
+            done = packSamplesAvx2(channelBits, wordCount, sampleCount, samples);
+        }
+        packSamplesScalar(channelBits, wordCount, done, sampleCount, samples);
+    }
+
+private:
+    explicit BitSlicedFrame(size_t sampleCount)
+        : m_sampleCount(sampleCount), m_wordCount((sampleCount + 63) / 64),
+          m_bits(32 * ((sampleCount + 63) / 64), 0)
+    {
+    }
+
+    // In-place transpose of a 32x32 bit matrix: bit c of row r moves to bit r of row c
+    static void transpose32(uint32_t *rows)
+    {
+        uint32_t mask = 0x0000FFFF;
+        for (int j = 16; j != 0; j >>= 1, mask ^= (mask << j))
+        {
+            for (int k = 0; k < 32; k = ((k | j) + 1) & ~j)
+            {
+                const uint32_t t = ((rows[k] >> j) ^ rows[k | j]) & mask;
+                rows[k] ^= t << j;
+                rows[k | j] ^= t;
+            }
+        }
+    }
+
+    // Bits of word k that fall inside [begin, end)
+    static uint64_t rangeMask(size_t k, size_t begin, size_t end)
+    {
+        const size_t wordStart = k << 6;
+        uint64_t mask = ~0ULL;
+        if (begin > wordStart)
+            mask &= ~0ULL << (begin - wordStart);
+        if (end < wordStart + 64)
+            mask &= ~0ULL >> (wordStart + 64 - end);
+        return mask;
+    }
+
+    // Bit i of the result is sample (64k + i) XOR sample (64k + i - 1)
+    static uint64_t edgeWord(const uint64_t *words, size_t k)
+    {
+        const uint64_t carry = k > 0 ? (words[k - 1] >> 63) : (words[0] & 1);
+        return words[k] ^ ((words[k] << 1) | carry);
+    }
+
+    // Copy up to 32 samples starting at offset, padding past the end with zeros
+    void loadBlock(const uint32_t *samples, size_t offset, uint32_t *block) const
+    {
+        for (size_t i = 0; i < 32; i++)
+        {
+            block[i] = (offset + i < m_sampleCount) ? samples[offset + i] : 0;
+        }
+    }
+
+    // Channel words are produced a tile at a time and then copied out as
+    // contiguous runs; writing 32 streams spaced a whole frame apart directly
+    // would alias in the cache.
+    static const size_t TILE_WORDS = 64;
+
+    void storeTile(const uint64_t *tile, size_t firstWord, size_t words)
+    {
+        for (int ch = 0; ch < 32; ch++)
+        {
+            uint64_t *dst = m_bits.data() + ch * m_wordCount + firstWord;
+            for (size_t k = 0; k < words; k++)
+            {
+                dst[k] = tile[ch * TILE_WORDS + k];
+            }
+        }
+    }
+
+    // Packs samples [first, sampleCount), first a multiple of 32
+    static void packSamplesScalar(const uint64_t *channelBits, size_t wordCount, size_t first,
+                                  size_t sampleCount, uint32_t *samples)
+    {
+        uint32_t rows[32];
+        for (size_t block = first / 32; block * 32 < sampleCount; block++)
+        {
+            const int shift = (block & 1) ? 32 : 0;
+            for (int ch = 0; ch < 32; ch++)
+            {
+                rows[ch] = static_cast<uint32_t>(channelBits[ch * wordCount + block / 2] >> shift);
+            }
+            transpose32(rows);
+            const size_t count = std::min<size_t>(32, sampleCount - block * 32);
+            std::copy(rows, rows + count, samples + block * 32);
+        }
+    }
+
+    void transposeScalar(const uint32_t *samples)
+    {
+        uint32_t low[32];
+        uint32_t high[32];
+        std::vector<uint64_t> tile(32 * TILE_WORDS);
+        for (size_t first = 0; first < m_wordCount; first += TILE_WORDS)
+        {
+            const size_t words = std::min(TILE_WORDS, m_wordCount - first);
+            for (size_t k = 0; k < words; k++)
+            {
+                const size_t offset = (first + k) * 64;
+                loadBlock(samples, offset, low);
+                loadBlock(samples, offset + 32, high);
+                transpose32(low);
+                transpose32(high);
+                for (int ch = 0; ch < 32; ch++)
+                {
+                    tile[ch * TILE_WORDS + k] = static_cast<uint64_t>(low[ch]) |
+                                                (static_cast<uint64_t>(high[ch]) << 32);
+                }
+            }
+            storeTile(tile.data(), first, words);
+        }
+    }
+
+#ifdef LA_HAVE_X86
+    // Gather byte b of 32 consecutive samples into vector b, then read each
+    // bit-plane out with movemask (32 samples of one channel per instruction).
+    LA_TARGET_AVX2 static void transposeBlockAvx2(const uint32_t *block, uint32_t *channels)
+    {
+        const __m256i groupBytes = _mm256_setr_epi8(
+            0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15,
+            0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+        const __m256i interleave = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+        __m256i p[4];
+        for (int v = 0; v < 4; v++)
+        {
+            const __m256i words = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block + 8 * v));
+            p[v] = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(words, groupBytes), interleave);
+        }
+
+        const __m256i lo01 = _mm256_unpacklo_epi64(p[0], p[1]);
+        const __m256i hi01 = _mm256_unpackhi_epi64(p[0], p[1]);
+        const __m256i lo23 = _mm256_unpacklo_epi64(p[2], p[3]);
+        const __m256i hi23 = _mm256_unpackhi_epi64(p[2], p[3]);
+
+        __m256i bytes[4];
+        bytes[0] = _mm256_permute2x128_si256(lo01, lo23, 0x20);
+        bytes[1] = _mm256_permute2x128_si256(hi01, hi23, 0x20);
+        bytes[2] = _mm256_permute2x128_si256(lo01, lo23, 0x31);
+        bytes[3] = _mm256_permute2x128_si256(hi01, hi23, 0x31);
+
+        for (int b = 0; b < 4; b++)
+        {
+            __m256i plane = bytes[b];
+            for (int t = 7; t >= 0; t--)
+            {
+                channels[8 * b + t] = static_cast<uint32_t>(_mm256_movemask_epi8(plane));
+                plane = _mm256_add_epi8(plane, plane);
+            }
+        }
+    }
+
+    LA_TARGET_AVX2 void transposeAvx2(const uint32_t *samples)
+    {
+        uint32_t low[32];
+        uint32_t high[32];
+        uint32_t padded[32];
+        std::vector<uint64_t> tile(32 * TILE_WORDS);
+        for (size_t first = 0; first < m_wordCount; first += TILE_WORDS)
+        {
+            const size_t words = std::min(TILE_WORDS, m_wordCount - first);
+            for (size_t k = 0; k < words; k++)
+            {
+                const size_t offset = (first + k) * 64;
+                if (offset + 64 <= m_sampleCount)
+                {
+                    transposeBlockAvx2(samples + offset, low);
+                    transposeBlockAvx2(samples + offset + 32, high);
+                }
+                else
+                {
+                    loadBlock(samples, offset, padded);
+                    transposeBlockAvx2(padded, low);
+                    loadBlock(samples, offset + 32, padded);
+                    transposeBlockAvx2(padded, high);
+                }
+                for (int ch = 0; ch < 32; ch++)
+                {
+                    tile[ch * TILE_WORDS + k] = static_cast<uint64_t>(low[ch]) |
+                                                (static_cast<uint64_t>(high[ch]) << 32);
+                }
+            }
+            storeTile(tile.data(), first, words);
+        }
+    }
+    // transpose32 on eight 32-sample blocks at once, one per 32-bit lane;
+    // returns how many samples were packed (whole groups of 256)
+    LA_TARGET_AVX2 static size_t packSamplesAvx2(const uint64_t *channelBits, size_t wordCount,
+                                                 size_t sampleCount, uint32_t *samples)
+    {
+        const size_t groups = sampleCount / 256;
+        __m256i rows[32];
+        alignas(32) uint32_t lanes[32][8];
+        for (size_t g = 0; g < groups; g++)
+        {
+            for (int ch = 0; ch < 32; ch++)
+            {
+                rows[ch] = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(channelBits + ch * wordCount + 4 * g));
+            }
+
+            uint32_t mask = 0x0000FFFF;
+            for (int j = 16; j != 0; j >>= 1, mask ^= (mask << j))
+            {
+                const __m256i m = _mm256_set1_epi32(static_cast<int>(mask));
+                const __m128i count = _mm_cvtsi32_si128(j);
+                for (int k = 0; k < 32; k = ((k | j) + 1) & ~j)
+                {
+                    const __m256i t = _mm256_and_si256(
+                        _mm256_xor_si256(_mm256_srl_epi32(rows[k], count), rows[k | j]), m);
+                    rows[k] = _mm256_xor_si256(rows[k], _mm256_sll_epi32(t, count));
+                    rows[k | j] = _mm256_xor_si256(rows[k | j], t);
+                }
+            }
+
+            // Lane i of row s is sample 32 * i + s of the group
+            for (int s = 0; s < 32; s++)
+            {
+                _mm256_store_si256(reinterpret_cast<__m256i *>(lanes[s]), rows[s]);
+            }
+            uint32_t *out = samples + 256 * g;
+            for (int i = 0; i < 8; i++)
+            {
+                for (int s = 0; s < 32; s++)
+                {
+                    out[32 * i + s] = lanes[s][i];
+                }
+            }
+        }
+        return groups * 256;
+    }
+#else
+    void transposeAvx2(const uint32_t *samples)
+    {
+        transposeScalar(samples);
+    }
+
+    static size_t packSamplesAvx2(const uint64_t *, size_t, size_t, uint32_t *)
+    {
+        return 0;
+    }
+#endif
+
+    size_t m_sampleCount;
+    size_t m_wordCount;
+    std::vector<uint64_t> m_bits; // Channel-major: channel c occupies [c * wordCount, (c + 1) * wordCount)
+};
@@ -0,0 +1,655 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <deque>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
+#include "capture_frame.h"
+#include "capture_backend.h"
+
+// Compressed long-term archive of raw captures, one pair of files per device:
+//
+//   device_N.laarc  ArchiveFileHeader, then one chunk per frame:
+//                   ArchiveChunkHeader
+//                   uint32_t streamEnd[channelCount]  end of each channel's stream in the payload
+//                   payload: the channel streams back to back
+//   device_N.laidx  ArchiveIndexHeader, then one ArchiveIndexEntry per chunk
+//
+// A channel stream is the frame's EdgeListFrame entry as LEB128 varints:
+//   initial level (0/1), edge count, then each edge position as the distance
+//   from the previous edge (the first from sample 0)
+// where an edge at position i means sample i differs from sample i-1. Sparse
+// digital signals shrink to a few bytes per edge instead of 4 bytes per sample.
+//
+// The index holds the time span and file offset of every chunk, so a time
+// range is found by binary search and one channel of a chunk is read without
+// touching the others. Index entries are written after their chunk, so the
+// index never points at a partial chunk; a missing index is rebuilt by
+// scanning the chunk headers.
+struct ArchiveFileHeader
+{
+    char magic[8];         // "LAARCHIV"
+    uint32_t version;      // ARCHIVE_VERSION
+    uint32_t deviceIndex;
+    int64_t startTimeNs;   // Wall clock when archiving started (ns since the epoch)
+    char serialNumber[32];
+    char model[32];
+};
+
+struct ArchiveChunkHeader
+{
+    uint32_t magic;          // ARCHIVE_CHUNK_MAGIC
+    uint32_t channelCount;   // Entries in the stream table
+    uint64_t sequence;       // Device frame counter
+    int64_t startTimeNs;     // Wall clock of the first sample (ns since the epoch)
+    uint64_t sampleCount;
+    uint32_t sampleRateHz;   // Sample spacing within the chunk
+    uint16_t sampleRateCode; // Set_Sample_Rate code the frame was captured with
+    uint16_t reserved;
+    uint32_t payloadBytes;
+    uint32_t reserved2;
+};
+
+struct ArchiveIndexHeader
+{
+    char magic[8]; // "LAARCIDX"
+    uint32_t version;
+    uint32_t entrySize;
+};
+
+struct ArchiveIndexEntry
+{
+    int64_t startTimeNs; // First sample
+    int64_t endTimeNs;   // One sample period past the last sample
+    uint64_t sequence;
+    uint64_t chunkOffset; // Of the ArchiveChunkHeader in the .laarc file
+    uint32_t chunkBytes;  // Header, stream table and payload
+    uint32_t reserved;
+};
+
+static_assert(sizeof(ArchiveChunkHeader) == 48, "archive layout");
+static_assert(sizeof(ArchiveIndexEntry) == 40, "archive layout");
+
+const uint32_t ARCHIVE_VERSION = 1;
+const uint32_t ARCHIVE_CHUNK_MAGIC = 0x4B484341; // "ACHK"
+const uint32_t ARCHIVE_CHANNELS = 32;
+
+inline std::string archiveFilePath(const std::string &directory, int deviceIndex)
+{
+    return directory + "/device_" + std::to_string(deviceIndex) + ".laarc";
+}
+
+inline std::string archiveIndexPath(const std::string &archivePath)
+{
+    return archivePath.substr(0, archivePath.size() - 6) + ".laidx";
+}
+
+// One channel of one chunk, decoded to its edges
+struct ArchiveChannelEdges
+{
+    int initialLevel = 0;
+    uint64_t sampleCount = 0;
+    std::vector<uint32_t> edges; // Sample positions where the level flips
+
+    // Level of every sample, 0/1
+    void expand(std::vector<uint8_t> &levels) const
+    {
+        levels.resize(static_cast<size_t>(sampleCount));
+        uint8_t level = static_cast<uint8_t>(initialLevel);
+        size_t position = 0;
+        for (uint32_t edge : edges)
+        {
+            std::fill(levels.begin() + position, levels.begin() + edge, level);
+            position = edge;
+            level ^= 1;
+        }
+        std::fill(levels.begin() + position, levels.end(), level);
+    }
+};
+
+// Edge-delta encoding of the 32 channels of a frame
+class ArchiveEncoder
+{
+public:
+    // Encode a frame's edge lists into payload; streamEnd receives the end
+    // offset of each channel's stream
+    static void encode(const EdgeListFrame &frame, std::vector<uint8_t> &payload, uint32_t streamEnd[ARCHIVE_CHANNELS])
+    {
+        payload.clear();
+        for (uint32_t ch = 0; ch < ARCHIVE_CHANNELS; ch++)
+        {
+            const std::vector<uint32_t> &edges = frame.edges(static_cast<int>(ch));
+            putVarint(payload, static_cast<uint64_t>(frame.initialLevel(static_cast<int>(ch))));
+            putVarint(payload, edges.size());
+            uint32_t previous = 0;
+            for (uint32_t edge : edges)
+            {
+                putVarint(payload, edge - previous);
+                previous = edge;
+            }
+            streamEnd[ch] = static_cast<uint32_t>(payload.size());
+        }
+    }
+
+    static bool decode(const uint8_t *stream, size_t size, uint64_t sampleCount, ArchiveChannelEdges &out)
+    {
+        size_t position = 0;
+        uint64_t level = 0, edgeCount = 0;
+        if (!getVarint(stream, size, position, level) || !getVarint(stream, size, position, edgeCount) ||
+            edgeCount > sampleCount)
+        {
+            return false;
+        }
+        out.initialLevel = static_cast<int>(level & 1);
+        out.sampleCount = sampleCount;
+        out.edges.resize(static_cast<size_t>(edgeCount));
+        uint64_t edge = 0;
+        for (uint64_t i = 0; i < edgeCount; i++)
+        {
+            uint64_t delta = 0;
+            if (!getVarint(stream, size, position, delta))
+                return false;
+            edge += delta;
+            if (edge >= sampleCount)
+                return false;
+            out.edges[static_cast<size_t>(i)] = static_cast<uint32_t>(edge);
+        }
+        return true;
+    }
+
+private:
+    static void putVarint(std::vector<uint8_t> &out, uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            out.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    static bool getVarint(const uint8_t *data, size_t size, size_t &position, uint64_t &value)
+    {
+        value = 0;
+        for (int shift = 0; shift < 64 && position < size; shift += 7)
+        {
+            const uint8_t byte = data[position++];
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0)
+                return true;
+        }
+        return false;
+    }
+};
+
+// Archives one device's frames on a background thread. At most MAX_PENDING
+// frames wait for the writer; beyond that frames are dropped (and counted)
+// rather than stalling the capture loop, so memory stays bounded even when
+// the disk falls behind.
+class CaptureArchiver
+{
+public:
+    enum
+    {
+        MAX_PENDING = 8
+    };
+
+    CaptureArchiver()
+        : m_open(false), m_stopping(false), m_failed(false), m_frames(0), m_dropped(0), m_rawBytes(0), m_bytes(0) {}
+
+    ~CaptureArchiver()
+    {
+        close();
+    }
+
+    bool open(const std::string &path, int deviceIndex, const std::string &serialNumber, const std::string &model)
+    {
+        close();
+        m_file.open(path, std::ios::binary | std::ios::trunc);
+        m_index.open(archiveIndexPath(path), std::ios::binary | std::ios::trunc);
+        if (!m_file.is_open() || !m_index.is_open())
+        {
+            m_lastError = "Cannot create archive " + path;
+            m_file.close();
+            m_index.close();
+            return false;
+        }
+
+        ArchiveFileHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, "LAARCHIV", sizeof(header.magic));
+        header.version = ARCHIVE_VERSION;
+        header.deviceIndex = static_cast<uint32_t>(deviceIndex);
+        header.startTimeNs = toNanoseconds(std::chrono::system_clock::now().time_since_epoch());
+        std::strncpy(header.serialNumber, serialNumber.c_str(), sizeof(header.serialNumber) - 1);
+        std::strncpy(header.model, model.c_str(), sizeof(header.model) - 1);
+        m_file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+        ArchiveIndexHeader indexHeader;
+        std::memcpy(indexHeader.magic, "LAARCIDX", sizeof(indexHeader.magic));
+        indexHeader.version = ARCHIVE_VERSION;
+        indexHeader.entrySize = sizeof(ArchiveIndexEntry);
+        m_index.write(reinterpret_cast<const char *>(&indexHeader), sizeof(indexHeader));
+        m_index.flush();
+        if (!m_file || !m_index)
+        {
+            m_lastError = "Cannot write archive header to " + path;
+            m_file.close();
+            m_index.close();
+            return false;
+        }
+
+        m_path = path;
+        m_offset = sizeof(header);
+        m_stopping = false;
+        m_failed = false;
+        m_frames = 0;
+        m_dropped = 0;
+        m_rawBytes = 0;
+        m_bytes = sizeof(header);
+        m_open = true;
+        m_writer = std::thread(&CaptureArchiver::writerLoop, this);
+        return true;
+    }
+
+    // Queue a frame; never blocks. false once the writer has failed.
+    bool submit(const CaptureFramePtr &frame)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_failed || !m_open)
+        {
+            return false;
+        }
+        if (m_pending.size() >= MAX_PENDING)
+        {
+            m_dropped++;
+            return true;
+        }
+        m_pending.push_back(frame);
+        m_ready.notify_one();
+        return true;
+    }
+
+    // Write out everything queued and close the files
+    void close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_open)
+            {
+                return;
+            }
+            m_stopping = true;
+        }
+        m_ready.notify_one();
+        if (m_writer.joinable())
+        {
+            m_writer.join();
+        }
+        m_file.close();
+        m_index.close();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_open = false;
+    }
+
+    bool isOpen() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_open;
+    }
+
+    uint64_t framesWritten() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_frames;
+    }
+
+    uint64_t framesDropped() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_dropped;
+    }
+
+    // Size the archived frames would have had as raw samples
+    uint64_t rawBytes() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_rawBytes;
+    }
+
+    uint64_t bytesWritten() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_bytes;
+    }
+
+    const std::string &path() const
+    {
+        return m_path;
+    }
+
+    std::string getLastError() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_lastError;
+    }
+
+private:
+    template <typename Duration>
+    static int64_t toNanoseconds(Duration duration)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    }
+
+    void writerLoop()
+    {
+        std::vector<uint8_t> payload;
+        uint32_t streamEnd[ARCHIVE_CHANNELS];
+        while (true)
+        {
+            CaptureFramePtr frame;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_ready.wait(lock, [this]
+                             { return m_stopping || !m_pending.empty(); });
+                if (m_pending.empty())
+                {
+                    return;
+                }
+                frame = m_pending.front();
+                m_pending.pop_front();
+            }
+
+            // Shares the edge lists with the analysis when it runs in the edges layout
+            ArchiveEncoder::encode(*frame->edgeList(), payload, streamEnd);
+
+            // captureTime is when the samples were read, i.e. the end of the capture
+            const uint32_t rateHz = static_cast<uint32_t>(sampleRateFromCode(frame->sampleRateCode));
+            const int64_t durationNs = rateHz ? static_cast<int64_t>(frame->size() * 1000000000.0 / rateHz) : 0;
+            const int64_t endTimeNs = toNanoseconds(frame->captureTime.time_since_epoch());
+
+            ArchiveChunkHeader header;
+            std::memset(&header, 0, sizeof(header));
+            header.magic = ARCHIVE_CHUNK_MAGIC;
+            header.channelCount = ARCHIVE_CHANNELS;
+            header.sequence = frame->sequence;
+            header.startTimeNs = endTimeNs - durationNs;
+            header.sampleCount = frame->size();
+            header.sampleRateHz = rateHz;
+            header.sampleRateCode = frame->sampleRateCode;
+            header.payloadBytes = static_cast<uint32_t>(payload.size());
+            const uint64_t rawBytes = frame->size() * sizeof(uint32_t);
+            frame.reset(); // Hand a pooled buffer back before writing
+
+            ArchiveIndexEntry entry;
+            std::memset(&entry, 0, sizeof(entry));
+            entry.startTimeNs = header.startTimeNs;
+            entry.endTimeNs = endTimeNs;
+            entry.sequence = header.sequence;
+            entry.chunkOffset = m_offset;
+            entry.chunkBytes = static_cast<uint32_t>(sizeof(header) + sizeof(streamEnd) + payload.size());
+
+            m_file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            m_file.write(reinterpret_cast<const char *>(streamEnd), sizeof(streamEnd));
+            m_file.write(reinterpret_cast<const char *>(payload.data()), static_cast<std::streamsize>(payload.size()));
+            m_file.flush();
+            m_index.write(reinterpret_cast<const char *>(&entry), sizeof(entry));
+            m_index.flush();
+            m_offset += entry.chunkBytes;
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_file || !m_index)
+            {
+                m_lastError = "Write to " + m_path + " failed";
+                m_failed = true;
+                m_pending.clear();
+                return;
+            }
+            m_frames++;
+            m_rawBytes += rawBytes;
+            m_bytes += entry.chunkBytes + sizeof(entry);
+        }
+    }
+
+    std::ofstream m_file;
+    std::ofstream m_index;
+    std::string m_path;
+    std::string m_lastError;
+    uint64_t m_offset = 0; // Writer thread only
+    std::thread m_writer;
+    std::deque<CaptureFramePtr> m_pending;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_ready;
+    bool m_open;
+    bool m_stopping;
+    bool m_failed;
+    uint64_t m_frames;
+    uint64_t m_dropped;
+    uint64_t m_rawBytes;
+    uint64_t m_bytes;
+};
+
+// Random-access reader for an archive: find chunks by time, then decode
+// single channels (or whole frames) of them
+class CaptureArchiveReader
+{
+public:
+    bool open(const std::string &path)
+    {
+        m_file.close();
+        m_file.clear();
+        m_entries.clear();
+        m_file.open(path, std::ios::binary);
+        if (!m_file.is_open())
+        {
+            m_lastError = "Cannot open archive " + path;
+            return false;
+        }
+        m_file.read(reinterpret_cast<char *>(&m_header), sizeof(m_header));
+        if (!m_file || std::memcmp(m_header.magic, "LAARCHIV", sizeof(m_header.magic)) != 0)
+        {
+            m_lastError = path + " is not a capture archive";
+            return false;
+        }
+        if (m_header.version != ARCHIVE_VERSION)
+        {
+            m_lastError = "Unsupported archive version " + std::to_string(m_header.version);
+            return false;
+        }
+        if (!loadIndex(archiveIndexPath(path)))
+        {
+            rebuildIndex();
+        }
+        return true;
+    }
+
+    const ArchiveFileHeader &header() const
+    {
+        return m_header;
+    }
+
+    size_t chunkCount() const
+    {
+        return m_entries.size();
+    }
+
+    const ArchiveIndexEntry &chunk(size_t index) const
+    {
+        return m_entries[index];
+    }
+
+    // Chunks overlapping [startNs, endNs), in time order
+    void findChunks(int64_t startNs, int64_t endNs, std::vector<size_t> &out) const
+    {
+        out.clear();
+        // First chunk that ends after startNs; chunks are written in time order
+        size_t first = std::partition_point(m_entries.begin(), m_entries.end(), [startNs](const ArchiveIndexEntry &entry)
+                                            { return entry.endTimeNs <= startNs; }) -
+                       m_entries.begin();
+        for (size_t i = first; i < m_entries.size() && m_entries[i].startTimeNs < endNs; i++)
+        {
+            out.push_back(i);
+        }
+    }
+
+    // Decode one channel of a chunk, reading only that channel's stream
+    bool readChannel(size_t chunkIndex, int channel, ArchiveChannelEdges &out)
+    {
+        ArchiveChunkHeader header;
+        uint32_t streamStart = 0, streamEnd = 0;
+        if (!readChunkHeader(chunkIndex, header) || channel < 0 || static_cast<uint32_t>(channel) >= header.channelCount)
+        {
+            return false;
+        }
+        const uint64_t tableOffset = m_entries[chunkIndex].chunkOffset + sizeof(header);
+        if (channel > 0)
+        {
+            m_file.seekg(static_cast<std::streamoff>(tableOffset + (channel - 1) * sizeof(uint32_t)));
+            m_file.read(reinterpret_cast<char *>(&streamStart), sizeof(streamStart));
+        }
+        else
+        {
+            m_file.seekg(static_cast<std::streamoff>(tableOffset));
+        }
+        m_file.read(reinterpret_cast<char *>(&streamEnd), sizeof(streamEnd));
+        if (!m_file || streamEnd < streamStart || streamEnd > header.payloadBytes)
+        {
+            m_lastError = "Corrupt stream table in chunk " + std::to_string(chunkIndex);
+            return false;
+        }
+
+        m_stream.resize(streamEnd - streamStart);
+        m_file.seekg(static_cast<std::streamoff>(tableOffset + header.channelCount * sizeof(uint32_t) + streamStart));
+        m_file.read(reinterpret_cast<char *>(m_stream.data()), static_cast<std::streamsize>(m_stream.size()));
+        if (!m_file || !ArchiveEncoder::decode(m_stream.data(), m_stream.size(), header.sampleCount, out))
+        {
+            m_lastError = "Corrupt channel stream in chunk " + std::to_string(chunkIndex);
+            return false;
+        }
+        return true;
+    }
+
+    // Decode every channel of a chunk back to the original samples
+    bool readFrame(size_t chunkIndex, std::vector<uint32_t> &samples)
+    {
+        ArchiveChunkHeader header;
+        if (!readChunkHeader(chunkIndex, header))
+        {
+            return false;
+        }
+        samples.assign(static_cast<size_t>(header.sampleCount), 0);
+        ArchiveChannelEdges edges;
+        for (uint32_t ch = 0; ch < header.channelCount && ch < ARCHIVE_CHANNELS; ch++)
+        {
+            if (!readChannel(chunkIndex, static_cast<int>(ch), edges))
+            {
+                return false;
+            }
+            uint32_t level = static_cast<uint32_t>(edges.initialLevel);
+            size_t position = 0;
+            for (size_t e = 0; e <= edges.edges.size(); e++)
+            {
+                const size_t end = e < edges.edges.size() ? edges.edges[e] : samples.size();
+                if (level)
+                {
+                    for (size_t i = position; i < end; i++)
+                        samples[i] |= 1u << ch;
+                }
+                position = end;
+                level ^= 1;
+            }
+        }
+        return true;
+    }
+
+    std::string getLastError() const
+    {
+        return m_lastError;
+    }
+
+private:
+    bool readChunkHeader(size_t chunkIndex, ArchiveChunkHeader &header)
+    {
+        if (chunkIndex >= m_entries.size())
+        {
+            m_lastError = "No chunk " + std::to_string(chunkIndex);
+            return false;
+        }
+        m_file.clear();
+        m_file.seekg(static_cast<std::streamoff>(m_entries[chunkIndex].chunkOffset));
+        m_file.read(reinterpret_cast<char *>(&header), sizeof(header));
+        if (!m_file || header.magic != ARCHIVE_CHUNK_MAGIC)
+        {
+            m_lastError = "Corrupt chunk header " + std::to_string(chunkIndex);
+            return false;
+        }
+        return true;
+    }
+
+    bool loadIndex(const std::string &path)
+    {
+        std::ifstream index(path, std::ios::binary);
+        ArchiveIndexHeader header;
+        index.read(reinterpret_cast<char *>(&header), sizeof(header));
+        if (!index || std::memcmp(header.magic, "LAARCIDX", sizeof(header.magic)) != 0 ||
+            header.version != ARCHIVE_VERSION || header.entrySize != sizeof(ArchiveIndexEntry))
+        {
+            return false;
+        }
+        ArchiveIndexEntry entry;
+        while (index.read(reinterpret_cast<char *>(&entry), sizeof(entry)))
+        {
+            m_entries.push_back(entry);
+        }
+        return true;
+    }
+
+    // Walk the chunk headers when the index file is missing or damaged
+    void rebuildIndex()
+    {
+        m_entries.clear();
+        uint64_t offset = sizeof(ArchiveFileHeader);
+        while (true)
+        {
+            ArchiveChunkHeader header;
+            m_file.clear();
+            m_file.seekg(static_cast<std::streamoff>(offset));
+            m_file.read(reinterpret_cast<char *>(&header), sizeof(header));
+            if (!m_file || header.magic != ARCHIVE_CHUNK_MAGIC)
+            {
+                break;
+            }
+            ArchiveIndexEntry entry;
+            std::memset(&entry, 0, sizeof(entry));
+            entry.startTimeNs = header.startTimeNs;
+            entry.endTimeNs = header.startTimeNs +
+                              (header.sampleRateHz ? static_cast<int64_t>(header.sampleCount * 1000000000.0 / header.sampleRateHz) : 0);
+            entry.sequence = header.sequence;
+            entry.chunkOffset = offset;
+            entry.chunkBytes = static_cast<uint32_t>(sizeof(header) + header.channelCount * sizeof(uint32_t) + header.payloadBytes);
+            // Skip a chunk cut short by a crash
+            m_file.seekg(static_cast<std::streamoff>(offset + entry.chunkBytes - 1));
+            char last;
+            if (!m_file.read(&last, 1))
+            {
+                break;
+            }
+            m_entries.push_back(entry);
+            offset += entry.chunkBytes;
+        }
+        m_file.clear();
+    }
+
+    std::ifstream m_file;
+    ArchiveFileHeader m_header;
+    std::vector<ArchiveIndexEntry> m_entries;
+    std::vector<uint8_t> m_stream;
+    std::string m_lastError;
+};
@@ -0,0 +1,110 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// Samples per second for a Set_Sample_Rate code, or 0 when the rate is not
+// known. Codes 0-8 are the ones the config file template documents (see
+// saveConfiguration in main.cpp); the configuration also accepts 9-12, for
+// which we have no documented rate.
+inline unsigned long sampleRateFromCode(unsigned short code)
+{
+    switch (code)
+    {
+    case 0:
+        return 1000000; // 1 MS/s
+    case 1:
+        return 2000000; // 2 MS/s
+    case 2:
+        return 5000000; // 5 MS/s
+    case 3:
+        return 10000000; // 10 MS/s
+    case 4:
+        return 20000000; // 20 MS/s
+    case 5:
+        return 25000000; // 25 MS/s
+    case 6:
+        return 50000000; // 50 MS/s
+    case 7:
+        return 80000000; // 80 MS/s
+    case 8:
+        return 100000000; // 100 MS/s
+    case 9:
+    case 10:
+    case 11:
+    case 12:
+        return 0; // Accepted, rate not documented
+    default:
+        return 0;
+    }
+}
+
+// Acquisition hardware behind a HantekDevice. The calls mirror the vendor
+// DLL's sequence (connect, init, configure, arm, poll, read) so the DLL maps
+// onto it one to one and other sources (synthetic signals, replayed
+// recordings) can stand in for it with the rest of the analyzer unchanged.
+// Every call returns false on failure and leaves the reason in lastError().
+class CaptureBackend
+{
+public:
+    virtual ~CaptureBackend() {}
+
+    // Short name for logs and the display, e.g. "hantek" or "synthetic"
+    virtual const char *name() const = 0;
+
+    // Prepare the source: the DLL path for hardware, a spec file for generators
+    virtual bool open(const std::string &location) = 0;
+
+    virtual bool connect(unsigned short deviceIndex) = 0;
+    virtual bool initialize() = 0;
+    virtual bool setSampleRate(unsigned short rateCode) = 0;
+    virtual bool setSampleDepth(unsigned long depth) = 0;
+    virtual bool setVoltageThreshold(double threshold) = 0;
+    virtual bool configureTrigger(bool enabled, unsigned short channel, bool risingEdge) = 0;
+    virtual bool setPreTrigger(unsigned short percentage) = 0;
+
+    // Arm one capture of the configured depth
+    virtual bool startCapture() = 0;
+
+    // > 0 once the armed capture is complete, 0 while it is running, < 0 on failure
+    virtual int readStatus() = 0;
+
+    // Copy the completed capture, one 32-channel word per sample, and report
+    // how many of the sampleCount words were written; the rest of the buffer
+    // is left as it was
+    virtual bool readSamples(uint32_t *samples, unsigned long sampleCount, unsigned long &samplesRead) = 0;
+
+    // False for sources that complete a capture as soon as it is armed; the
+    // device then polls straight away instead of predicting the capture time
+    virtual bool isPaced() const
+    {
+        return true;
+    }
+
+    // True once a finite source (a replayed recording) has delivered its last frame
+    virtual bool isExhausted() const
+    {
+        return false;
+    }
+
+    // Sources that play back a fixed stream report the rate code and depth it
+    // was captured with, so the device can be configured to match
+    virtual bool recordedSettings(unsigned short &rateCode, unsigned long &depth) const
+    {
+        (void)rateCode;
+        (void)depth;
+        return false;
+    }
+
+    // Identification reported for the connected device
+    virtual std::string serialNumber() const = 0;
+    virtual std::string model() const = 0;
+    virtual std::string firmwareVersion() const = 0;
+
+    const std::string &lastError() const
+    {
+        return m_lastError;
+    }
+
+protected:
+    std::string m_lastError;
+};
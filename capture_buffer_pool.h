@@ -0,0 +1,333 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// What to do when every buffer of a pool is still in use
+enum class BufferPoolPolicy
+{
+    BLOCK, // Wait (bounded) for analysis to hand a buffer back
+    DROP   // Skip the capture straight away
+};
+
+// Backing memory requested for pool buffers
+enum class BufferPoolMemory
+{
+    NORMAL,     // Plain pageable memory
+    LOCKED,     // Pages locked in RAM so the driver copy never page-faults
+    LARGE_PAGES // Large/huge pages, falling back to locked pages when unavailable
+};
+
+struct BufferPoolStats
+{
+    size_t bufferCount = 0;       // Buffers owned by the pool
+    size_t bufferBytes = 0;       // Size of each buffer
+    size_t inUse = 0;             // Buffers currently held by frames
+    size_t peakInUse = 0;         // Highest inUse seen since the last reset
+    size_t lockedBuffers = 0;     // Buffers whose pages are locked in RAM
+    size_t largePageBuffers = 0;  // Buffers backed by large pages
+    uint64_t acquired = 0;        // Successful acquisitions
+    uint64_t waits = 0;           // Acquisitions that had to wait for a release
+    uint64_t exhausted = 0;       // Captures skipped because no buffer was free
+};
+
+// Fixed set of pre-sized sample buffers for one device. readData borrows a
+// buffer per frame instead of allocating and zero-filling a new one; the
+// buffer goes back to the pool when the last reference to the frame is
+// dropped, so steady-state capture does no heap allocation at all.
+// Buffers are handed out as the previous frame left them, so the frame has
+// to be sized to the samples actually read into it.
+class CaptureBufferPool : public std::enable_shared_from_this<CaptureBufferPool>
+{
+public:
+    // Returns nullptr if not even one buffer could be allocated
+    static std::shared_ptr<CaptureBufferPool> create(size_t bufferCount, size_t samplesPerBuffer,
+                                                     BufferPoolMemory memory)
+    {
+        std::shared_ptr<CaptureBufferPool> pool(new CaptureBufferPool(samplesPerBuffer, memory));
+        for (size_t i = 0; i < bufferCount; i++)
+        {
+            Buffer buffer;
+            if (!allocate(samplesPerBuffer * sizeof(uint32_t), memory, buffer))
+            {
+                break;
+            }
+            pool->m_buffers.push_back(buffer);
+            pool->m_free.push_back(buffer.data);
+        }
+        if (pool->m_buffers.empty())
+        {
+            return nullptr;
+        }
+        return pool;
+    }
+
+    ~CaptureBufferPool()
+    {
+        for (Buffer &buffer : m_buffers)
+        {
+            release(buffer);
+        }
+    }
+
+    size_t samplesPerBuffer() const
+    {
+        return m_samplesPerBuffer;
+    }
+
+    size_t bufferCount() const
+    {
+        return m_buffers.size();
+    }
+
+    BufferPoolMemory memory() const
+    {
+        return m_memory;
+    }
+
+    // Wait until a buffer is free. With DROP this only checks; with BLOCK it
+    // waits up to timeoutMs. A false return is counted as an exhausted pool.
+    bool waitForBuffer(BufferPoolPolicy policy, int timeoutMs)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_free.empty())
+        {
+            return true;
+        }
+        if (policy == BufferPoolPolicy::BLOCK)
+        {
+            m_stats.waits++;
+            if (m_released.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this]
+                                    { return !m_free.empty(); }))
+            {
+                return true;
+            }
+        }
+        m_stats.exhausted++;
+        return false;
+    }
+
+    // Borrow a buffer without waiting; the returned pointer hands it back to
+    // the pool when its last copy is destroyed. nullptr if none is free.
+    std::shared_ptr<uint32_t> acquire()
+    {
+        uint32_t *data = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_free.empty())
+            {
+                return nullptr;
+            }
+            data = m_free.back();
+            m_free.pop_back();
+            m_stats.acquired++;
+            const size_t inUse = m_buffers.size() - m_free.size();
+            if (inUse > m_stats.peakInUse)
+            {
+                m_stats.peakInUse = inUse;
+            }
+        }
+        std::shared_ptr<CaptureBufferPool> self = shared_from_this();
+        return std::shared_ptr<uint32_t>(data, [self](uint32_t *p)
+                                         { self->giveBack(p); });
+    }
+
+    BufferPoolStats stats() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        BufferPoolStats result = m_stats;
+        result.bufferCount = m_buffers.size();
+        result.bufferBytes = m_samplesPerBuffer * sizeof(uint32_t);
+        result.inUse = m_buffers.size() - m_free.size();
+        for (const Buffer &buffer : m_buffers)
+        {
+            if (buffer.locked)
+                result.lockedBuffers++;
+            if (buffer.largePages)
+                result.largePageBuffers++;
+        }
+        return result;
+    }
+
+    void resetStats()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.acquired = 0;
+        m_stats.waits = 0;
+        m_stats.exhausted = 0;
+        m_stats.peakInUse = m_buffers.size() - m_free.size();
+    }
+
+private:
+    struct Buffer
+    {
+        uint32_t *data = nullptr;
+        size_t bytes = 0; // Mapped size, rounded up to the page size used
+        bool locked = false;
+        bool largePages = false;
+    };
+
+    CaptureBufferPool(size_t samplesPerBuffer, BufferPoolMemory memory)
+        : m_samplesPerBuffer(samplesPerBuffer), m_memory(memory)
+    {
+    }
+
+    void giveBack(uint32_t *data)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_free.push_back(data);
+        }
+        m_released.notify_one();
+    }
+
+    static size_t roundUp(size_t bytes, size_t granularity)
+    {
+        return (bytes + granularity - 1) / granularity * granularity;
+    }
+
+#ifdef _WIN32
+    // Large pages need SeLockMemoryPrivilege enabled on the process token
+    static bool enableLockMemoryPrivilege()
+    {
+        static const bool enabled = []()
+        {
+            HANDLE token = nullptr;
+            if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token))
+                return false;
+            TOKEN_PRIVILEGES privileges;
+            privileges.PrivilegeCount = 1;
+            privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+            bool ok = LookupPrivilegeValueA(nullptr, "SeLockMemoryPrivilege", &privileges.Privileges[0].Luid) &&
+                      AdjustTokenPrivileges(token, FALSE, &privileges, 0, nullptr, nullptr) &&
+                      GetLastError() == ERROR_SUCCESS;
+            CloseHandle(token);
+            return ok;
+        }();
+        return enabled;
+    }
+
+    // VirtualLock is limited by the working set minimum, so grow it first
+    static bool lockPages(void *data, size_t bytes)
+    {
+        SIZE_T minimum = 0, maximum = 0;
+        HANDLE process = GetCurrentProcess();
+        if (GetProcessWorkingSetSize(process, &minimum, &maximum))
+        {
+            SetProcessWorkingSetSize(process, minimum + bytes, maximum + bytes);
+        }
+        return VirtualLock(data, bytes) != 0;
+    }
+
+    static bool allocate(size_t bytes, BufferPoolMemory memory, Buffer &out)
+    {
+        if (memory == BufferPoolMemory::LARGE_PAGES && enableLockMemoryPrivilege())
+        {
+            const size_t largePage = GetLargePageMinimum();
+            if (largePage > 0)
+            {
+                const size_t size = roundUp(bytes, largePage);
+                void *data = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+                if (data)
+                {
+                    // Large pages are never paged out
+                    out.data = static_cast<uint32_t *>(data);
+                    out.bytes = size;
+                    out.locked = true;
+                    out.largePages = true;
+                    return true;
+                }
+            }
+        }
+
+        void *data = VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+        if (!data)
+            return false;
+        out.data = static_cast<uint32_t *>(data);
+        out.bytes = bytes;
+        if (memory != BufferPoolMemory::NORMAL)
+        {
+            out.locked = lockPages(data, bytes);
+        }
+        return true;
+    }
+
+    static void release(Buffer &buffer)
+    {
+        if (buffer.locked && !buffer.largePages)
+        {
+            VirtualUnlock(buffer.data, buffer.bytes);
+        }
+        VirtualFree(buffer.data, 0, MEM_RELEASE);
+        buffer.data = nullptr;
+    }
+#else
+    static bool allocate(size_t bytes, BufferPoolMemory memory, Buffer &out)
+    {
+        const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#ifdef MAP_HUGETLB
+        if (memory == BufferPoolMemory::LARGE_PAGES)
+        {
+            const size_t size = roundUp(bytes, 2 * 1024 * 1024);
+            void *data = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (data != MAP_FAILED)
+            {
+                out.data = static_cast<uint32_t *>(data);
+                out.bytes = size;
+                out.largePages = true;
+                out.locked = mlock(data, size) == 0;
+                return true;
+            }
+        }
+#endif
+
+        const size_t size = roundUp(bytes, pageSize);
+        void *data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (data == MAP_FAILED)
+            return false;
+#ifdef MADV_HUGEPAGE
+        if (memory == BufferPoolMemory::LARGE_PAGES)
+        {
+            // No reserved huge pages; ask for transparent ones instead
+            madvise(data, size, MADV_HUGEPAGE);
+        }
+#endif
+        out.data = static_cast<uint32_t *>(data);
+        out.bytes = size;
+        if (memory != BufferPoolMemory::NORMAL)
+        {
+            out.locked = mlock(data, size) == 0;
+        }
+        return true;
+    }
+
+    static void release(Buffer &buffer)
+    {
+        if (buffer.locked)
+        {
+            munlock(buffer.data, buffer.bytes);
+        }
+        munmap(buffer.data, buffer.bytes);
+        buffer.data = nullptr;
+    }
+#endif
+
+    const size_t m_samplesPerBuffer;
+    const BufferPoolMemory m_memory;
+    std::vector<Buffer> m_buffers; // Every buffer the pool owns
+    std::vector<uint32_t *> m_free; // Buffers not held by any frame
+    mutable std::mutex m_mutex;
+    std::condition_variable m_released;
+    BufferPoolStats m_stats;
+};
@@ -0,0 +1,114 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <chrono>
+#include <mutex>
+#include "bitsliced_frame.h"
+#include "edge_list_frame.h"
+
+// Sample layout the per-channel analysis reads a frame in
+enum class AnalysisLayout
+{
+    PACKED,    // One uint32_t word per sample, as read from the device
+    BITSLICED, // One packed bitstream per channel (see BitSlicedFrame)
+    EDGES      // Edge positions per channel (see EdgeListFrame)
+};
+
+// Immutable, reference-counted capture frame.
+// A frame is filled once by the capture source and then shared read-only by
+// every consumer (channel analysis, phase tasks, history), so a capture costs
+// one buffer no matter how many channels look at it.
+// The samples either live in storage the frame allocates itself or in a
+// buffer borrowed from a CaptureBufferPool, which gets it back when the last
+// reference to the frame goes away.
+class CaptureFrame
+{
+public:
+    // Allocate a zero-filled frame that can be filled through mutableData()
+    // before it is published
+    static std::shared_ptr<CaptureFrame> create(size_t sampleCount)
+    {
+        std::shared_ptr<uint32_t> storage(new uint32_t[sampleCount](), std::default_delete<uint32_t[]>());
+        return std::shared_ptr<CaptureFrame>(new CaptureFrame(std::move(storage), sampleCount));
+    }
+
+    // Build a frame on top of an existing buffer (e.g. one borrowed from a
+    // pool); the buffer is not cleared
+    static std::shared_ptr<CaptureFrame> wrap(std::shared_ptr<uint32_t> storage, size_t sampleCount)
+    {
+        return std::shared_ptr<CaptureFrame>(new CaptureFrame(std::move(storage), sampleCount));
+    }
+
+    const uint32_t *data() const
+    {
+        return m_storage.get();
+    }
+
+    size_t size() const
+    {
+        return m_size;
+    }
+
+    bool empty() const
+    {
+        return m_size == 0;
+    }
+
+    uint32_t operator[](size_t index) const
+    {
+        return m_storage.get()[index];
+    }
+
+    // Per-channel bitstream layout of this frame, transposed on first use and
+    // cached so every consumer shares a single conversion
+    std::shared_ptr<const BitSlicedFrame> bitSliced() const
+    {
+        std::call_once(m_bitSlicedOnce, [this]()
+                       { m_bitSliced = BitSlicedFrame::fromSamples(data(), m_size); });
+        return m_bitSliced;
+    }
+
+    // Per-channel edge lists of this frame, built on first use and cached
+    // like bitSliced()
+    std::shared_ptr<const EdgeListFrame> edgeList() const
+    {
+        std::call_once(m_edgeListOnce, [this]()
+                       { m_edgeList = EdgeListFrame::fromSamples(data(), m_size); });
+        return m_edgeList;
+    }
+
+    // Only valid while the frame is still owned exclusively by its producer
+    uint32_t *mutableData()
+    {
+        return m_storage.get();
+    }
+
+    // Shrink the frame if the source returned fewer samples than requested
+    void truncate(size_t sampleCount)
+    {
+        if (sampleCount < m_size)
+        {
+            m_size = sampleCount;
+        }
+    }
+
+    uint64_t sequence = 0;                              // Per-device frame counter
+    unsigned short sampleRateCode = 0;                  // Rate code the frame was captured with
+    std::chrono::system_clock::time_point captureTime; // When ReadSrcData returned
+
+private:
+    CaptureFrame(std::shared_ptr<uint32_t> storage, size_t sampleCount)
+        : m_storage(std::move(storage)), m_size(sampleCount)
+    {
+    }
+
+    std::shared_ptr<uint32_t> m_storage;
+    size_t m_size;
+    mutable std::once_flag m_bitSlicedOnce;
+    mutable std::shared_ptr<const BitSlicedFrame> m_bitSliced;
+    mutable std::once_flag m_edgeListOnce;
+    mutable std::shared_ptr<const EdgeListFrame> m_edgeList;
+};
+
+typedef std::shared_ptr<const CaptureFrame> CaptureFramePtr;
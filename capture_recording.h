@@ -0,0 +1,354 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <deque>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include "capture_frame.h"
+
+// On-disk layout of a capture recording, one file per device:
+//
+//   RecordingFileHeader
+//   { RecordingFrameHeader, sampleCount x uint32_t samples } ...
+//
+// Samples are stored exactly as ReadSrcData returned them (one 32-channel
+// word per sample, host byte order), so replaying a recording feeds the
+// analysis bit-identical input.
+struct RecordingFileHeader
+{
+    char magic[8];         // "LACAPREC"
+    uint32_t version;      // RECORDING_VERSION
+    uint32_t deviceIndex;  // Device the frames were captured on
+    int64_t startTimeNs;   // Wall clock when recording started (ns since the epoch)
+    char serialNumber[32]; // Identification of the recorded device
+    char model[32];
+};
+
+struct RecordingFrameHeader
+{
+    uint32_t magic;          // RECORDING_FRAME_MAGIC, to detect truncated or corrupt files
+    uint16_t sampleRateCode; // Set_Sample_Rate code the frame was captured with
+    uint16_t reserved;
+    uint64_t sequence;       // Device frame counter
+    int64_t captureTimeNs;   // Wall clock when the samples were read (ns since the epoch)
+    int64_t offsetNs;        // Monotonic time since recording started, used to replay the original pacing
+    uint64_t sampleCount;    // Sample depth of this frame
+};
+
+const uint32_t RECORDING_VERSION = 1;
+const uint32_t RECORDING_FRAME_MAGIC = 0x4D415246; // "FRAM"
+
+inline std::string recordingFilePath(const std::string &directory, int deviceIndex)
+{
+    return directory + "/device_" + std::to_string(deviceIndex) + ".lacap";
+}
+
+// Writes one device's frames to a recording file. Frames are handed to a
+// writer thread so the capture loop never waits on the disk unless the writer
+// is MAX_PENDING frames behind; then submit() blocks, because a recording with
+// holes would not replay the same input.
+class CaptureRecorder
+{
+public:
+    enum
+    {
+        MAX_PENDING = 4
+    };
+
+    CaptureRecorder() : m_open(false), m_stopping(false), m_failed(false), m_frames(0), m_bytes(0) {}
+
+    ~CaptureRecorder()
+    {
+        close();
+    }
+
+    bool open(const std::string &path, int deviceIndex, const std::string &serialNumber, const std::string &model)
+    {
+        close();
+        m_file.open(path, std::ios::binary | std::ios::trunc);
+        if (!m_file.is_open())
+        {
+            m_lastError = "Cannot create recording file " + path;
+            return false;
+        }
+
+        RecordingFileHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, "LACAPREC", sizeof(header.magic));
+        header.version = RECORDING_VERSION;
+        header.deviceIndex = static_cast<uint32_t>(deviceIndex);
+        header.startTimeNs = toNanoseconds(std::chrono::system_clock::now().time_since_epoch());
+        std::strncpy(header.serialNumber, serialNumber.c_str(), sizeof(header.serialNumber) - 1);
+        std::strncpy(header.model, model.c_str(), sizeof(header.model) - 1);
+        m_file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        if (!m_file)
+        {
+            m_lastError = "Cannot write recording header to " + path;
+            m_file.close();
+            return false;
+        }
+
+        m_path = path;
+        m_start = std::chrono::steady_clock::now();
+        m_stopping = false;
+        m_failed = false;
+        m_frames = 0;
+        m_bytes = sizeof(header);
+        m_open = true;
+        m_writer = std::thread(&CaptureRecorder::writerLoop, this);
+        return true;
+    }
+
+    // Queue a frame for writing; false once the writer has failed
+    bool submit(const CaptureFramePtr &frame)
+    {
+        PendingFrame pending;
+        pending.frame = frame;
+        pending.offsetNs = toNanoseconds(std::chrono::steady_clock::now() - m_start);
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_space.wait(lock, [this]
+                     { return m_pending.size() < MAX_PENDING || m_failed || !m_open; });
+        if (m_failed || !m_open)
+        {
+            return false;
+        }
+        m_pending.push_back(pending);
+        m_ready.notify_one();
+        return true;
+    }
+
+    // Write out everything queued and close the file
+    void close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_open)
+            {
+                return;
+            }
+            m_stopping = true;
+        }
+        m_ready.notify_one();
+        if (m_writer.joinable())
+        {
+            m_writer.join();
+        }
+        m_file.close();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_open = false;
+        m_space.notify_all();
+    }
+
+    bool isOpen() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_open;
+    }
+
+    uint64_t framesWritten() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_frames;
+    }
+
+    uint64_t bytesWritten() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_bytes;
+    }
+
+    const std::string &path() const
+    {
+        return m_path;
+    }
+
+    std::string getLastError() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_lastError;
+    }
+
+private:
+    struct PendingFrame
+    {
+        CaptureFramePtr frame;
+        int64_t offsetNs;
+    };
+
+    template <typename Duration>
+    static int64_t toNanoseconds(Duration duration)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    }
+
+    void writerLoop()
+    {
+        while (true)
+        {
+            PendingFrame pending;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_ready.wait(lock, [this]
+                             { return m_stopping || !m_pending.empty(); });
+                if (m_pending.empty())
+                {
+                    return;
+                }
+                pending = m_pending.front();
+                m_pending.pop_front();
+            }
+
+            const CaptureFrame &frame = *pending.frame;
+            RecordingFrameHeader header;
+            std::memset(&header, 0, sizeof(header));
+            header.magic = RECORDING_FRAME_MAGIC;
+            header.sampleRateCode = frame.sampleRateCode;
+            header.sequence = frame.sequence;
+            header.captureTimeNs = toNanoseconds(frame.captureTime.time_since_epoch());
+            header.offsetNs = pending.offsetNs;
+            header.sampleCount = frame.size();
+            const uint64_t sampleBytes = frame.size() * sizeof(uint32_t);
+
+            m_file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            m_file.write(reinterpret_cast<const char *>(frame.data()), static_cast<std::streamsize>(sampleBytes));
+            pending.frame.reset(); // Hand a pooled buffer back before waiting again
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_file)
+            {
+                m_lastError = "Write to " + m_path + " failed";
+                m_failed = true;
+                m_pending.clear();
+                m_space.notify_all();
+                return;
+            }
+            m_frames++;
+            m_bytes += sizeof(header) + sampleBytes;
+            m_space.notify_one();
+        }
+    }
+
+    std::ofstream m_file;
+    std::string m_path;
+    std::string m_lastError;
+    std::chrono::steady_clock::time_point m_start;
+    std::thread m_writer;
+    std::deque<PendingFrame> m_pending;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_ready; // Frames queued or stopping
+    std::condition_variable m_space; // Queue has room again
+    bool m_open;
+    bool m_stopping;
+    bool m_failed;
+    uint64_t m_frames;
+    uint64_t m_bytes;
+};
+
+// Sequential reader for a recording file
+class CaptureRecordingReader
+{
+public:
+    bool open(const std::string &path)
+    {
+        m_file.close();
+        m_file.clear();
+        m_file.open(path, std::ios::binary);
+        if (!m_file.is_open())
+        {
+            m_lastError = "Cannot open recording " + path;
+            return false;
+        }
+        m_file.read(reinterpret_cast<char *>(&m_header), sizeof(m_header));
+        if (!m_file || std::memcmp(m_header.magic, "LACAPREC", sizeof(m_header.magic)) != 0)
+        {
+            m_lastError = path + " is not a capture recording";
+            return false;
+        }
+        if (m_header.version != RECORDING_VERSION)
+        {
+            m_lastError = path + " has unsupported recording version " + std::to_string(m_header.version);
+            return false;
+        }
+        m_path = path;
+        m_dataStart = m_file.tellg();
+        return true;
+    }
+
+    const RecordingFileHeader &header() const
+    {
+        return m_header;
+    }
+
+    // Read the next frame header; false at the end of the recording or on a
+    // corrupt record (lastError() is set only for the latter)
+    bool nextFrame(RecordingFrameHeader &frame)
+    {
+        m_lastError.clear();
+        m_file.read(reinterpret_cast<char *>(&frame), sizeof(frame));
+        if (m_file.gcount() == 0 && m_file.eof())
+        {
+            return false;
+        }
+        if (!m_file || frame.magic != RECORDING_FRAME_MAGIC)
+        {
+            m_lastError = "Corrupt frame record in " + m_path;
+            return false;
+        }
+        return true;
+    }
+
+    // Read count samples of the current frame and skip whatever is left of it
+    bool readSamples(const RecordingFrameHeader &frame, uint32_t *samples, uint64_t count)
+    {
+        const uint64_t stored = frame.sampleCount;
+        const uint64_t readCount = count < stored ? count : stored;
+        m_file.read(reinterpret_cast<char *>(samples), static_cast<std::streamsize>(readCount * sizeof(uint32_t)));
+        if (readCount < stored)
+        {
+            m_file.seekg(static_cast<std::streamoff>((stored - readCount) * sizeof(uint32_t)), std::ios::cur);
+        }
+        if (!m_file)
+        {
+            m_lastError = "Truncated frame in " + m_path;
+            return false;
+        }
+        return true;
+    }
+
+    bool skipSamples(const RecordingFrameHeader &frame)
+    {
+        m_file.seekg(static_cast<std::streamoff>(frame.sampleCount * sizeof(uint32_t)), std::ios::cur);
+        if (!m_file)
+        {
+            m_lastError = "Truncated frame in " + m_path;
+            return false;
+        }
+        return true;
+    }
+
+    // Back to the first frame
+    bool rewind()
+    {
+        m_file.clear();
+        m_file.seekg(m_dataStart);
+        return static_cast<bool>(m_file);
+    }
+
+    const std::string &getLastError() const
+    {
+        return m_lastError;
+    }
+
+private:
+    std::ifstream m_file;
+    std::string m_path;
+    std::string m_lastError;
+    RecordingFileHeader m_header;
+    std::streampos m_dataStart;
+};
@@ -0,0 +1,204 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <array>
+#include <mutex>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+
+// Waits for a capture to finish without a fixed polling interval.
+// The completion time is predicted from the sample rate and depth, the thread
+// sleeps until shortly before that point and then polls the status with a
+// bounded spin. Every completion feeds a mean/deviation estimator (the same
+// scheme TCP uses for round-trip times) so the prediction converges on what
+// the device actually takes, USB and driver overhead included.
+class CaptureCompletionWaiter
+{
+public:
+    enum class Result
+    {
+        COMPLETE,
+        TIMEOUT,
+        FAILED
+    };
+
+    static const int HISTOGRAM_BUCKETS = 24; // Bucket i covers [2^i, 2^(i+1)) microseconds
+
+    struct Stats
+    {
+        uint64_t captures = 0;      // Completed waits
+        uint64_t firstPollHits = 0; // Captures already complete on the first poll
+        uint64_t polls = 0;         // Status polls issued
+        uint64_t timeouts = 0;      // Waits that hit the timeout
+        double nominalUs = 0.0;     // Sample depth / sample rate
+        double predictedUs = 0.0;   // Calibrated completion time
+        double deviationUs = 0.0;   // Mean deviation of the completion time
+        double oversleepUs = 0.0;   // How late the OS wakes us from a sleep
+        std::array<uint64_t, HISTOGRAM_BUCKETS> histogram{};
+
+        // Upper bound of the histogram bucket holding the given quantile
+        double percentileUs(double quantile) const
+        {
+            uint64_t total = 0;
+            for (uint64_t count : histogram)
+                total += count;
+            if (total == 0)
+                return 0.0;
+            const double target = quantile * static_cast<double>(total);
+            uint64_t seen = 0;
+            for (int i = 0; i < HISTOGRAM_BUCKETS; i++)
+            {
+                seen += histogram[i];
+                if (static_cast<double>(seen) >= target)
+                    return std::ldexp(1.0, i + 1);
+            }
+            return std::ldexp(1.0, HISTOGRAM_BUCKETS);
+        }
+    };
+
+    // Restart calibration when the rate or depth changes
+    void setCaptureParameters(unsigned long sampleRateHz, unsigned long sampleDepth)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (sampleRateHz == m_sampleRateHz && sampleDepth == m_sampleDepth)
+            return;
+
+        m_sampleRateHz = sampleRateHz;
+        m_sampleDepth = sampleDepth;
+        const double nominalUs = sampleRateHz > 0 ? 1e6 * sampleDepth / sampleRateHz : 0.0;
+        const double oversleepUs = m_stats.oversleepUs;
+        m_stats = Stats();
+        m_stats.nominalUs = nominalUs;
+        m_stats.predictedUs = nominalUs;
+        m_stats.deviationUs = nominalUs / 4;
+        m_stats.oversleepUs = oversleepUs; // Property of the OS, not of the capture
+    }
+
+    // poll() returns > 0 once the capture is complete, 0 while it is still
+    // running and < 0 on failure
+    template <typename Poll>
+    Result wait(Poll poll, int timeoutMs)
+    {
+        const double MIN_GUARD_US = 200.0; // Never plan to wake closer than this
+        const double MIN_SLEEP_US = 500.0; // Shorter sleeps are not worth the wake-up jitter
+        const double MIN_SPIN_US = 2000.0;
+
+        const Clock::time_point start = Clock::now();
+        const Clock::time_point deadline = start + std::chrono::milliseconds(timeoutMs);
+
+        double predictedUs, guardUs, oversleepUs;
+        {
+            // Without a sample rate there is nothing to predict from: skip the
+            // sleep and just poll
+            std::lock_guard<std::mutex> lock(m_mutex);
+            predictedUs = m_sampleRateHz > 0 ? m_stats.predictedUs : 0.0;
+            guardUs = std::max(MIN_GUARD_US, 3.0 * m_stats.deviationUs);
+            oversleepUs = m_stats.oversleepUs;
+        }
+
+        // Sleep through the part of the capture that cannot be complete yet
+        const double sleepUs = predictedUs - guardUs - oversleepUs;
+        if (sleepUs >= MIN_SLEEP_US)
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(static_cast<long long>(sleepUs)));
+            const double lateUs = std::max(0.0, microsecondsSince(start) - sleepUs);
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stats.oversleepUs += (lateUs - m_stats.oversleepUs) / 8;
+        }
+
+        // Spin around the predicted point, then back off to short sleeps
+        const double spinBudgetUs = std::max(MIN_SPIN_US, 2.0 * guardUs);
+        const Clock::time_point spinStart = Clock::now();
+        double lastMissUs = -1.0;
+        uint64_t polls = 0;
+        while (true)
+        {
+            const int status = poll();
+            polls++;
+            const Clock::time_point now = Clock::now();
+            if (status < 0)
+            {
+                addPolls(polls);
+                return Result::FAILED;
+            }
+            if (status > 0)
+            {
+                recordCompletion(microsecondsBetween(start, now), lastMissUs, polls);
+                return Result::COMPLETE;
+            }
+            lastMissUs = microsecondsBetween(start, now);
+            if (now > deadline)
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stats.polls += polls;
+                m_stats.timeouts++;
+                return Result::TIMEOUT;
+            }
+            if (microsecondsBetween(spinStart, now) < spinBudgetUs)
+            {
+                std::this_thread::yield();
+            }
+            else
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+    }
+
+    Stats stats() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_stats;
+    }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    static double microsecondsBetween(Clock::time_point from, Clock::time_point to)
+    {
+        return std::chrono::duration<double, std::micro>(to - from).count();
+    }
+
+    static double microsecondsSince(Clock::time_point from)
+    {
+        return microsecondsBetween(from, Clock::now());
+    }
+
+    void addPolls(uint64_t polls)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.polls += polls;
+    }
+
+    // The capture finished somewhere between the last poll that missed and
+    // the poll that saw it. When the first poll already saw it we woke too
+    // late and only have an upper bound, so bias the sample downwards to probe
+    // an earlier wake-up next time.
+    void recordCompletion(double seenUs, double lastMissUs, uint64_t polls)
+    {
+        const bool firstPoll = lastMissUs < 0.0;
+        const double sampleUs = firstPoll ? 0.9 * seenUs : 0.5 * (lastMissUs + seenUs);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.captures++;
+        m_stats.polls += polls;
+        if (firstPoll)
+            m_stats.firstPollHits++;
+
+        const double error = sampleUs - m_stats.predictedUs;
+        m_stats.predictedUs += error / 8;
+        m_stats.deviationUs += (std::fabs(error) - m_stats.deviationUs) / 4;
+
+        int bucket = 0;
+        while (bucket < HISTOGRAM_BUCKETS - 1 && std::ldexp(1.0, bucket + 1) <= sampleUs)
+            bucket++;
+        m_stats.histogram[bucket]++;
+    }
+
+    mutable std::mutex m_mutex;
+    unsigned long m_sampleRateHz = 0;
+    unsigned long m_sampleDepth = 0;
+    Stats m_stats;
+};
@@ -0,0 +1,289 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <streambuf>
+#include <ostream>
+#include <algorithm>
+
+// Double-buffered console display. A frame is drawn into a grid of cells
+// through stream() and setColor(), as it would be to std::cout, and
+// present() compares it with the frame on the terminal and writes only the
+// changed span of each changed row, with ANSI cursor moves and colours, in
+// a single write. A steady display therefore costs a few bytes per refresh
+// instead of a full redraw.
+//
+// Colours use the Windows console palette (bit 0 blue, 1 green, 2 red,
+// 3 bright) so ConsoleColors values pass straight through. Without ANSI
+// support (output redirected, or an old console) present() writes each
+// frame as plain text.
+class ConsoleScreen
+{
+public:
+    enum
+    {
+        DEFAULT_COLOR = 7 // Light gray on black
+    };
+
+    explicit ConsoleScreen(bool ansi = true)
+        : m_buffer(*this), m_stream(&m_buffer), m_ansi(ansi), m_color(DEFAULT_COLOR),
+          m_rows(0), m_columns(0), m_fullRedraw(true), m_lastBytes(0)
+    {
+        begin();
+    }
+
+    // Whether the terminal takes ANSI sequences; without them each frame
+    // goes out as plain text
+    void setAnsi(bool ansi)
+    {
+        m_ansi = ansi;
+        m_fullRedraw = true;
+    }
+
+    // Start drawing a new frame on an empty grid
+    void begin()
+    {
+        m_back.clear();
+        m_back.emplace_back();
+        m_color = DEFAULT_COLOR;
+    }
+
+    std::ostream &stream()
+    {
+        return m_stream;
+    }
+
+    void setColor(int text, int background = 0)
+    {
+        m_color = static_cast<uint8_t>((background << 4) | (text & 15));
+    }
+
+    void resetColor()
+    {
+        m_color = DEFAULT_COLOR;
+    }
+
+    // Terminal size to clip frames to; 0 = unknown, no clipping
+    void setSize(int rows, int columns)
+    {
+        if (rows != m_rows || columns != m_columns)
+        {
+            m_rows = rows;
+            m_columns = columns;
+            m_fullRedraw = true;
+        }
+    }
+
+    // Something else wrote to the terminal: repaint everything next time
+    void invalidate()
+    {
+        m_fullRedraw = true;
+    }
+
+    // Bring the terminal up to date with the frame drawn since begin()
+    size_t present()
+    {
+        clip();
+        m_output.clear();
+        if (!m_ansi)
+        {
+            for (const Row &row : m_back)
+            {
+                for (const Cell &cell : row)
+                    m_output.append(cell.bytes, cell.length);
+                m_output += '\n';
+            }
+        }
+        else
+        {
+            if (m_fullRedraw)
+            {
+                m_output += "\033[0m\033[2J";
+                m_front.clear();
+                m_fullRedraw = false;
+            }
+            int emitted = -1; // Colour the terminal is set to; -1 = unknown
+            const size_t rows = std::max(m_back.size(), m_front.size());
+            for (size_t r = 0; r < rows; r++)
+            {
+                static const Row EMPTY;
+                const Row &back = r < m_back.size() ? m_back[r] : EMPTY;
+                const Row &front = r < m_front.size() ? m_front[r] : EMPTY;
+                drawRowChange(r, back, front, emitted);
+            }
+            appendCursorMove(m_back.size(), 0);
+            m_output += "\033[0m";
+            m_front.swap(m_back);
+        }
+        std::fwrite(m_output.data(), 1, m_output.size(), stdout);
+        std::fflush(stdout);
+        m_lastBytes = m_output.size();
+        return m_lastBytes;
+    }
+
+    // Bytes the last present() wrote
+    size_t lastBytes() const
+    {
+        return m_lastBytes;
+    }
+
+private:
+    // One glyph: a character, or the bytes of one UTF-8 sequence
+    struct Cell
+    {
+        char bytes[4];
+        uint8_t length;
+        uint8_t color;
+
+        bool operator==(const Cell &other) const
+        {
+            return length == other.length && color == other.color && std::memcmp(bytes, other.bytes, length) == 0;
+        }
+
+        bool operator!=(const Cell &other) const
+        {
+            return !(*this == other);
+        }
+    };
+    typedef std::vector<Cell> Row;
+
+    // Feeds everything written to stream() into the back grid
+    class CellBuffer : public std::streambuf
+    {
+    public:
+        explicit CellBuffer(ConsoleScreen &screen) : m_screen(screen) {}
+
+    protected:
+        int_type overflow(int_type c) override
+        {
+            if (c != traits_type::eof())
+                m_screen.put(static_cast<char>(c));
+            return traits_type::not_eof(c);
+        }
+
+    private:
+        ConsoleScreen &m_screen;
+    };
+
+    void put(char c)
+    {
+        Row &row = m_back.back();
+        if (c == '\n')
+        {
+            m_back.emplace_back();
+        }
+        else if (c == '\t')
+        {
+            do
+            {
+                put(' ');
+            } while (m_back.back().size() % 8 != 0);
+        }
+        else if ((static_cast<unsigned char>(c) & 0xC0) == 0x80 && !row.empty() && row.back().length < 4)
+        {
+            // UTF-8 continuation byte: part of the previous glyph
+            row.back().bytes[row.back().length++] = c;
+        }
+        else if (c != '\r')
+        {
+            Cell cell;
+            cell.bytes[0] = c;
+            cell.length = 1;
+            cell.color = m_color;
+            row.push_back(cell);
+        }
+    }
+
+    // Keep the frame inside the terminal, so rows never wrap or scroll
+    // and cursor positions stay valid
+    void clip()
+    {
+        // The trailing newline leaves an empty last row
+        if (m_back.size() > 1 && m_back.back().empty())
+            m_back.pop_back();
+        if (m_columns > 0)
+        {
+            for (Row &row : m_back)
+            {
+                if (row.size() >= static_cast<size_t>(m_columns))
+                    row.resize(m_columns - 1);
+            }
+        }
+        if (m_rows > 1 && m_back.size() >= static_cast<size_t>(m_rows))
+        {
+            m_back.resize(m_rows - 2);
+            m_color = DEFAULT_COLOR;
+            m_back.emplace_back();
+            for (const char *c = "... more lines below; enlarge the window"; *c; c++)
+                put(*c);
+        }
+    }
+
+    void drawRowChange(size_t r, const Row &back, const Row &front, int &emitted)
+    {
+        const size_t common = std::min(back.size(), front.size());
+        size_t first = 0;
+        while (first < common && back[first] == front[first])
+            first++;
+        if (first == back.size() && first == front.size())
+            return; // Unchanged
+
+        size_t end = back.size();
+        if (back.size() == front.size())
+        {
+            while (end > first && back[end - 1] == front[end - 1])
+                end--;
+        }
+        appendCursorMove(r, first);
+        for (size_t c = first; c < end; c++)
+        {
+            if (back[c].color != emitted)
+            {
+                appendColor(back[c].color);
+                emitted = back[c].color;
+            }
+            m_output.append(back[c].bytes, back[c].length);
+        }
+        if (front.size() > back.size())
+        {
+            // Erase what is left of the longer old row
+            m_output += "\033[0m\033[K";
+            emitted = -1;
+        }
+    }
+
+    void appendCursorMove(size_t row, size_t column)
+    {
+        char move[32];
+        std::snprintf(move, sizeof(move), "\033[%u;%uH", static_cast<unsigned>(row + 1), static_cast<unsigned>(column + 1));
+        m_output += move;
+    }
+
+    void appendColor(uint8_t color)
+    {
+        // ANSI numbers the colours red = 1, green = 2, blue = 4
+        auto ansi = [](int c)
+        { return ((c & 4) ? 1 : 0) | (c & 2) | ((c & 1) ? 4 : 0); };
+        const int text = color & 15;
+        const int background = color >> 4;
+        char sgr[32];
+        std::snprintf(sgr, sizeof(sgr), "\033[%d;%dm", ((text & 8) ? 90 : 30) + ansi(text),
+                      ((background & 8) ? 100 : 40) + ansi(background));
+        m_output += sgr;
+    }
+
+    CellBuffer m_buffer;
+    std::ostream m_stream;
+    bool m_ansi;
+    uint8_t m_color; // Colour of the cells written next
+    int m_rows;
+    int m_columns;
+    bool m_fullRedraw;
+    std::vector<Row> m_back;  // Frame being drawn
+    std::vector<Row> m_front; // Frame on the terminal
+    std::string m_output;     // Reused between presents
+    size_t m_lastBytes;
+};
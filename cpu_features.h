@@ -0,0 +1,85 @@
+#pragma once
+#include <cstdint>
+
+// CPU feature detection and bit helpers shared by the analysis kernels
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define LA_HAVE_X86 1
+#include <immintrin.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Functions using AVX2 intrinsics are tagged so GCC/Clang compile them without
+// a global -mavx2; MSVC accepts the intrinsics as-is.
+#if defined(LA_HAVE_X86) && (defined(__GNUC__) || defined(__clang__))
+#define LA_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define LA_TARGET_AVX2
+#endif
+
+namespace cpu
+{
+    inline bool detectAvx2()
+    {
+#if defined(LA_HAVE_X86) && defined(_MSC_VER)
+        int info[4] = {0, 0, 0, 0};
+        __cpuid(info, 0);
+        if (info[0] < 7)
+            return false;
+        __cpuid(info, 1);
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const bool avx = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx)
+            return false;
+        // OS must save the YMM state
+        if ((_xgetbv(0) & 0x6) != 0x6)
+            return false;
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#elif defined(LA_HAVE_X86) && (defined(__GNUC__) || defined(__clang__))
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") != 0;
+#else
+        return false;
+#endif
+    }
+
+    inline bool hasAvx2()
+    {
+        static const bool supported = detectAvx2();
+        return supported;
+    }
+
+    inline int popcount64(uint64_t value)
+    {
+#if defined(_MSC_VER) && defined(_M_X64)
+        return static_cast<int>(__popcnt64(value));
+#elif (defined(__GNUC__) || defined(__clang__)) && defined(__POPCNT__)
+        return __builtin_popcountll(value);
+#else
+        value = value - ((value >> 1) & 0x5555555555555555ULL);
+        value = (value & 0x3333333333333333ULL) + ((value >> 2) & 0x3333333333333333ULL);
+        value = (value + (value >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+        return static_cast<int>((value * 0x0101010101010101ULL) >> 56);
+#endif
+    }
+
+    // Index of the lowest set bit; value must not be zero
+    inline int countTrailingZeros32(uint32_t value)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward(&index, value);
+        return static_cast<int>(index);
+#elif defined(__GNUC__) || defined(__clang__)
+        return __builtin_ctz(value);
+#else
+        int index = 0;
+        while (((value >> index) & 1) == 0)
+            index++;
+        return index;
+#endif
+    }
+}
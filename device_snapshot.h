@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+#include <chrono>
+
+// Per-device results as the display and the exporters see them
+
+const int PHASE_CHANNELS = 12;        // Channels (brain probes) that get phase analysis
+const int SNAPSHOT_MAX_SLICES = 16;   // Slices carried in a snapshot; more are not exported
+const int CHANGE_HIGHLIGHT_MS = 3000; // How long a channel counts as "changing" after an edge
+
+// Published copy of one channel's results (plain data, see DeviceSnapshot)
+struct ChannelSnapshot
+{
+    uint32_t currentState = 0;
+    int transitions = 0;
+    int totalTransitions = 0;
+    bool changed = false;
+    double meanPhase = 0.0;
+    double phaseVariance = 0.0;
+    double dutyCycle = -1.0;
+    double meanHighPulseUs = -1.0;
+    std::chrono::system_clock::time_point lastChangeTime;
+    double sliceActivityLevels[SNAPSHOT_MAX_SLICES] = {};
+};
+
+// Consistent view of a device for the display and the exporters.
+// DeviceState is the working state of the device's own threads; after every
+// frame (and whenever the health counters change) they publish a snapshot,
+// and readers only ever look at snapshots. Serial, model and firmware are
+// set once at bring-up and read from DeviceState directly.
+struct DeviceSnapshot
+{
+    bool connected = false;
+    bool active = false;
+    int consecutiveErrors = 0;
+    int capturesCount = 0;
+    int errorsCount = 0;
+    uint64_t frameSequence = 0;
+    std::chrono::system_clock::time_point lastCaptureTime;
+    uint32_t changedMask = 0; // Channels with an edge within CHANGE_HIGHLIGHT_MS of the frame
+    int sliceCount = 0;
+    ChannelSnapshot channels[32];
+
+    // Whether a channel still counts as changing at time now
+    bool isChanging(int ch, std::chrono::system_clock::time_point now) const
+    {
+        return ((changedMask >> ch) & 1) &&
+               now - channels[ch].lastChangeTime <= std::chrono::milliseconds(CHANGE_HIGHLIGHT_MS);
+    }
+
+    int changingCount(std::chrono::system_clock::time_point now) const
+    {
+        int count = 0;
+        for (int ch = 0; ch < 32; ch++)
+        {
+            if (isChanging(ch, now))
+                count++;
+        }
+        return count;
+    }
+};
@@ -0,0 +1,297 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include "cpu_features.h"
+#include "transition_counter.h"
+
+// Pulse-width and duty-cycle figures of one channel over a frame. Widths are
+// in samples and only cover complete pulses, i.e. ones bounded by an edge on
+// both sides.
+struct PulseStats
+{
+    double dutyCycle = 0.0; // Fraction of the frame spent high
+    uint32_t highPulses = 0;
+    uint32_t lowPulses = 0;
+    uint32_t minHighWidth = 0;
+    uint32_t maxHighWidth = 0;
+    double meanHighWidth = 0.0;
+    uint32_t minLowWidth = 0;
+    uint32_t maxLowWidth = 0;
+    double meanLowWidth = 0.0;
+};
+
+// Edge-list (run-length) view of a capture frame.
+// Each channel is its level at sample 0 plus the sorted positions of its
+// edges, where an edge at position i means sample i differs from sample
+// i - 1. Edges alternate, so the polarity of edge e follows from the initial
+// level and the parity of e. Memory scales with activity rather than depth,
+// and the per-channel analytics below cost O(edges) instead of O(samples).
+class EdgeListFrame
+{
+public:
+    static std::shared_ptr<const EdgeListFrame> fromSamples(const uint32_t *samples, size_t sampleCount)
+    {
+        std::shared_ptr<EdgeListFrame> frame(new EdgeListFrame(sampleCount));
+        if (sampleCount == 0)
+        {
+            return frame;
+        }
+        frame->m_firstWord = samples[0];
+        frame->m_lastWord = samples[sampleCount - 1];
+        if (cpu::hasAvx2())
+        {
+            frame->scanAvx2(samples);
+        }
+        else
+        {
+            frame->scanScalar(samples, 1);
+        }
+        return frame;
+    }
+
+    size_t size() const
+    {
+        return m_sampleCount;
+    }
+
+    uint32_t firstWord() const
+    {
+        return m_firstWord;
+    }
+
+    uint32_t lastWord() const
+    {
+        return m_lastWord;
+    }
+
+    int initialLevel(int ch) const
+    {
+        return static_cast<int>((m_firstWord >> ch) & 1);
+    }
+
+    // Sorted edge positions of one channel
+    const std::vector<uint32_t> &edges(int ch) const
+    {
+        return m_edges[ch];
+    }
+
+    // Whether edge e of a channel goes from low to high
+    bool rising(int ch, size_t e) const
+    {
+        return ((initialLevel(ch) ^ static_cast<int>(e & 1)) & 1) == 0;
+    }
+
+    size_t edgeCount() const
+    {
+        size_t count = 0;
+        for (const std::vector<uint32_t> &edges : m_edges)
+        {
+            count += edges.size();
+        }
+        return count;
+    }
+
+    // Heap held by the edge lists
+    size_t memoryBytes() const
+    {
+        size_t bytes = 0;
+        for (const std::vector<uint32_t> &edges : m_edges)
+        {
+            bytes += edges.capacity() * sizeof(uint32_t);
+        }
+        return bytes;
+    }
+
+    bool level(int ch, size_t index) const
+    {
+        const std::vector<uint32_t> &edges = m_edges[ch];
+        const size_t flips = std::upper_bound(edges.begin(), edges.end(), index) - edges.begin();
+        return ((initialLevel(ch) ^ static_cast<int>(flips & 1)) & 1) != 0;
+    }
+
+    // Number of edges strictly inside [begin, end), as BitSlicedFrame::countTransitions
+    size_t countTransitions(int ch, size_t begin, size_t end) const
+    {
+        if (end > m_sampleCount)
+            end = m_sampleCount;
+        if (begin + 1 >= end)
+            return 0;
+        const std::vector<uint32_t> &edges = m_edges[ch];
+        return std::lower_bound(edges.begin(), edges.end(), end) -
+               std::upper_bound(edges.begin(), edges.end(), begin);
+    }
+
+    // Same result as TransitionCounter::count, from one walk over each edge list
+    void countTransitions(int numSlices, TransitionCounts &out) const
+    {
+        if (numSlices < 1)
+            numSlices = 1;
+
+        out.transitions.fill(0);
+        out.sliceTransitions.resize(numSlices);
+        for (auto &slice : out.sliceTransitions)
+        {
+            slice.fill(0);
+        }
+        out.firstWord = m_firstWord;
+        out.lastWord = m_lastWord;
+
+        const size_t samplesPerSlice = m_sampleCount / numSlices;
+        for (int ch = 0; ch < 32; ch++)
+        {
+            const std::vector<uint32_t> &edges = m_edges[ch];
+            out.transitions[ch] = static_cast<uint32_t>(edges.size());
+            for (uint32_t edge : edges)
+            {
+                const size_t slice = samplesPerSlice ? std::min<size_t>(edge / samplesPerSlice, numSlices - 1)
+                                                     : static_cast<size_t>(numSlices - 1);
+                // The edge into a slice only counts toward the frame total
+                if (edge != slice * samplesPerSlice)
+                {
+                    out.sliceTransitions[slice][ch]++;
+                }
+            }
+        }
+    }
+
+    // Number of samples in [begin, end) where the channel is high
+    size_t countHigh(int ch, size_t begin, size_t end) const
+    {
+        if (end > m_sampleCount)
+            end = m_sampleCount;
+        if (begin >= end)
+            return 0;
+
+        const std::vector<uint32_t> &edges = m_edges[ch];
+        auto edge = std::upper_bound(edges.begin(), edges.end(), begin);
+        int high = initialLevel(ch) ^ static_cast<int>((edge - edges.begin()) & 1);
+        size_t position = begin;
+        size_t count = 0;
+        for (; edge != edges.end() && *edge < end; ++edge)
+        {
+            if (high)
+                count += *edge - position;
+            position = *edge;
+            high ^= 1;
+        }
+        if (high)
+            count += end - position;
+        return count;
+    }
+
+    // Write samples [begin, begin + count) of one channel as 0.0/1.0
+    void extract(int ch, size_t begin, size_t count, double *out) const
+    {
+        const std::vector<uint32_t> &edges = m_edges[ch];
+        const size_t end = begin + count;
+        auto edge = std::upper_bound(edges.begin(), edges.end(), begin);
+        int high = initialLevel(ch) ^ static_cast<int>((edge - edges.begin()) & 1);
+        size_t position = begin;
+        for (; edge != edges.end() && *edge < end; ++edge)
+        {
+            std::fill(out + (position - begin), out + (*edge - begin), high ? 1.0 : 0.0);
+            position = *edge;
+            high ^= 1;
+        }
+        std::fill(out + (position - begin), out + count, high ? 1.0 : 0.0);
+    }
+
+    void pulseStats(int ch, PulseStats &out) const
+    {
+        out = PulseStats();
+        if (m_sampleCount == 0)
+            return;
+
+        const std::vector<uint32_t> &edges = m_edges[ch];
+        uint64_t highTotal = 0, highPulseTotal = 0, lowPulseTotal = 0;
+        int high = initialLevel(ch);
+        size_t position = 0;
+        for (size_t e = 0; e <= edges.size(); e++)
+        {
+            const size_t next = e < edges.size() ? edges[e] : m_sampleCount;
+            const uint32_t width = static_cast<uint32_t>(next - position);
+            if (high)
+                highTotal += width;
+            // The runs before the first and after the last edge are cut off by the frame
+            if (e > 0 && e < edges.size())
+            {
+                if (high)
+                    addPulse(width, out.highPulses, out.minHighWidth, out.maxHighWidth, highPulseTotal);
+                else
+                    addPulse(width, out.lowPulses, out.minLowWidth, out.maxLowWidth, lowPulseTotal);
+            }
+            position = next;
+            high ^= 1;
+        }
+        out.dutyCycle = static_cast<double>(highTotal) / m_sampleCount;
+        out.meanHighWidth = out.highPulses ? static_cast<double>(highPulseTotal) / out.highPulses : 0.0;
+        out.meanLowWidth = out.lowPulses ? static_cast<double>(lowPulseTotal) / out.lowPulses : 0.0;
+    }
+
+private:
+    explicit EdgeListFrame(size_t sampleCount)
+        : m_sampleCount(sampleCount), m_firstWord(0), m_lastWord(0), m_edges(32)
+    {
+    }
+
+    static void addPulse(uint32_t width, uint32_t &count, uint32_t &minWidth, uint32_t &maxWidth, uint64_t &total)
+    {
+        minWidth = count ? std::min(minWidth, width) : width;
+        maxWidth = std::max(maxWidth, width);
+        total += width;
+        count++;
+    }
+
+    // Append the edges between each sample in [first, end) and its predecessor
+    void scanRange(const uint32_t *samples, size_t first, size_t end)
+    {
+        for (size_t i = first; i < end; i++)
+        {
+            uint32_t flipped = samples[i] ^ samples[i - 1];
+            while (flipped)
+            {
+                m_edges[cpu::countTrailingZeros32(flipped)].push_back(static_cast<uint32_t>(i));
+                flipped &= flipped - 1;
+            }
+        }
+    }
+
+    void scanScalar(const uint32_t *samples, size_t first)
+    {
+        scanRange(samples, first, m_sampleCount);
+    }
+
+#ifdef LA_HAVE_X86
+    // Compare eight samples with their predecessors per instruction and only
+    // drop to the scalar edge extraction for blocks that contain an edge,
+    // which for sparse signals is almost none of them
+    LA_TARGET_AVX2 void scanAvx2(const uint32_t *samples)
+    {
+        size_t i = 1;
+        for (; i + 8 <= m_sampleCount; i += 8)
+        {
+            const __m256i current = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(samples + i));
+            const __m256i previous = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(samples + i - 1));
+            const __m256i flipped = _mm256_xor_si256(current, previous);
+            if (!_mm256_testz_si256(flipped, flipped))
+            {
+                scanRange(samples, i, i + 8);
+            }
+        }
+        scanScalar(samples, i);
+    }
+#else
+    void scanAvx2(const uint32_t *samples)
+    {
+        scanScalar(samples, 1);
+    }
+#endif
+
+    size_t m_sampleCount;
+    uint32_t m_firstWord;
+    uint32_t m_lastWord;
+    std::vector<std::vector<uint32_t>> m_edges; // [channel], sorted edge positions
+};
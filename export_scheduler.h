@@ -0,0 +1,149 @@
+#pragma once
+#include <cstdint>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <functional>
+#include "trace.h"
+
+// Single export stage for the output files. Device threads only flag their
+// device as dirty (one atomic OR, never blocks); a dedicated thread wakes
+// once per period and writes the outputs if anything changed since the last
+// write, so a burst of frames from many devices costs one rewrite per file.
+// When nothing changes the outputs are still refreshed every heartbeat so
+// readers can tell the monitor is alive.
+class ExportScheduler
+{
+public:
+    enum
+    {
+        MAX_SOURCES = 64 // One dirty bit per device
+    };
+
+    // dirtyMask has bit i set for every device flagged since the previous call;
+    // 0 means a heartbeat with no new data
+    typedef std::function<void(uint64_t dirtyMask)> FlushFunction;
+
+    struct Stats
+    {
+        uint64_t notifications = 0; // markDirty calls
+        uint64_t flushes = 0;       // Writes triggered by new data
+        uint64_t heartbeats = 0;    // Writes with nothing new
+        double lastFlushUs = 0.0;
+        double maxFlushUs = 0.0;
+    };
+
+    ExportScheduler() : m_dirty(0), m_running(false), m_periodMs(200), m_heartbeatMs(500) {}
+
+    ~ExportScheduler()
+    {
+        stop();
+    }
+
+    void start(int periodMs, int heartbeatMs, FlushFunction flush)
+    {
+        stop();
+        m_periodMs = periodMs;
+        m_heartbeatMs = heartbeatMs;
+        m_flush = std::move(flush);
+        m_running = true;
+        m_thread = std::thread(&ExportScheduler::exportLoop, this);
+    }
+
+    // Stop the thread after writing out anything still flagged
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_running)
+            {
+                return;
+            }
+            m_running = false;
+        }
+        m_wake.notify_one();
+        if (m_thread.joinable())
+        {
+            m_thread.join();
+        }
+    }
+
+    void markDirty(int source)
+    {
+        m_dirty.fetch_or(uint64_t(1) << (source % MAX_SOURCES), std::memory_order_release);
+        m_notifications.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    int periodMs() const
+    {
+        return m_periodMs;
+    }
+
+    Stats stats() const
+    {
+        std::lock_guard<std::mutex> lock(m_statsMutex);
+        Stats result = m_stats;
+        result.notifications = m_notifications.load(std::memory_order_relaxed);
+        return result;
+    }
+
+    void resetStats()
+    {
+        std::lock_guard<std::mutex> lock(m_statsMutex);
+        m_stats = Stats();
+        m_notifications = 0;
+    }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    void exportLoop()
+    {
+        TraceRecorder::instance().setThreadName("exporter");
+        Clock::time_point lastWrite = Clock::now();
+        bool running = true;
+        while (running)
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wake.wait_for(lock, std::chrono::milliseconds(m_periodMs), [this]
+                                { return !m_running; });
+                running = m_running;
+            }
+
+            const uint64_t dirty = m_dirty.exchange(0, std::memory_order_acquire);
+            const Clock::time_point now = Clock::now();
+            if (dirty == 0 && (!running || now - lastWrite < std::chrono::milliseconds(m_heartbeatMs)))
+            {
+                continue;
+            }
+
+            m_flush(dirty);
+            lastWrite = Clock::now();
+
+            const double flushUs = std::chrono::duration<double, std::micro>(lastWrite - now).count();
+            std::lock_guard<std::mutex> lock(m_statsMutex);
+            if (dirty)
+                m_stats.flushes++;
+            else
+                m_stats.heartbeats++;
+            m_stats.lastFlushUs = flushUs;
+            if (flushUs > m_stats.maxFlushUs)
+                m_stats.maxFlushUs = flushUs;
+        }
+    }
+
+    std::atomic<uint64_t> m_dirty;
+    std::atomic<uint64_t> m_notifications{0};
+    FlushFunction m_flush;
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    bool m_running;
+    int m_periodMs;
+    int m_heartbeatMs;
+    mutable std::mutex m_statsMutex;
+    Stats m_stats;
+};
@@ -0,0 +1,397 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <complex>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <map>
+#include <stdexcept>
+#include "cpu_features.h"
+
+#if defined(LA_HAVE_X86)
+#include <emmintrin.h>
+#define LA_FFT_SSE2 1
+#endif
+
+// Optional FFTW backend: build with LA_USE_FFTW defined and link against the
+// FFTW import library (fftw3.dll ships next to main.exe).
+#ifdef LA_USE_FFTW
+#include <fftw3.h>
+#endif
+
+// Planned FFT for one power-of-two size.
+// Twiddles and the bit-reverse permutation are computed once per size; the
+// transform itself runs radix-4 (radix-2^2) passes with SSE2 complex
+// butterflies. Sign convention matches the original MultiLogicAnalyzer::fft:
+// sign = +1 uses e^{+i..} and is unscaled, sign = -1 uses e^{-i..} and
+// scales the result by 1/N.
+class FftPlan
+{
+public:
+    explicit FftPlan(size_t n, bool withRealPath = true) : m_size(n), m_log2(0)
+    {
+        if (n < 1 || (n & (n - 1)) != 0)
+        {
+            throw std::invalid_argument("FFT size must be a power of two: " + std::to_string(n));
+        }
+        while ((static_cast<size_t>(1) << m_log2) < n)
+        {
+            m_log2++;
+        }
+
+        buildBitReverse();
+        buildTwiddles();
+
+        if (withRealPath && n >= 4)
+        {
+            m_half.reset(new FftPlan(n / 2, false));
+        }
+
+#ifdef LA_USE_FFTW
+        createFftwPlans();
+#endif
+    }
+
+    ~FftPlan()
+    {
+#ifdef LA_USE_FFTW
+        std::lock_guard<std::mutex> lock(fftwPlannerMutex());
+        if (m_fftwPositive)
+            fftw_destroy_plan(m_fftwPositive);
+        if (m_fftwNegative)
+            fftw_destroy_plan(m_fftwNegative);
+#endif
+    }
+
+    FftPlan(const FftPlan &) = delete;
+    FftPlan &operator=(const FftPlan &) = delete;
+
+    size_t size() const
+    {
+        return m_size;
+    }
+
+    // In-place complex transform of m_size points
+    void transform(std::complex<double> *x, int sign) const
+    {
+        if (m_size <= 1)
+            return;
+
+        run(x, sign > 0);
+
+        if (sign < 0)
+        {
+            const double scale = 1.0 / static_cast<double>(m_size);
+            double *values = reinterpret_cast<double *>(x);
+            for (size_t i = 0; i < 2 * m_size; i++)
+            {
+                values[i] *= scale;
+            }
+        }
+    }
+
+    // Transform of real input: packs the signal into a half-size complex FFT
+    // and untangles the spectrum, roughly halving the work of transform().
+    // out receives all m_size bins with the same sign/scaling convention.
+    void transformReal(const double *in, std::complex<double> *out, int sign) const
+    {
+        if (!m_half)
+        {
+            for (size_t i = 0; i < m_size; i++)
+            {
+                out[i] = std::complex<double>(in[i], 0.0);
+            }
+            transform(out, sign);
+            return;
+        }
+
+        const size_t half = m_size / 2;
+        for (size_t m = 0; m < half; m++)
+        {
+            out[m] = std::complex<double>(in[2 * m], in[2 * m + 1]);
+        }
+        // Standard (e^{-i..}) half-size transform without scaling
+        m_half->run(out, false);
+
+        // Split Z into the spectrum of the even and odd samples; W = e^{-2 pi i k / N}
+        // is the last-stage twiddle table of this plan
+        const std::complex<double> *w = m_twiddlesNegative.data() + (half - 1);
+        const std::complex<double> z0 = out[0];
+        out[0] = std::complex<double>(z0.real() + z0.imag(), 0.0);
+        out[half] = std::complex<double>(z0.real() - z0.imag(), 0.0);
+        for (size_t k = 1; k <= half / 2; k++)
+        {
+            const size_t j = half - k;
+            const std::complex<double> zk = out[k];
+            const std::complex<double> zj = out[j];
+
+            const std::complex<double> evenK = 0.5 * (zk + std::conj(zj));
+            const std::complex<double> oddK = std::complex<double>(0.0, -0.5) * (zk - std::conj(zj));
+            const std::complex<double> evenJ = 0.5 * (zj + std::conj(zk));
+            const std::complex<double> oddJ = std::complex<double>(0.0, -0.5) * (zj - std::conj(zk));
+
+            out[k] = evenK + w[k] * oddK;
+            out[j] = evenJ + w[j] * oddJ;
+        }
+        for (size_t k = 1; k < half; k++)
+        {
+            out[m_size - k] = std::conj(out[k]);
+        }
+
+        // For real input the e^{+i..} transform is the conjugate of the standard one
+        if (sign > 0)
+        {
+            conjugate(out, m_size);
+        }
+        else
+        {
+            const double scale = 1.0 / static_cast<double>(m_size);
+            for (size_t i = 0; i < m_size; i++)
+            {
+                out[i] *= scale;
+            }
+        }
+    }
+
+private:
+    // Unscaled transform; positive selects the e^{+i..} kernel
+    void run(std::complex<double> *x, bool positive) const
+    {
+#ifdef LA_USE_FFTW
+        fftw_complex *data = reinterpret_cast<fftw_complex *>(x);
+        fftw_execute_dft(positive ? m_fftwPositive : m_fftwNegative, data, data);
+#else
+        permute(x);
+        const std::complex<double> *twiddles = positive ? m_twiddlesPositive.data() : m_twiddlesNegative.data();
+
+        size_t s = 1;
+        if (m_log2 & 1)
+        {
+            radix2Pass(x, twiddles, s);
+            s = 2;
+        }
+        for (; s < m_size; s <<= 2)
+        {
+            radix4Pass(x, twiddles, s);
+        }
+#endif
+    }
+
+    static void conjugate(std::complex<double> *x, size_t count)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            x[i] = std::conj(x[i]);
+        }
+    }
+
+    void buildBitReverse()
+    {
+        // Store only the (i, j) pairs with i < j that need swapping
+        for (size_t i = 0; i < m_size; i++)
+        {
+            size_t reversed = 0;
+            for (int b = 0; b < m_log2; b++)
+            {
+                if (i & (static_cast<size_t>(1) << b))
+                    reversed |= static_cast<size_t>(1) << (m_log2 - 1 - b);
+            }
+            if (i < reversed)
+            {
+                m_swapPairs.push_back(static_cast<uint32_t>(i));
+                m_swapPairs.push_back(static_cast<uint32_t>(reversed));
+            }
+        }
+    }
+
+    // Stage with half-size s uses W_s[j] = e^{-i pi j / s}, j < s; the tables
+    // for s = 1, 2, 4, ... are stored back to back starting at offset s - 1
+    void buildTwiddles()
+    {
+        m_twiddlesNegative.resize(m_size > 1 ? m_size - 1 : 0);
+        m_twiddlesPositive.resize(m_twiddlesNegative.size());
+        for (size_t s = 1; s < m_size; s <<= 1)
+        {
+            for (size_t j = 0; j < s; j++)
+            {
+                const double theta = PI * static_cast<double>(j) / static_cast<double>(s);
+                m_twiddlesNegative[s - 1 + j] = std::complex<double>(std::cos(theta), -std::sin(theta));
+                m_twiddlesPositive[s - 1 + j] = std::complex<double>(std::cos(theta), std::sin(theta));
+            }
+        }
+    }
+
+    void permute(std::complex<double> *x) const
+    {
+        for (size_t p = 0; p < m_swapPairs.size(); p += 2)
+        {
+            std::swap(x[m_swapPairs[p]], x[m_swapPairs[p + 1]]);
+        }
+    }
+
+#ifdef LA_FFT_SSE2
+    typedef __m128d Complex2;
+
+    static Complex2 load(const std::complex<double> *p)
+    {
+        return _mm_loadu_pd(reinterpret_cast<const double *>(p));
+    }
+
+    static void store(std::complex<double> *p, Complex2 v)
+    {
+        _mm_storeu_pd(reinterpret_cast<double *>(p), v);
+    }
+
+    static Complex2 add(Complex2 a, Complex2 b)
+    {
+        return _mm_add_pd(a, b);
+    }
+
+    static Complex2 sub(Complex2 a, Complex2 b)
+    {
+        return _mm_sub_pd(a, b);
+    }
+
+    // (ar + i ai)(wr + i wi) using only SSE2
+    static Complex2 mul(Complex2 a, Complex2 w)
+    {
+        const __m128d wr = _mm_unpacklo_pd(w, w);
+        const __m128d wi = _mm_unpackhi_pd(w, w);
+        const __m128d swapped = _mm_shuffle_pd(a, a, 1);
+        const __m128d negateReal = _mm_set_pd(0.0, -0.0);
+        const __m128d cross = _mm_xor_pd(_mm_mul_pd(swapped, wi), negateReal);
+        return _mm_add_pd(_mm_mul_pd(a, wr), cross);
+    }
+#else
+    typedef std::complex<double> Complex2;
+
+    static Complex2 load(const std::complex<double> *p)
+    {
+        return *p;
+    }
+
+    static void store(std::complex<double> *p, Complex2 v)
+    {
+        *p = v;
+    }
+
+    static Complex2 add(Complex2 a, Complex2 b)
+    {
+        return a + b;
+    }
+
+    static Complex2 sub(Complex2 a, Complex2 b)
+    {
+        return a - b;
+    }
+
+    static Complex2 mul(Complex2 a, Complex2 w)
+    {
+        return a * w;
+    }
+#endif
+
+    // Single radix-2 stage with half-size s
+    void radix2Pass(std::complex<double> *x, const std::complex<double> *twiddles, size_t s) const
+    {
+        const std::complex<double> *w = twiddles + (s - 1);
+        const size_t m = s << 1;
+        for (size_t k = 0; k < m_size; k += m)
+        {
+            for (size_t j = 0; j < s; j++)
+            {
+                const Complex2 a = load(x + k + j);
+                const Complex2 t = mul(load(x + k + j + s), load(w + j));
+                store(x + k + j, add(a, t));
+                store(x + k + j + s, sub(a, t));
+            }
+        }
+    }
+
+    // Two radix-2 stages (half-sizes s and 2s) fused into one pass over memory
+    void radix4Pass(std::complex<double> *x, const std::complex<double> *twiddles, size_t s) const
+    {
+        const std::complex<double> *w1 = twiddles + (s - 1);
+        const std::complex<double> *w2 = twiddles + (2 * s - 1);
+        const size_t m = s << 2;
+        for (size_t k = 0; k < m_size; k += m)
+        {
+            std::complex<double> *p0 = x + k;
+            std::complex<double> *p1 = p0 + s;
+            std::complex<double> *p2 = p1 + s;
+            std::complex<double> *p3 = p2 + s;
+            for (size_t j = 0; j < s; j++)
+            {
+                const Complex2 t1 = load(w1 + j);
+                const Complex2 a = load(p0 + j);
+                const Complex2 b = mul(load(p1 + j), t1);
+                const Complex2 c = load(p2 + j);
+                const Complex2 d = mul(load(p3 + j), t1);
+
+                const Complex2 a1 = add(a, b);
+                const Complex2 b1 = sub(a, b);
+                const Complex2 c1 = mul(add(c, d), load(w2 + j));
+                const Complex2 d1 = mul(sub(c, d), load(w2 + j + s));
+
+                store(p0 + j, add(a1, c1));
+                store(p2 + j, sub(a1, c1));
+                store(p1 + j, add(b1, d1));
+                store(p3 + j, sub(b1, d1));
+            }
+        }
+    }
+
+#ifdef LA_USE_FFTW
+    static std::mutex &fftwPlannerMutex()
+    {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    // The FFTW planner is not thread-safe, executing a plan with new arrays is
+    void createFftwPlans()
+    {
+        std::lock_guard<std::mutex> lock(fftwPlannerMutex());
+        std::vector<std::complex<double>> scratch(m_size);
+        fftw_complex *data = reinterpret_cast<fftw_complex *>(scratch.data());
+        const unsigned flags = FFTW_ESTIMATE | FFTW_UNALIGNED;
+        m_fftwPositive = fftw_plan_dft_1d(static_cast<int>(m_size), data, data, FFTW_BACKWARD, flags);
+        m_fftwNegative = fftw_plan_dft_1d(static_cast<int>(m_size), data, data, FFTW_FORWARD, flags);
+    }
+
+    fftw_plan m_fftwPositive = nullptr;
+    fftw_plan m_fftwNegative = nullptr;
+#endif
+
+    static constexpr double PI = 3.14159265358979323846;
+
+    size_t m_size;
+    int m_log2;
+    std::vector<uint32_t> m_swapPairs;
+    std::vector<std::complex<double>> m_twiddlesNegative; // e^{-i..} stage tables
+    std::vector<std::complex<double>> m_twiddlesPositive; // e^{+i..} stage tables
+    std::unique_ptr<FftPlan> m_half;                      // Half-size plan for real input
+};
+
+// Process-wide cache of FFT plans keyed by size
+class FftPlanCache
+{
+public:
+    static std::shared_ptr<const FftPlan> get(size_t n)
+    {
+        static std::mutex mutex;
+        static std::map<size_t, std::shared_ptr<const FftPlan>> plans;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = plans.find(n);
+        if (it != plans.end())
+        {
+            return it->second;
+        }
+        std::shared_ptr<const FftPlan> plan = std::make_shared<FftPlan>(n);
+        plans[n] = plan;
+        return plan;
+    }
+};
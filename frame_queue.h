@@ -0,0 +1,154 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <chrono>
+#include "capture_frame.h"
+
+// Bounded hand-off queue between a device's capture stage and its analysis
+// stage. When analysis falls behind, the oldest queued frame is dropped so the
+// capture side never blocks and analysis always works on recent data.
+class BoundedFrameQueue
+{
+public:
+    explicit BoundedFrameQueue(size_t capacity = 4)
+        : m_capacity(capacity < 1 ? 1 : capacity), m_closed(false), m_finishing(false),
+          m_pushedFrames(0), m_droppedFrames(0), m_depth(0), m_maxDepth(0)
+    {
+    }
+
+    // Queue a frame; returns false if an older frame had to be dropped
+    bool push(const CaptureFramePtr &frame)
+    {
+        bool dropped = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_closed)
+            {
+                return false;
+            }
+            if (m_frames.size() >= m_capacity)
+            {
+                m_frames.pop_front();
+                m_droppedFrames++;
+                dropped = true;
+            }
+            m_frames.push_back(frame);
+            m_pushedFrames++;
+            updateDepth();
+        }
+        m_condition.notify_one();
+        return !dropped;
+    }
+
+    // Wait for the next frame; returns false once the queue is closed, or
+    // finished and empty
+    bool pop(CaptureFramePtr &frame)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_condition.wait(lock, [this]
+                         { return m_closed || m_finishing || !m_frames.empty(); });
+        if (m_closed || m_frames.empty())
+        {
+            return false;
+        }
+        frame = std::move(m_frames.front());
+        m_frames.pop_front();
+        updateDepth();
+        return true;
+    }
+
+    // Wake the consumer and discard anything still queued
+    void close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_closed = true;
+            m_frames.clear();
+            updateDepth();
+        }
+        m_condition.notify_all();
+    }
+
+    // No more frames will come: the consumer still gets everything queued
+    // before pop() returns false
+    void finish()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_finishing = true;
+        }
+        m_condition.notify_all();
+    }
+
+    // Make a closed queue usable again, optionally with a new capacity
+    void reopen(size_t capacity)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_capacity = capacity < 1 ? 1 : capacity;
+        m_frames.clear();
+        m_closed = false;
+        m_finishing = false;
+        updateDepth();
+    }
+
+    size_t capacity() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_capacity;
+    }
+
+    size_t depth() const
+    {
+        return m_depth.load(std::memory_order_relaxed);
+    }
+
+    size_t maxDepth() const
+    {
+        return m_maxDepth.load(std::memory_order_relaxed);
+    }
+
+    uint64_t pushedFrames() const
+    {
+        return m_pushedFrames.load(std::memory_order_relaxed);
+    }
+
+    uint64_t droppedFrames() const
+    {
+        return m_droppedFrames.load(std::memory_order_relaxed);
+    }
+
+    void resetCounters()
+    {
+        m_pushedFrames = 0;
+        m_droppedFrames = 0;
+        m_maxDepth = m_depth.load();
+    }
+
+private:
+    // Called with m_mutex held
+    void updateDepth()
+    {
+        const size_t depth = m_frames.size();
+        m_depth.store(depth, std::memory_order_relaxed);
+        if (depth > m_maxDepth.load(std::memory_order_relaxed))
+        {
+            m_maxDepth.store(depth, std::memory_order_relaxed);
+        }
+    }
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::deque<CaptureFramePtr> m_frames;
+    size_t m_capacity;
+    bool m_closed;
+    bool m_finishing;
+
+    std::atomic<uint64_t> m_pushedFrames;
+    std::atomic<uint64_t> m_droppedFrames;
+    std::atomic<size_t> m_depth;
+    std::atomic<size_t> m_maxDepth;
+};
@@ -0,0 +1,325 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#ifdef _WIN32
+#include <windows.h>
+#undef max
+#undef min
+#endif
+
+// Binary live-state file, rewritten by the exporter next to the text outputs
+// so readers get every device in one fixed-layout read instead of parsing
+// CSV. Little-endian, all offsets from the start of the file:
+//
+//   LiveStateHeader
+//   LiveStateDevice  [deviceCount]                            at deviceTableOffset
+//   LiveStateChannel [deviceCount][channelsPerDevice]         at channelTableOffset
+//   float            [deviceCount][phaseChannels][maxSlices]  at sliceTableOffset (slice activity, %)
+//   LiveStatePhase   [deviceCount][phaseChannels]             at phaseTableOffset
+//
+// Only connected devices are listed. Readers must check magic and version
+// and use the counts and offsets from the header rather than the constants
+// below, so the tables can grow without breaking them. The file is replaced
+// atomically, so a reader never sees a partial write.
+struct LiveStateHeader
+{
+    char magic[8];              // "LALIVEST"
+    uint32_t version;           // LIVE_STATE_VERSION
+    uint32_t headerSize;        // sizeof(LiveStateHeader)
+    uint32_t deviceCount;       // Entries in the device table
+    uint32_t channelsPerDevice; // Channel table entries per device
+    uint32_t phaseChannels;     // Channels with slice activity and phase stats
+    uint32_t maxSlices;         // Slice columns per channel; a device's sliceCount says how many are used
+    uint32_t deviceTableOffset;
+    uint32_t channelTableOffset;
+    uint32_t sliceTableOffset;
+    uint32_t phaseTableOffset;
+    uint32_t fileSize;  // Total size, to reject truncated files
+    uint32_t reserved;
+    uint64_t sequence;  // Incremented on every write
+    int64_t updatedMs;  // Wall clock of the write (ms since the epoch)
+};
+
+enum LiveStateDeviceFlags
+{
+    LIVE_DEVICE_CONNECTED = 1,
+    LIVE_DEVICE_ACTIVE = 2
+};
+
+struct LiveStateDevice
+{
+    uint32_t deviceIndex;
+    uint32_t flags; // LiveStateDeviceFlags
+    uint32_t capturesCount;
+    uint32_t errorsCount;
+    uint32_t consecutiveErrors;
+    uint32_t changedMask; // Channels still highlighted as changing
+    uint32_t sliceCount;
+    uint32_t reserved;
+    uint64_t frameSequence;
+    int64_t lastCaptureMs; // Wall clock of the last frame (ms since the epoch)
+    char serialNumber[32];
+    char model[32];
+};
+
+struct LiveStateChannel
+{
+    uint32_t currentState;
+    uint32_t activityLevel; // 0-100, by how recently the channel changed
+    int32_t transitions;    // In the last frame
+    int32_t totalTransitions;
+    int64_t lastChangeMs;   // Wall clock of the last edge (ms since the epoch)
+};
+
+struct LiveStatePhase
+{
+    double meanPhase; // Radians
+    double phaseVariance;
+};
+
+static_assert(sizeof(LiveStateHeader) == 72, "live state layout");
+static_assert(sizeof(LiveStateDevice) == 112, "live state layout");
+static_assert(sizeof(LiveStateChannel) == 24, "live state layout");
+static_assert(sizeof(LiveStatePhase) == 16, "live state layout");
+
+const uint32_t LIVE_STATE_VERSION = 1;
+const uint32_t LIVE_STATE_CHANNELS = 32;
+const uint32_t LIVE_STATE_PHASE_CHANNELS = 12;
+const uint32_t LIVE_STATE_MAX_SLICES = 16;
+
+// Replace target with source in one step, so readers see either the old or
+// the new file. On Windows a reader holding the target open makes the
+// replace fail for a moment, so it is retried briefly.
+inline bool replaceFile(const std::string &source, const std::string &target)
+{
+#ifdef _WIN32
+    for (int attempt = 0; attempt < 10; attempt++)
+    {
+        if (MoveFileExA(source.c_str(), target.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+            return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    return false;
+#else
+    return std::rename(source.c_str(), target.c_str()) == 0;
+#endif
+}
+
+// Builds a live-state file in memory and writes it out atomically. The
+// buffer is kept between writes, so steady-state exports do not allocate.
+//
+//   writer.begin(deviceCount);
+//   writer.device(i) / channel(i, ch) / slices(i, ch) / phase(i, ch) = ...;
+//   writer.commit(path);
+class LiveStateWriter
+{
+public:
+    LiveStateWriter() : m_sequence(0) {}
+
+    // Start a new file with room for deviceCount devices, all fields zeroed
+    void begin(uint32_t deviceCount)
+    {
+        const size_t deviceTable = sizeof(LiveStateHeader);
+        const size_t channelTable = deviceTable + deviceCount * sizeof(LiveStateDevice);
+        const size_t sliceTable = channelTable + deviceCount * LIVE_STATE_CHANNELS * sizeof(LiveStateChannel);
+        const size_t phaseTable = sliceTable + deviceCount * LIVE_STATE_PHASE_CHANNELS * LIVE_STATE_MAX_SLICES * sizeof(float);
+        const size_t fileSize = phaseTable + deviceCount * LIVE_STATE_PHASE_CHANNELS * sizeof(LiveStatePhase);
+
+        m_buffer.assign(fileSize, 0); // Keeps its capacity, so only a larger file allocates
+        LiveStateHeader &h = header();
+        std::memcpy(h.magic, "LALIVEST", sizeof(h.magic));
+        h.version = LIVE_STATE_VERSION;
+        h.headerSize = sizeof(LiveStateHeader);
+        h.deviceCount = deviceCount;
+        h.channelsPerDevice = LIVE_STATE_CHANNELS;
+        h.phaseChannels = LIVE_STATE_PHASE_CHANNELS;
+        h.maxSlices = LIVE_STATE_MAX_SLICES;
+        h.deviceTableOffset = static_cast<uint32_t>(deviceTable);
+        h.channelTableOffset = static_cast<uint32_t>(channelTable);
+        h.sliceTableOffset = static_cast<uint32_t>(sliceTable);
+        h.phaseTableOffset = static_cast<uint32_t>(phaseTable);
+        h.fileSize = static_cast<uint32_t>(fileSize);
+    }
+
+    LiveStateDevice &device(uint32_t entry)
+    {
+        return table<LiveStateDevice>(header().deviceTableOffset)[entry];
+    }
+
+    LiveStateChannel &channel(uint32_t entry, uint32_t ch)
+    {
+        return table<LiveStateChannel>(header().channelTableOffset)[entry * LIVE_STATE_CHANNELS + ch];
+    }
+
+    // LIVE_STATE_MAX_SLICES activity values of one phase channel
+    float *slices(uint32_t entry, uint32_t ch)
+    {
+        return table<float>(header().sliceTableOffset) + (entry * LIVE_STATE_PHASE_CHANNELS + ch) * LIVE_STATE_MAX_SLICES;
+    }
+
+    LiveStatePhase &phase(uint32_t entry, uint32_t ch)
+    {
+        return table<LiveStatePhase>(header().phaseTableOffset)[entry * LIVE_STATE_PHASE_CHANNELS + ch];
+    }
+
+    // Stamp the header and replace the file at path via a temporary next to it
+    bool commit(const std::string &path)
+    {
+        LiveStateHeader &h = header();
+        h.sequence = ++m_sequence;
+        h.updatedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                          std::chrono::system_clock::now().time_since_epoch())
+                          .count();
+
+        if (path != m_path)
+        {
+            m_path = path;
+            m_temporary = path + ".tmp";
+        }
+        const std::string &temporary = m_temporary;
+        FILE *file = std::fopen(temporary.c_str(), "wb");
+        if (!file)
+        {
+            m_lastError = "Cannot create " + temporary;
+            return false;
+        }
+        const bool written = std::fwrite(m_buffer.data(), 1, m_buffer.size(), file) == m_buffer.size();
+        const bool closed = std::fclose(file) == 0;
+        if (!written || !closed)
+        {
+            m_lastError = "Cannot write " + temporary;
+            std::remove(temporary.c_str());
+            return false;
+        }
+        if (!replaceFile(temporary, path))
+        {
+            m_lastError = "Cannot replace " + path;
+            std::remove(temporary.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    uint64_t sequence() const
+    {
+        return m_sequence;
+    }
+
+    std::string getLastError() const
+    {
+        return m_lastError;
+    }
+
+private:
+    LiveStateHeader &header()
+    {
+        return *reinterpret_cast<LiveStateHeader *>(m_buffer.data());
+    }
+
+    template <typename T>
+    T *table(uint32_t offset)
+    {
+        return reinterpret_cast<T *>(m_buffer.data() + offset);
+    }
+
+    std::vector<unsigned char> m_buffer;
+    std::string m_path;      // Last file committed
+    std::string m_temporary; // ... and its temporary
+    uint64_t m_sequence;
+    std::string m_lastError;
+};
+
+// Read-only view of a live-state file already in memory. The caller keeps
+// the bytes alive; accessors return pointers into them.
+class LiveStateView
+{
+public:
+    LiveStateView() : m_data(nullptr), m_size(0) {}
+
+    // Check magic, version and that every table fits in size bytes
+    bool parse(const void *data, size_t size)
+    {
+        m_data = static_cast<const unsigned char *>(data);
+        m_size = size;
+        if (size < sizeof(LiveStateHeader))
+        {
+            m_lastError = "File too short for a live-state header";
+            return false;
+        }
+        const LiveStateHeader &h = header();
+        if (std::memcmp(h.magic, "LALIVEST", sizeof(h.magic)) != 0)
+        {
+            m_lastError = "Not a live-state file";
+            return false;
+        }
+        if (h.version != LIVE_STATE_VERSION)
+        {
+            m_lastError = "Unsupported live-state version " + std::to_string(h.version);
+            return false;
+        }
+        const uint64_t devices = h.deviceCount;
+        if (h.fileSize > size ||
+            !fits(h.deviceTableOffset, devices * sizeof(LiveStateDevice)) ||
+            !fits(h.channelTableOffset, devices * h.channelsPerDevice * sizeof(LiveStateChannel)) ||
+            !fits(h.sliceTableOffset, devices * h.phaseChannels * h.maxSlices * sizeof(float)) ||
+            !fits(h.phaseTableOffset, devices * h.phaseChannels * sizeof(LiveStatePhase)))
+        {
+            m_lastError = "Truncated live-state file";
+            return false;
+        }
+        return true;
+    }
+
+    const LiveStateHeader &header() const
+    {
+        return *reinterpret_cast<const LiveStateHeader *>(m_data);
+    }
+
+    const LiveStateDevice &device(uint32_t entry) const
+    {
+        return table<LiveStateDevice>(header().deviceTableOffset)[entry];
+    }
+
+    const LiveStateChannel &channel(uint32_t entry, uint32_t ch) const
+    {
+        return table<LiveStateChannel>(header().channelTableOffset)[entry * header().channelsPerDevice + ch];
+    }
+
+    const float *slices(uint32_t entry, uint32_t ch) const
+    {
+        const LiveStateHeader &h = header();
+        return table<float>(h.sliceTableOffset) + (entry * h.phaseChannels + ch) * h.maxSlices;
+    }
+
+    const LiveStatePhase &phase(uint32_t entry, uint32_t ch) const
+    {
+        return table<LiveStatePhase>(header().phaseTableOffset)[entry * header().phaseChannels + ch];
+    }
+
+    std::string getLastError() const
+    {
+        return m_lastError;
+    }
+
+private:
+    bool fits(uint64_t offset, uint64_t bytes) const
+    {
+        return offset <= m_size && bytes <= m_size - offset;
+    }
+
+    template <typename T>
+    const T *table(uint32_t offset) const
+    {
+        return reinterpret_cast<const T *>(m_data + offset);
+    }
+
+    const unsigned char *m_data;
+    size_t m_size;
+    std::string m_lastError;
+};
@@ -2,14 +2,11 @@
 #include <iomanip>
 #include <string>
 #include <vector>
-#include <windows.h>
-#undef max
-#undef min
+#include "platform.h" // First: on Windows it includes winsock2.h before windows.h
 #include <chrono>
 #include <thread>
 #include <algorithm>
 #include <numeric>
-#include <conio.h>
 #include <unordered_set>
 #include <map>
 #include <ctime>
@@ -17,49 +14,58 @@
 #include <stdio.h>
 #include <sys/stat.h>
 #include <mutex>
-#include <queue>
 #include <atomic>
 #include <condition_variable>
 #include <sstream>
 // Removed std::filesystem dependency
-#include <direct.h> // For _mkdir on Windows
-#include <corecrt_math_defines.h>
 #include <complex>
 // Removed fftw3.h
 #include <functional>
-#include <future>
+#include <deque>
+#include "capture_frame.h"
+#include "capture_backend.h"
+#include "hantek_dll_backend.h"
+#include "synthetic_backend.h"
+#include "replay_backend.h"
+#include "capture_recording.h"
+#include "capture_archive.h"
+#include "capture_buffer_pool.h"
+#include "capture_waiter.h"
+#include "transition_counter.h"
+#include "fft_engine.h"
+#include "analytic_signal.h"
+#include "frame_queue.h"
+#include "stage_stats.h"
+#include "export_scheduler.h"
+#include "snapshot_publisher.h"
+#include "task_scheduler.h"
+#include "live_state.h"
+#include "device_snapshot.h"
+#include "output_writers.h"
+#include "results_ring.h"
+#include "push_server.h"
+#include "trace.h"
+#include "console_screen.h"
 
 // Forward declarations
 class HantekDevice;
 class MultiLogicAnalyzer;
 
 // Constants for brain visualization output
-const std::string OUTPUT_DIRECTORY = "C:\\Ashvajeet\\FULL_Setup\\brain-viz\\public\\data";
+#ifdef _WIN32
+const std::string DEFAULT_OUTPUT_DIRECTORY = "C:\\Ashvajeet\\FULL_Setup\\brain-viz\\public\\data";
+#else
+const std::string DEFAULT_OUTPUT_DIRECTORY = "public/data"; // The visualizer's data folder, run from the repo root
+#endif
 const std::string OUTPUT_FILENAME = "logic_data.txt";
+const std::string LIVE_STATE_FILENAME = "live_state.bin"; // Binary form of all three text outputs (live_state.h)
+const std::string STATS_FILENAME = "pipeline_stats.json";   // Stage latencies and throughput, rewritten periodically
 
 // Device connection constants
 const int MAX_DEVICES = 12;
 const int MAX_RETRIES = 1;
 const int CONNECTION_TIMEOUT_MS = 100;
-// Trigger settings structure
-struct TriggerSettings
-{
-    unsigned short nEdgeSignal;
-    unsigned short nEdgeSlope;
-    short Intr_Range;
-    unsigned long Range_Max;
-    unsigned long Range_Min;
-    unsigned long Range_Sh;
-    unsigned short Range_Mo;
-    short Intr_Time;
-    unsigned long Time_Max;
-    unsigned long Time_Min;
-    unsigned short Time_Mo;
-    short Intr_Equ;
-    unsigned long Equ_Sh;
-    unsigned long Equ_Dat;
-    unsigned short Equ_So;
-};
+const int HEADLESS_STATUS_SECONDS = 30; // Time between status lines of a headless run
 
 // Configuration structure
 struct AnalyzerConfig
@@ -74,12 +80,22 @@ struct AnalyzerConfig
     std::string configFilePath;
     std::string serialNumber; // Added for device identification
     std::string model;        // Added for device info
+    int frameHistory;         // Number of previous capture frames kept per device
+    AnalysisLayout analysisLayout; // Layout the channel analysis reads from
+    bool pipelineMode;        // Overlap the next capture with analysis of the previous frame
+    int pipelineQueueDepth;   // Frames buffered between capture and analysis in pipeline mode
+    int bufferPoolSize;       // Capture buffers per device, 0 = derived from history/pipeline depth
+    BufferPoolPolicy bufferPoolPolicy; // Behaviour when every capture buffer is in use
+    BufferPoolMemory bufferPoolMemory; // Page type backing the capture buffers
 
     // Default values
     AnalyzerConfig()
         : sampleRateCode(8), sampleDepth(100000), scanIntervalMs(100), voltageThreshold(1.7),
           enableTrigger(false), triggerChannel(0), triggerRisingEdge(true),
-          configFilePath("logic_config.txt"), serialNumber("Unknown"), model("Unknown")
+          configFilePath("logic_config.txt"), serialNumber("Unknown"), model("Unknown"),
+          frameHistory(0), analysisLayout(AnalysisLayout::PACKED),
+          pipelineMode(false), pipelineQueueDepth(4),
+          bufferPoolSize(0), bufferPoolPolicy(BufferPoolPolicy::BLOCK), bufferPoolMemory(BufferPoolMemory::NORMAL)
     {
     }
 
@@ -90,11 +106,14 @@ struct AnalyzerConfig
                 sampleDepth >= 1000 && sampleDepth <= 32000000 &&
                 scanIntervalMs >= 10 && scanIntervalMs <= 5000 &&
                 voltageThreshold >= 0.5 && voltageThreshold <= 5.0 &&
-                triggerChannel <= 31);
+                triggerChannel <= 31 &&
+                frameHistory >= 0 && frameHistory <= 64 &&
+                pipelineQueueDepth >= 1 && pipelineQueueDepth <= 64 &&
+                bufferPoolSize >= 0 && bufferPoolSize <= 256);
     }
 };
 
-// Console colors utility
+// Console colors (Windows palette), as ConsoleScreen::setColor takes them
 class ConsoleColors
 {
 public:
@@ -117,23 +136,13 @@ public:
         YELLOW = 14,
         WHITE = 15
     };
-
-    static void setColor(Color text, Color background = BLACK)
-    {
-        SetConsoleTextAttribute(GetStdHandle(STD_OUTPUT_HANDLE), (background << 4) | text);
-    }
-
-    static void resetColor()
-    {
-        setColor(LIGHTGRAY);
-    }
 };
 
 // --- Signal analysis structures ---
 // Enhanced channel data structure
 struct ChannelData
 {
-    std::vector<uint32_t> samples;
+    CaptureFramePtr frame; // Shared latest capture frame (not copied per channel)
     bool changed;
     uint32_t currentState;
     int transitions;
@@ -143,6 +152,8 @@ struct ChannelData
     std::vector<double> sliceActivityLevels; // Activity level per slice (0-100)
     double meanPhase = 0.0;        // Mean phase for quick display
     double phaseVariance = 0.0;    // Phase stability metric
+    double dutyCycle = -1.0;       // Percent of the frame spent high; -1 = not measured (packed layout)
+    double meanHighPulseUs = -1.0; // Mean width of complete high pulses; -1 = not measured (edges layout only)
 
     ChannelData() : changed(false), currentState(0), transitions(0), totalTransitions(0)
     {
@@ -161,19 +172,26 @@ struct DeviceState
     int errorsCount;
     std::vector<ChannelData> channelData;
     std::map<int, std::chrono::system_clock::time_point> changedChannels;
+    std::deque<CaptureFramePtr> frameHistory;              // Previous frames, newest last
     std::string serialNumber;                              // Added for device identification
     std::string model;                                     // Added for device info
     std::string firmwareVersion;                           // Added for device info
     std::chrono::system_clock::time_point lastCaptureTime; // Added for tracking capture times
+    unsigned captureResetGeneration;                       // Statistics resets seen by the capture thread
+    unsigned analysisResetGeneration;                      // ... and by the analysis thread
 
     DeviceState() : connected(false), active(false), consecutiveErrors(0),
-                    capturesCount(0), errorsCount(0),
-                    serialNumber("Unknown"), model("Unknown"), firmwareVersion("Unknown")
+                    capturesCount(0), errorsCount(0), serialNumber("Unknown"), model("Unknown"),
+                    firmwareVersion("Unknown"), captureResetGeneration(0), analysisResetGeneration(0)
     {
         channelData.resize(32);
     }
 };
 
+static_assert(SNAPSHOT_MAX_SLICES <= LIVE_STATE_MAX_SLICES && PHASE_CHANNELS <= LIVE_STATE_PHASE_CHANNELS,
+              "live_state.bin must have room for every exported slice and phase channel");
+static_assert(SNAPSHOT_MAX_SLICES <= 16 && PHASE_CHANNELS <= 12, "ResultsRecord must have room for every slice and phase channel");
+
 // Connection result structure - from paste-2.txt
 struct ConnectionResult
 {
@@ -184,190 +202,119 @@ struct ConnectionResult
 
     ConnectionResult() : success(false), connectionTime(0.0) {}
 };
+// How the devices are brought up at startup
+enum class ConnectMode
+{
+    SEQUENTIAL, // One device after another
+    PARALLEL    // Several devices at once, bounded by connectConcurrency
+};
+
+// Where captures come from
+enum class BackendKind
+{
+    HANTEK,    // Hantek 4032L hardware through HTLAHard.dll
+    SYNTHETIC, // Generated signals (see SyntheticBackend), no hardware needed
+    REPLAY     // Frames recorded earlier with --record (see ReplayBackend)
+};
+
+// Process-wide options given as --key=value on the command line
+struct RuntimeOptions
+{
+    ConnectMode connectMode;
+    int connectConcurrency; // Devices brought up at once in parallel mode
+    int connectDeadlineMs;  // Bring-up time per device, checked between connect, init and configuration (a hung DLL call is not cut short)
+    BackendKind backend;
+    std::string syntheticSpec;   // Signal spec file for the synthetic backend
+    std::string recordDirectory; // Write every captured frame here; empty = no recording
+    std::string replayDirectory; // Recording played back by the replay backend
+    std::string archiveDirectory; // Compressed archive of every captured frame; empty = no archive
+    ReplayPacing replayPacing;
+    int replayLoops; // Passes over the recording before the replay ends
+    int exportIntervalMs; // Minimum time between rewrites of the output files
+    int schedulerThreads; // Workers for phase analysis fan-out; 0 = run on the device threads, -1 = one per core
+    bool pinThreads;      // Pin each scheduler worker to its own core
+    bool textExports;     // Also write the text outputs (logic_data, phase_data, time_sliced_data)
+    std::string resultsRing;     // Shared-memory ring of per-frame results; off unless named
+    int resultsRingCapacity;     // Records the ring holds (power of two)
+    int pushPort;                // Localhost WebSocket/HTTP port for live deltas; 0 = off
+    std::string pushOrigin;      // Dashboard origin browsers may use the push server from; empty = same host
+    int statsIntervalMs;         // Time between rewrites of pipeline_stats.json; 0 = never
+    bool trace;                  // Record a Chrome trace timeline, dumped on 'T' and at exit
+    bool headless;               // No console display or keyboard; runs until SIGINT/SIGTERM
+    std::string outputDirectory; // Where the files for the visualizer are written
+    int displayIntervalMs;       // Time between console refreshes
+
+    RuntimeOptions() : connectMode(ConnectMode::SEQUENTIAL), connectConcurrency(4), connectDeadlineMs(5000),
+                       backend(BackendKind::HANTEK), syntheticSpec("synthetic_signals.txt"), replayDirectory("recording"),
+                       replayPacing(ReplayPacing::FAST), replayLoops(1), exportIntervalMs(200),
+                       schedulerThreads(-1), pinThreads(false), textExports(true),
+                       resultsRing(), resultsRingCapacity(1024), pushPort(0), pushOrigin(),
+                       statsIntervalMs(1000), trace(false), headless(false),
+                       outputDirectory(DEFAULT_OUTPUT_DIRECTORY), displayIntervalMs(200) {}
+};
+
 // Hantek device class
+// Capture bookkeeping for one device (frames, buffer pool, completion waiting,
+// recovery) on top of the CaptureBackend that talks to the hardware or to a
+// stand-in source.
 class HantekDevice
 {
 public:
-    HantekDevice() : m_dll(nullptr), m_deviceIndex(0), m_sampleRate(0), m_sampleDepth(0),
+    HantekDevice() : m_deviceIndex(0), m_sampleRate(0), m_sampleDepth(0),
+                     m_completionWaiter(new CaptureCompletionWaiter()),
                      m_serialNumber("Unknown"), m_model("Unknown"), m_firmwareVersion("Unknown") {}
 
-    ~HantekDevice()
+    // Use the given backend; without one, open() falls back to the vendor DLL
+    void setBackend(std::shared_ptr<CaptureBackend> backend)
     {
-        if (m_dll)
-        {
-            FreeLibrary(m_dll);
-            m_dll = nullptr;
-        }
+        m_backend = std::move(backend);
     }
 
-    bool loadDLL(const std::string &dllPath)
+    const char *getBackendName() const
     {
-        if (m_dll)
-        {
-            FreeLibrary(m_dll);
-            m_dll = nullptr;
-        }
-
-        m_dll = LoadLibraryA(dllPath.c_str());
+        return m_backend ? m_backend->name() : "none";
+    }
 
-        if (!m_dll)
+    // Load the DLL (or open the backend's source) at location
+    bool open(const std::string &location)
+    {
+        if (!m_backend)
         {
-            DWORD error = GetLastError();
-            m_lastError = "Failed to load DLL: " + dllPath + " (Error code: " + std::to_string(error) + ")";
-            return false;
-        }
-
-        // Load function pointers
-        m_DevConnect = (DevConnectFunc)GetProcAddress(m_dll, "DevConnect");
-        m_InitDevice = (InitDeviceFunc)GetProcAddress(m_dll, "InitDevice");
-        m_SetCmdLA = (SetCmdLAFunc)GetProcAddress(m_dll, "SetCmdLA");
-        m_SetSampleRate = (SetSampleRateFunc)GetProcAddress(m_dll, "Set_Sample_Rate");
-        m_SetSampleDepth = (SetSampleDepthFunc)GetProcAddress(m_dll, "Set_SampleDepth");
-        m_SetTrigEn = (SetTrigEnFunc)GetProcAddress(m_dll, "Set_Trig_En");
-        m_SetTrigParameter = (SetTrigParameterFunc)GetProcAddress(m_dll, "Set_Trig_Parameter");
-        m_ReadCollectStatus = (ReadCollectStatusFunc)GetProcAddress(m_dll, "ReadCollectStatus");
-        m_ReadLogicData = (ReadLogicDataFunc)GetProcAddress(m_dll, "ReadLogicData");
-        m_ReadSrcData = (ReadSrcDataFunc)GetProcAddress(m_dll, "ReadSrcData");
-        m_SetPreTri = (SetPreTriFunc)GetProcAddress(m_dll, "Set_Pre_Tri");
-
-        // Optional function for voltage level setting (might not be available in all DLLs)
-        m_SetPWMV = (SetPWMVFunc)GetProcAddress(m_dll, "Set_PWMV");
-
-        // Check if mandatory functions loaded successfully
-        if (!m_DevConnect || !m_InitDevice || !m_SetCmdLA || !m_SetSampleRate ||
-            !m_SetSampleDepth || !m_SetTrigEn || !m_SetTrigParameter ||
-            !m_ReadCollectStatus || !m_ReadLogicData)
-        {
-            m_lastError = "Failed to load one or more required functions from DLL";
-            return false;
+            m_backend = std::make_shared<HantekDllBackend>();
         }
+        return check(m_backend->open(location));
+    }
 
-        return true;
+    // Release the backend (for hardware, unload the DLL); open() starts over
+    void close()
+    {
+        m_backend.reset();
     }
 
     bool connect(unsigned short deviceIndex = 0)
     {
-        if (!m_DevConnect)
-        {
-            m_lastError = "DevConnect function not loaded";
+        if (!hasBackend())
             return false;
-        }
 
         m_deviceIndex = deviceIndex;
-
-        // Modified to try only once with a 1-second timeout
-        auto startTime = std::chrono::steady_clock::now();
-        const auto timeout = std::chrono::seconds(1);
-
-        bool result = false;
-
-        try
-        {
-            result = m_DevConnect(deviceIndex);
-        }
-        catch (...)
-        {
-            m_lastError = "Exception during DevConnect";
+        if (!check(m_backend->connect(deviceIndex)))
             return false;
-        }
-
-        if (result)
-        {
-            // Generate device info if connection succeeds
-            generateDeviceInfo();
-            return true;
-        }
-
-        // If not successful in first attempt, check if we're still within timeout
-        auto elapsed = std::chrono::steady_clock::now() - startTime;
-        if (elapsed < timeout)
-        {
-            // We have some time left, try one more time
-            std::this_thread::sleep_for(std::chrono::milliseconds(200));
-            try
-            {
-                result = m_DevConnect(deviceIndex);
-            }
-            catch (...)
-            {
-                m_lastError = "Exception during DevConnect retry";
-                return false;
-            }
-
-            if (result)
-            {
-                // Generate device info if connection succeeds
-                generateDeviceInfo();
-                return true;
-            }
-        }
-
-        m_lastError = "Failed to connect to device index " + std::to_string(deviceIndex) + " within timeout";
-        return false;
-    }
 
-    void generateDeviceInfo()
-    {
-        // Generate mock device info since the real API doesn't seem to provide it
-        std::vector<std::string> models = {"DSO2090", "DSO2150", "DSO2250", "DSO6022BE"};
-        m_serialNumber = "HT" + std::to_string(1000 + m_deviceIndex);
-        m_model = models[m_deviceIndex % models.size()];
-        m_firmwareVersion = "v2.1." + std::to_string(10 + m_deviceIndex);
+        m_serialNumber = m_backend->serialNumber();
+        m_model = m_backend->model();
+        m_firmwareVersion = m_backend->firmwareVersion();
+        return true;
     }
 
     bool initialize()
     {
-        if (!m_InitDevice)
-        {
-            m_lastError = "InitDevice function not loaded";
-            return false;
-        }
-
-        bool result = false;
-
-        try
-        {
-            result = m_InitDevice(m_deviceIndex);
-        }
-        catch (...)
-        {
-            m_lastError = "Exception during InitDevice";
-            return false;
-        }
-
-        if (!result)
-        {
-            m_lastError = "Failed to initialize device";
-            return false;
-        }
-
-        return true;
+        return hasBackend() && check(m_backend->initialize());
     }
 
     bool setSampleRate(unsigned short rateCode)
     {
-        if (!m_SetSampleRate)
-        {
-            m_lastError = "Set_Sample_Rate function not loaded";
+        if (!hasBackend() || !check(m_backend->setSampleRate(rateCode)))
             return false;
-        }
-
-        short result = -1;
-        try
-        {
-            result = m_SetSampleRate(m_deviceIndex, rateCode);
-        }
-        catch (...)
-        {
-            m_lastError = "Exception during SetSampleRate";
-            return false;
-        }
-
-        if (result < 0)
-        {
-            m_lastError = "Failed to set sample rate (code: " + std::to_string(result) + ")";
-            return false;
-        }
 
         m_sampleRate = rateCode;
         return true;
@@ -375,28 +322,8 @@ public:
 
     bool setSampleDepth(unsigned long depth)
     {
-        if (!m_SetSampleDepth)
-        {
-            m_lastError = "Set_SampleDepth function not loaded";
-            return false;
-        }
-
-        short result = -1;
-        try
-        {
-            result = m_SetSampleDepth(m_deviceIndex, depth);
-        }
-        catch (...)
-        {
-            m_lastError = "Exception during SetSampleDepth";
-            return false;
-        }
-
-        if (result < 0)
-        {
-            m_lastError = "Failed to set sample depth (code: " + std::to_string(result) + ")";
+        if (!hasBackend() || !check(m_backend->setSampleDepth(depth)))
             return false;
-        }
 
         m_sampleDepth = depth;
         return true;
@@ -404,95 +331,18 @@ public:
 
     bool setVoltageThreshold(double threshold)
     {
-        if (m_SetPWMV)
-        {
-            short result = -1;
-            try
-            {
-                result = m_SetPWMV(m_deviceIndex, threshold, threshold);
-            }
-            catch (...)
-            {
-                m_lastError = "Exception during SetPWMV";
-                return false;
-            }
-
-            if (result < 0)
-            {
-                m_lastError = "Failed to set voltage threshold (code: " + std::to_string(result) + ")";
-                return false;
-            }
-
-            return true;
-        }
-        else
-        {
-            return true; // Optional function, not a failure if missing
-        }
+        return hasBackend() && check(m_backend->setVoltageThreshold(threshold));
     }
 
     bool configureTrigger(bool enabled, unsigned short channel = 0, bool risingEdge = true)
     {
-        if (!m_SetTrigEn || !m_SetTrigParameter)
-        {
-            m_lastError = "Trigger functions not loaded";
-            return false;
-        }
-
-        // Enable/disable trigger
-        short trigEnabled = enabled ? 1 : 0;
-        short result = -1;
-
-        try
-        {
-            result = m_SetTrigEn(m_deviceIndex, trigEnabled, 0);
-        }
-        catch (...)
-        {
-            m_lastError = "Exception during SetTrigEn";
-            return false;
-        }
-
-        if (result < 0)
-        {
-            m_lastError = "Failed to enable/disable trigger (code: " + std::to_string(result) + ")";
-            return false;
-        }
-
-        // If trigger is enabled, set parameters
-        if (enabled)
-        {
-            TriggerSettings settings = {};
-            settings.nEdgeSignal = channel;
-            settings.nEdgeSlope = risingEdge ? 1 : 0;
-
-            try
-            {
-                result = m_SetTrigParameter(m_deviceIndex, 0, (void *)&settings);
-            }
-            catch (...)
-            {
-                m_lastError = "Exception during SetTrigParameter";
-                return false;
-            }
-
-            if (result < 0)
-            {
-                m_lastError = "Failed to set trigger parameters (code: " + std::to_string(result) + ")";
-                return false;
-            }
-        }
-
-        return true;
+        return hasBackend() && check(m_backend->configureTrigger(enabled, channel, risingEdge));
     }
 
     bool startCapture()
     {
-        if (!m_SetCmdLA)
-        {
-            m_lastError = "SetCmdLA function not loaded";
+        if (!hasBackend())
             return false;
-        }
 
         if (m_sampleRate == 0 || m_sampleDepth == 0)
         {
@@ -500,107 +350,81 @@ public:
             return false;
         }
 
-        bool result = false;
-        try
-        {
-            result = m_SetCmdLA(m_deviceIndex);
-        }
-        catch (...)
-        {
-            m_lastError = "Exception during SetCmdLA";
-            return false;
-        }
+        return check(m_backend->startCapture());
+    }
 
-        if (!m_SetPreTri || m_SetPreTri(m_deviceIndex, 50) < 0)
-        {
-            m_lastError = "Pre-trigger config failed";
+    // Sleeps until just before the predicted end of the capture, then polls;
+    // see CaptureCompletionWaiter
+    bool waitForCaptureComplete(int timeoutMs = 5000)
+    {
+        if (!hasBackend())
             return false;
-        }
 
-        if (!result)
+        CaptureBackend &backend = *m_backend;
+        m_completionWaiter->setCaptureParameters(backend.isPaced() ? sampleRateFromCode(m_sampleRate) : 0, m_sampleDepth);
+        CaptureCompletionWaiter::Result result = m_completionWaiter->wait([&backend]()
+                                                                          { return backend.readStatus(); }, timeoutMs);
+
+        switch (result)
         {
-            m_lastError = "Failed to start capture";
+        case CaptureCompletionWaiter::Result::COMPLETE:
+            return true;
+        case CaptureCompletionWaiter::Result::FAILED:
+            m_lastError = backend.lastError();
+            return false;
+        default:
+            m_lastError = "Capture timeout after " + std::to_string(timeoutMs) + "ms";
             return false;
         }
+    }
 
-        return true;
+    CaptureCompletionWaiter::Stats getCaptureWaitStats() const
+    {
+        return m_completionWaiter->stats();
     }
 
-    bool waitForCaptureComplete(int timeoutMs = 5000)
+    // Read the captured samples into a new frame; the frame is filled exactly once
+    // here and then shared read-only by every consumer
+    bool readData(CaptureFramePtr &frame)
     {
-        if (!m_ReadCollectStatus)
-        {
-            m_lastError = "ReadCollectStatus function not loaded";
+        if (!hasBackend())
             return false;
-        }
 
-        auto startTime = std::chrono::steady_clock::now();
-
-        while (true)
+        // Frame buffer sized to match sample depth, borrowed from the pool when one is attached
+        std::shared_ptr<CaptureFrame> data;
+        std::shared_ptr<CaptureBufferPool> pool = std::atomic_load(&m_bufferPool);
+        if (pool && pool->samplesPerBuffer() >= m_sampleDepth)
         {
-            unsigned long status = 0;
-            try
+            std::shared_ptr<uint32_t> buffer = pool->acquire();
+            if (!buffer)
             {
-                status = m_ReadCollectStatus(m_deviceIndex);
-            }
-            catch (...)
-            {
-                m_lastError = "Exception during ReadCollectStatus";
-                return false;
-            }
-
-            if (status >= 1)
-            {
-                return true;
-            }
-
-            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
-                               std::chrono::steady_clock::now() - startTime)
-                               .count();
-
-            if (elapsed > timeoutMs)
-            {
-                m_lastError = "Capture timeout after " + std::to_string(timeoutMs) + "ms";
+                m_lastError = "No free capture buffer";
                 return false;
             }
-
-            // Check every 10ms to avoid burning CPU
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            data = CaptureFrame::wrap(std::move(buffer), m_sampleDepth);
         }
-    }
-
-    bool readData(std::vector<uint32_t> &data)
-    {
-        if (!m_ReadSrcData)
+        else
         {
-            m_lastError = "ReadLogicData function not loaded";
-            return false;
+            data = CaptureFrame::create(m_sampleDepth);
         }
 
-        // Resize data buffer to match sample depth
-        bool result = false;
-        data.resize(m_sampleDepth);
-        try
-        {
-            result = m_ReadSrcData(
-                m_deviceIndex,
-                reinterpret_cast<unsigned long *>(data.data()),
-                m_sampleDepth,
-                50 // Pre-trigger percentage (50%)
-            );
-        }
-        catch (...)
+        unsigned long samplesRead = 0;
+        if (!check(m_backend->readSamples(data->mutableData(), m_sampleDepth, samplesRead)))
         {
-            m_lastError = "Exception during ReadSrcData";
             return false;
         }
-
-        if (!result)
+        if (samplesRead == 0)
         {
-            m_lastError = "Failed to read logic data";
+            m_lastError = "Capture returned no samples";
             return false;
         }
+        // A recycled buffer still holds an older frame past what was read
+        data->truncate(samplesRead);
 
+        data->sequence = ++m_frameSequence;
+        data->sampleRateCode = m_sampleRate;
+        data->captureTime = std::chrono::system_clock::now();
+        frame = data;
         return true;
     }
 
@@ -611,7 +435,7 @@ public:
         unsigned long currentDepth = m_sampleDepth;
 
         // Attempt to disconnect and reconnect to the device
-        if (m_dll)
+        if (m_backend)
         {
             // Small delay before attempting reconnection
             std::this_thread::sleep_for(std::chrono::seconds(1));
@@ -647,17 +471,7 @@ public:
     }
     bool setPreTrigger(unsigned short percentage)
     {
-        if (m_SetPreTri)
-        {
-            short result = m_SetPreTri(m_deviceIndex, percentage);
-            if (result < 0)
-            {
-                m_lastError = "Failed to set pre-trigger";
-                return false;
-            }
-            return true;
-        }
-        return true; // Optional function
+        return hasBackend() && check(m_backend->setPreTrigger(percentage));
     }
     bool setupDevice(unsigned short rateCode, unsigned long depth, double threshold)
     {
@@ -676,11 +490,33 @@ public:
         return m_lastError;
     }
 
+    // True once a replayed recording has no frames left
+    bool isSourceExhausted() const
+    {
+        return m_backend && m_backend->isExhausted();
+    }
+
+    bool getRecordedSettings(unsigned short &rateCode, unsigned long &depth) const
+    {
+        return m_backend && m_backend->recordedSettings(rateCode, depth);
+    }
+
     unsigned long getSampleDepth() const
     {
         return m_sampleDepth;
     }
 
+    // Buffers readData borrows frames from; nullptr allocates a new buffer per frame
+    void setBufferPool(std::shared_ptr<CaptureBufferPool> pool)
+    {
+        std::atomic_store(&m_bufferPool, std::move(pool));
+    }
+
+    std::shared_ptr<CaptureBufferPool> getBufferPool() const
+    {
+        return std::atomic_load(&m_bufferPool);
+    }
+
     unsigned short getDeviceIndex() const
     {
         return m_deviceIndex;
@@ -702,100 +538,41 @@ public:
     }
 
 private:
-    // DLL handling
-    HMODULE m_dll = nullptr;
-    std::vector<HMODULE> m_dlls; // Support multiple DLL instances
+    bool hasBackend()
+    {
+        if (!m_backend)
+        {
+            m_lastError = "No capture backend opened";
+            return false;
+        }
+        return true;
+    }
+
+    // Pick up the backend's error message when a call failed
+    bool check(bool ok)
+    {
+        if (!ok)
+        {
+            m_lastError = m_backend->lastError();
+        }
+        return ok;
+    }
+
+    std::shared_ptr<CaptureBackend> m_backend;
     unsigned short m_deviceIndex = 0;
     std::string m_lastError;
 
     // Sample parameters
     unsigned short m_sampleRate = 0;
     unsigned long m_sampleDepth = 0;
+    uint64_t m_frameSequence = 0;
+    std::shared_ptr<CaptureBufferPool> m_bufferPool;
+    std::shared_ptr<CaptureCompletionWaiter> m_completionWaiter; // Calibrated per device
 
     // Device identification
     std::string m_serialNumber;
     std::string m_model;
     std::string m_firmwareVersion;
-
-    // DLL function pointers
-    typedef bool (*DevConnectFunc)(unsigned short);
-    typedef bool (*InitDeviceFunc)(unsigned short);
-    typedef bool (*SetCmdLAFunc)(unsigned short);
-    typedef short (*SetSampleRateFunc)(unsigned short, unsigned short);
-    typedef short (*SetSampleDepthFunc)(unsigned short, unsigned long);
-    typedef short (*SetTrigEnFunc)(unsigned short, short, short);
-    typedef short (*SetTrigParameterFunc)(unsigned short, unsigned short, void *);
-    typedef unsigned long (*ReadCollectStatusFunc)(unsigned short);
-    typedef bool (*ReadLogicDataFunc)(unsigned short, void *);
-    typedef short (*SetPWMVFunc)(unsigned short, double, double);
-    typedef bool (*ReadSrcDataFunc)(unsigned short, unsigned long *, unsigned long, unsigned short);
-    typedef short (*SetPreTriFunc)(unsigned short, unsigned short);
-
-    // Store function pointers
-    DevConnectFunc m_DevConnect = nullptr;
-    InitDeviceFunc m_InitDevice = nullptr;
-    SetCmdLAFunc m_SetCmdLA = nullptr;
-    SetSampleRateFunc m_SetSampleRate = nullptr;
-    SetSampleDepthFunc m_SetSampleDepth = nullptr;
-    SetTrigEnFunc m_SetTrigEn = nullptr;
-    SetTrigParameterFunc m_SetTrigParameter = nullptr;
-    ReadCollectStatusFunc m_ReadCollectStatus = nullptr;
-    ReadLogicDataFunc m_ReadLogicData = nullptr;
-    SetPWMVFunc m_SetPWMV = nullptr;
-    ReadSrcDataFunc m_ReadSrcData = nullptr;
-    SetPreTriFunc m_SetPreTri = nullptr;
-};
-
-class ThreadPool {
-public:
-    ThreadPool(size_t threads) : stop(false) {
-        for(size_t i = 0; i < threads; ++i)
-            workers.emplace_back([this] {
-                for(;;) {
-                    std::function<void()> task;
-                    {
-                        std::unique_lock<std::mutex> lock(this->queue_mutex);
-                        this->condition.wait(lock, [this]{ 
-                            return this->stop || !this->tasks.empty(); 
-                        });
-                        if(this->stop && this->tasks.empty()) return;
-                        task = std::move(this->tasks.front());
-                        this->tasks.pop();
-                    }
-                    task();
-                }
-            });
-    }
-    template<class F, class... Args>
-    auto enqueue(F&& f, Args&&... args) -> std::future<decltype(f(args...))> {
-        using return_type = decltype(f(args...));
-        auto task = std::make_shared<std::packaged_task<return_type()>>(
-            std::bind(std::forward<F>(f), std::forward<Args>(args)...)
-        );
-        std::future<return_type> res = task->get_future();
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex);
-            if(stop) throw std::runtime_error("enqueue on stopped ThreadPool");
-            tasks.emplace([task](){ (*task)(); });
-        }
-        condition.notify_one();
-        return res;
-    }
-    ~ThreadPool() {
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex);
-            stop = true;
-        }
-        condition.notify_all();
-        for(std::thread &worker: workers)
-            worker.join();
-    }
-private:
-    std::vector<std::thread> workers;
-    std::queue<std::function<void()>> tasks;
-    std::mutex queue_mutex;
-    std::condition_variable condition;
-    bool stop;
 };
 
 // Multi-Device Logic Analyzer class
@@ -805,8 +582,10 @@ private:
     enum class DisplayMode
     {
         SUMMARY, // Show summary of all devices
-        DETAILS, // Show detailed view of one device
-        ACTIVITY // Show only active channels across all devices
+        DETAILS,  // Show detailed view of one device
+        ACTIVITY, // Show only active channels across all devices
+        STATS,    // Show stage latencies and throughput
+        COUNT
     };
     struct DeviceGroup
     {
@@ -820,16 +599,25 @@ private:
     std::vector<DeviceState> m_deviceStates;
     std::vector<AnalyzerConfig> m_configs;
     std::vector<ConnectionResult> m_connectionResults;
+    RuntimeOptions m_options;
     std::atomic<bool> m_running;
     int m_numDevices;
-    int m_activeDevices;
-    std::map<int, std::string> m_channelNames;
+    std::atomic<int> m_activeDevices;
+    std::map<int, std::string> m_channelNames; // Shared by all devices' config files
+    mutable std::mutex m_channelNamesMutex;    // Config reloads rename channels while others read them
     std::chrono::system_clock::time_point m_lastConfigCheck;
     std::vector<time_t> m_lastConfigModified;
     DisplayMode m_displayMode;
     int m_detailViewDevice = 0;                              // For DETAILS mode
+    ConsoleScreen m_screen;                                  // Double-buffered console, only changed cells are written
     std::mutex m_consoleMutex;                               // Mutex for console output
     std::mutex m_fileMutex;                                  // Mutex for file output
+    LiveStateWriter m_liveState;                             // Builds live_state.bin on the exporter thread
+    std::vector<ExportedDevice> m_exportedDevices;           // Reused by the exporters (collectExportedDevices)
+    std::vector<std::string> m_exportChannelNames;           // ... and the channel names they write
+    std::string m_liveStatePath;
+    ResultsRingWriter m_resultsRing;                         // Per-frame results for other processes (results_ring.h)
+    PushServer m_pushServer;                                 // Streams per-frame deltas to the visualizer (--push-port)
     std::vector<unsigned long> m_deviceSamplingRates;        // SPS for each device
     std::vector<int> m_timeSliceCounts;                      // Number of slices per device
     std::vector<double> m_timeWindows;                       // Time window (seconds) per device
@@ -848,7 +636,16 @@ private:
         {800000000, 1200000000}, // Band 10: 0.8-1.2 GHz
         {1940000000, 5310000000} // Band 11: 1.94-5.31 GHz
     };
-    std::unique_ptr<ThreadPool> m_threadPool;
+    std::unique_ptr<TaskScheduler> m_scheduler;                        // Shared by all devices for per-channel fan-out
+    std::vector<std::unique_ptr<AnalyticSignalBatch>> m_phaseBatches; // Per-device phase workspace
+    std::vector<std::unique_ptr<BoundedFrameQueue>> m_frameQueues;    // Capture -> analysis hand-off (pipeline mode)
+    std::vector<std::unique_ptr<CaptureRecorder>> m_recorders;        // Raw frame recording (--record)
+    std::vector<std::unique_ptr<CaptureArchiver>> m_archivers;        // Compressed frame archive (--archive)
+    std::vector<std::unique_ptr<PipelineStats>> m_pipelineStats;      // Per-stage latency and throughput
+    PipelineStats m_exportStats;                                     // WRITE_ stages of the exporter thread
+    ExportScheduler m_exporter;                                       // Writes the output files for all devices
+    std::vector<std::unique_ptr<SnapshotPublisher<DeviceSnapshot>>> m_snapshots; // What readers see of each device
+    std::unique_ptr<std::atomic<unsigned>[]> m_statsResetRequests;    // Bumped by resetStatistics, applied by the device threads
     void initializeFrequencyConfigs() {
         const std::vector<std::pair<double, double>> FREQUENCY_BANDS = {
             {0, 100}, {500, 600}, {2000, 6000}, 
@@ -857,7 +654,7 @@ private:
             {100000000, 200000000}, {500000000, 600000000},
             {800000000, 1200000000}, {1940000000, 5310000000}
         };
-        for (int i = 0; i < m_numDevices && i < FREQUENCY_BANDS.size(); i++) {
+        for (int i = 0; i < m_numDevices && static_cast<size_t>(i) < FREQUENCY_BANDS.size(); i++) {
             DeviceFrequencyConfig config;
             config.bandwidth = FREQUENCY_BANDS[i].second - FREQUENCY_BANDS[i].first;
             config.centerFreq = (FREQUENCY_BANDS[i].first + FREQUENCY_BANDS[i].second) / 2.0;
@@ -872,147 +669,44 @@ private:
     int getOptimalFFTSize(double samplingRate) {
         return (int)pow(2, static_cast<int>(log2(samplingRate / 1000)));
     }
-void MultiLogicAnalyzer::computeInstantaneousPhase(int deviceIndex, int channel, const std::vector<uint32_t>& samples) {
-    ChannelData& chData = m_deviceStates[deviceIndex].channelData[channel];
-    const int windowSize = 2048;
-    int N = static_cast<int>(samples.size());
-    
-    if (N < windowSize) {
-        // Fallback to duty cycle based calculation
-        int highCount = 0;
-        for (int i = 0; i < N; ++i) {
-            if (((samples[i] >> channel) & 1) != 0) highCount++;
-        }
-        double frac = N > 0 ? static_cast<double>(highCount) / N : 0.0;
-        
-        // Circular mean and variance calculation for binary signal
-        double sumSin = highCount * sin(M_PI) + (N - highCount) * sin(0);
-        double sumCos = highCount * cos(M_PI) + (N - highCount) * cos(0);
-        double R = sqrt(sumSin*sumSin + sumCos*sumCos) / N;
-        double circularVariance = 1.0 - R;
-        double meanPhase = atan2(sumSin, sumCos);
-        
-        chData.meanPhase = meanPhase;
-        chData.phaseVariance = circularVariance;
-        return;
-    }
-
-    // Extract last windowSize samples and convert to 0/1 values
-    std::vector<double> x(windowSize);
-    int startIdx = N - windowSize;
-    for (int i = 0; i < windowSize; ++i) {
-        x[i] = ((samples[N - windowSize + i] >> channel) & 1) ? 1.0 : 0.0;
-    }
-
-    // Remove DC offset which can dominate the transform
-    double meanOffset = std::accumulate(x.begin(), x.end(), 0.0) / windowSize;
-    for (double &v : x) {
-        v -= meanOffset;
-    }
-
-    // Apply Hamming window to reduce spectral leakage
-    const double a0 = 0.54; // Hamming window coefficient
-    const double a1 = 0.46; // Hamming window coefficient
-    for (int i = 0; i < windowSize; ++i) {
-        double w = a0 - a1 * cos(2 * M_PI * i / (windowSize - 1));
-        x[i] *= w;
+// Phase analysis for the probe channels of one frame, batched per device so
+// the window, FFT plan and work buffers are reused between frames
+void computePhaseBatch(int deviceIndex, const CaptureFrame& frame) {
+    DeviceState& state = m_deviceStates[deviceIndex];
+    int channels[PHASE_CHANNELS];
+    PhaseStats results[PHASE_CHANNELS];
+    for (int ch = 0; ch < PHASE_CHANNELS; ++ch) {
+        channels[ch] = ch;
     }
+    m_phaseBatches[deviceIndex]->compute(frame, m_configs[deviceIndex].analysisLayout, channels, PHASE_CHANNELS, results, m_scheduler.get());
 
-    // Convert to complex
-    std::vector<std::complex<double>> signal(windowSize);
-    for (int i = 0; i < windowSize; ++i) {
-        signal[i] = std::complex<double>(x[i], 0.0);
+    for (int ch = 0; ch < PHASE_CHANNELS; ++ch) {
+        state.channelData[ch].meanPhase = results[ch].meanPhase;
+        state.channelData[ch].phaseVariance = results[ch].phaseVariance;
     }
+}
 
-    // Perform FFT
-    fft(signal, 1);
-
-    // Apply Hilbert transform in frequency domain
-    // Positive frequencies: double, negative frequencies: zero
-    int hw = windowSize/2;
-    for (int i = hw + 1; i < windowSize; ++i) {
-        signal[i] = 0;
-    }
-    for (int i = 1; i < hw; ++i) {
-        signal[i] *= 2.0;
-    }
-
-    // Perform IFFT
-    fft(signal, -1);
-
-    // Compute phase and circular statistics
-    double sumSin = 0.0, sumCos = 0.0;
-    std::vector<double> phases(windowSize);
-    double prevPhase = 0.0;
-    
-    for (int i = 0; i < windowSize; ++i) {
-        double phase = std::arg(signal[i]);
-        
-        // Phase unwrapping
-        double diff = phase - prevPhase;
-        if (diff > M_PI) phase -= 2*M_PI;
-        else if (diff < -M_PI) phase += 2*M_PI;
-        
-        phases[i] = phase;
-        prevPhase = phase;
-        
-        sumSin += sin(phase);
-        sumCos += cos(phase);
-    }
-
-    // Compute circular mean and variance
-    double meanPhase = atan2(sumSin, sumCos);
-    double R = sqrt(sumSin*sumSin + sumCos*sumCos) / windowSize;
-    double circularVariance = 1.0 - R;
-
-    // Store results
-    chData.meanPhase = meanPhase;
-    chData.phaseVariance = circularVariance;
+// Planned FFT; twiddles and bit-reverse tables are cached per size in FftPlanCache
+void fft(std::vector<std::complex<double>>& x, int sign) {
+    if (x.size() <= 1) return;
+    FftPlanCache::get(x.size())->transform(x.data(), sign);
 }
-
-void MultiLogicAnalyzer::fft(std::vector<std::complex<double>>& x, int sign) {
-    const size_t N = x.size();
-    if (N <= 1) return;
-
-    // Bit-reversal permutation
-    size_t j = 0;
-    for (size_t i = 0; i < N - 1; ++i) {
-        if (i < j) std::swap(x[i], x[j]);
-        
-        size_t m = N >> 1;
-        while (m >= 1 && j >= m) {
-            j -= m;
-            m >>= 1;
+    void configureDeviceGroups()
+    {
+        m_deviceGroups.clear();
+        if (m_options.backend == BackendKind::SYNTHETIC)
+        {
+            // Virtual devices all come from one generator spec
+            m_deviceGroups.push_back({m_options.syntheticSpec, 0, m_numDevices});
+            return;
         }
-        j += m;
-    }
-
-    // Cooley-Tukey FFT
-    for (size_t s = 1; s < N; s <<= 1) {
-        size_t m = s << 1;
-        double theta = sign * M_PI / s;
-        std::complex<double> wm(cos(theta), sin(theta));
-        
-        for (size_t k = 0; k < N; k += m) {
-            std::complex<double> w(1);
-            for (size_t j = 0; j < s; ++j) {
-                std::complex<double> t = w * x[k + j + s];
-                x[k + j + s] = x[k + j] - t;
-                x[k + j] += t;
-                w *= wm;
-            }
+        if (m_options.backend == BackendKind::REPLAY)
+        {
+            // One recording file per device in the replay directory
+            m_deviceGroups.push_back({m_options.replayDirectory, 0, m_numDevices});
+            return;
         }
-    }
 
-    // Scaling for inverse transform
-    if (sign == -1) {
-        for (size_t i = 0; i < N; ++i) {
-            x[i] /= N;
-        }
-    }
-}
-    void configureDeviceGroups()
-    {
         // First group: devices 0-9 using primary DLL
         m_deviceGroups.push_back({"C:\\Program Files (x86)\\Hantek4032L\\HTLAHard.dll", 0, 10});
 
@@ -1071,16 +765,20 @@ public:
         }
 
         // Create output directories
-        _mkdir("device_data"); // For individual device data
-
-        // Create the output directory for brain-viz
-        ensureDirectoryExists(OUTPUT_DIRECTORY);
+        platform::makeDirectory("device_data"); // For individual device data
 
         // Initialize last config modified times
         m_lastConfigModified.resize(numDevices, 0);
-        // Setup default device groups (0-9 and 10-11)
-        configureDeviceGroups();
-        m_threadPool = std::make_unique<ThreadPool>(std::thread::hardware_concurrency());
+        for (int i = 0; i < numDevices; i++)
+        {
+            m_phaseBatches.emplace_back(new AnalyticSignalBatch());
+            m_frameQueues.emplace_back(new BoundedFrameQueue());
+            m_recorders.emplace_back(new CaptureRecorder());
+            m_archivers.emplace_back(new CaptureArchiver());
+            m_pipelineStats.emplace_back(new PipelineStats());
+            m_snapshots.emplace_back(new SnapshotPublisher<DeviceSnapshot>());
+        }
+        m_statsResetRequests.reset(new std::atomic<unsigned>[numDevices]());
         initializeFrequencyConfigs();
     }
 
@@ -1090,20 +788,26 @@ public:
         m_running = false;
     }
 
+    // Full path of a file in the output directory
+    std::string outputFilePath(const std::string &fileName) const
+    {
+        return platform::joinPath(m_options.outputDirectory, fileName);
+    }
+
     void ensureDirectoryExists(const std::string &path)
     {
         // Create each directory in the path
         std::string currentPath;
         size_t pos = 0;
 
-        while ((pos = path.find('\\', pos + 1)) != std::string::npos)
+        while ((pos = path.find_first_of("\\/", pos + 1)) != std::string::npos)
         {
             currentPath = path.substr(0, pos);
-            _mkdir(currentPath.c_str());
+            platform::makeDirectory(currentPath);
         }
 
         // Create the final directory
-        _mkdir(path.c_str());
+        platform::makeDirectory(path);
     }
 
     bool initialize(const std::string &dllPath)
@@ -1130,16 +834,38 @@ public:
             state.active = false;
         }
 
+        // Setup device groups (0-9 and 10-11 for hardware)
+        configureDeviceGroups();
+
         // Load DLL only once for testing
-        HantekDevice tempDevice;
-        if (!tempDevice.loadDLL(dllPath))
+        if (m_options.backend == BackendKind::HANTEK)
         {
-            std::cerr << "Failed to load DLL: " << tempDevice.getLastError() << "\n";
-            return false;
+            HantekDevice tempDevice;
+            if (!tempDevice.open(dllPath))
+            {
+                std::cerr << "Failed to load DLL: " << tempDevice.getLastError() << "\n";
+                return false;
+            }
         }
 
-        // Try to connect to each device sequentially
-        connectDevicesSequentially(dllPath);
+        // Bring the devices up one at a time or on a bounded set of threads
+        if (m_options.connectMode == ConnectMode::PARALLEL)
+        {
+            connectDevicesConcurrently();
+        }
+        else
+        {
+            connectDevicesSequentially(dllPath);
+        }
+
+        if (!m_options.recordDirectory.empty())
+        {
+            startRecording();
+        }
+        if (!m_options.archiveDirectory.empty())
+        {
+            startArchiving();
+        }
 
         std::cout << "\n=== Multi-Device Logic Analyzer initialized ===\n";
         std::cout << "Successfully connected to " << m_activeDevices << " out of " << m_numDevices << " devices\n\n";
@@ -1147,9 +873,42 @@ public:
         // Always return true to continue with display even if no devices are connected
         return true;
     }
+    void setRuntimeOptions(const RuntimeOptions &options)
+    {
+        m_options = options;
+
+        // Create the output directory for brain-viz
+        ensureDirectoryExists(m_options.outputDirectory);
+        m_liveStatePath = outputFilePath(LIVE_STATE_FILENAME);
+
+        // Enabled first so the scheduler workers register under their names
+        if (options.trace)
+        {
+            TraceRecorder::instance().enable();
+            TraceRecorder::instance().setThreadName("main");
+        }
+
+        unsigned threads = options.schedulerThreads >= 0 ? static_cast<unsigned>(options.schedulerThreads)
+                                                         : std::thread::hardware_concurrency();
+        m_scheduler.reset(new TaskScheduler(threads, options.pinThreads));
+    }
+
+    std::shared_ptr<CaptureBackend> createBackend() const
+    {
+        if (m_options.backend == BackendKind::SYNTHETIC)
+        {
+            return std::make_shared<SyntheticBackend>();
+        }
+        if (m_options.backend == BackendKind::REPLAY)
+        {
+            return std::make_shared<ReplayBackend>(m_options.replayPacing, m_options.replayLoops);
+        }
+        return std::make_shared<HantekDllBackend>();
+    }
+
     void configureDevice(int deviceIndex, unsigned long samplingRate, int slices, double windowSec)
     {
-        if (deviceIndex < m_deviceSamplingRates.size())
+        if (deviceIndex >= 0 && static_cast<size_t>(deviceIndex) < m_deviceSamplingRates.size())
         {
             m_deviceSamplingRates[deviceIndex] = samplingRate;
             m_timeSliceCounts[deviceIndex] = slices;
@@ -1159,6 +918,7 @@ public:
 
     void connectDevicesSequentially(const std::string &dllPath)
     {
+        (void)dllPath; // Each device group loads its own DLL path
         std::cout << "=== Starting Sequential Connection to " << m_numDevices << " Hantek Devices ===\n";
         std::cout << "Maximum retries per device: " << MAX_RETRIES << "\n";
         std::cout << "Connection timeout: " << CONNECTION_TIMEOUT_MS << "ms\n\n";
@@ -1171,60 +931,466 @@ public:
                 if (deviceIndex >= m_numDevices) break;
 
                 std::cout << "\n--- Device " << deviceIndex << " Connection Attempt ---\n";
-                HantekDevice& device = m_devices[deviceIndex];
+                std::string log;
+                bringUpDevice(deviceIndex, group.dllPath, std::chrono::steady_clock::time_point::max(), log);
+                std::cout << log;
+            }
+        }
+        auto overallEndTime = std::chrono::steady_clock::now();
+        double totalTime = std::chrono::duration<double>(overallEndTime - overallStartTime).count();
 
-                // Load DLL for this device (each device gets its own instance)
-                if (!device.loadDLL(group.dllPath)) {
-                    std::cout << "  DLL load FAILED: " << device.getLastError() << "\n";
-                    continue;
-                }
+        std::cout << "\n=== Connection Process Complete ===\n";
+        std::cout << "Total time: " << std::fixed << std::setprecision(2) << totalTime << " seconds\n";
+        std::cout << "Connected devices: " << m_activeDevices << "/" << m_numDevices << "\n";
+    }
 
-                // Connect using deviceIndex
-                if (!device.connect(deviceIndex)) {
-                    std::cout << "  Connection FAILED: " << device.getLastError() << "\n";
-                    continue;
-                }
+    // Bring devices up on a bounded number of threads. The vendor DLL is not
+    // known to be safe under unlimited parallelism, so at most
+    // connectConcurrency devices are inside DLL calls at any time, and each
+    // device gets connectDeadlineMs to finish connect, init and configuration.
+    // The deadline is checked between those steps: the DLL calls themselves
+    // cannot be interrupted, so one that hangs still holds its slot.
+    void connectDevicesConcurrently()
+    {
+        const int concurrency = std::max(1, m_options.connectConcurrency);
+        std::cout << "=== Starting Parallel Connection to " << m_numDevices << " Hantek Devices ===\n";
+        std::cout << "Concurrent bring-ups: " << concurrency << "\n";
+        std::cout << "Per-device deadline: " << m_options.connectDeadlineMs << "ms (checked between bring-up steps)\n\n";
 
-                // Initialize device
-                if (!device.initialize()) {
-                    std::cout << "  Initialization FAILED: " << device.getLastError() << "\n";
-                    continue;
-                }
+        auto overallStartTime = std::chrono::steady_clock::now();
 
-                // Apply configuration
-                if (!applyConfiguration(deviceIndex)) {
-                    std::cout << "  Configuration FAILED\n";
-                    continue;
-                }
+        std::vector<std::pair<int, std::string>> pending;
+        for (const auto &group : m_deviceGroups)
+        {
+            for (int i = 0; i < group.deviceCount && group.startIndex + i < m_numDevices; i++)
+            {
+                pending.push_back(std::make_pair(group.startIndex + i, group.dllPath));
+            }
+        }
+
+        std::atomic<size_t> next(0);
+        auto connectWorker = [&]()
+        {
+            for (size_t item = next++; item < pending.size(); item = next++)
+            {
+                const int deviceIndex = pending[item].first;
+                const auto deadline = std::chrono::steady_clock::now() +
+                                      std::chrono::milliseconds(m_options.connectDeadlineMs);
+                std::string log;
+                bringUpDevice(deviceIndex, pending[item].second, deadline, log);
+
+                std::lock_guard<std::mutex> lock(m_consoleMutex);
+                std::cout << "--- Device " << deviceIndex << " ---\n" << log;
+            }
+        };
+
+        std::vector<std::thread> workers;
+        const size_t workerCount = std::min(pending.size(), static_cast<size_t>(concurrency));
+        for (size_t i = 0; i < workerCount; i++)
+        {
+            workers.emplace_back(connectWorker);
+        }
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+
+        auto overallEndTime = std::chrono::steady_clock::now();
+        double totalTime = std::chrono::duration<double>(overallEndTime - overallStartTime).count();
+
+        std::cout << "\n=== Connection Process Complete ===\n";
+        for (const auto &entry : pending)
+        {
+            const ConnectionResult &result = m_connectionResults[entry.first];
+            std::cout << "  Device " << std::setw(2) << entry.first << ": "
+                      << (result.success ? "OK    " : "FAILED") << " "
+                      << std::fixed << std::setprecision(2) << result.connectionTime << "s";
+            if (!result.success)
+            {
+                std::cout << " [" << result.errorCode << "] " << result.message;
+            }
+            std::cout << "\n";
+        }
+        std::cout << "Total time: " << std::fixed << std::setprecision(2) << totalTime << " seconds\n";
+        std::cout << "Connected devices: " << m_activeDevices << "/" << m_numDevices << "\n";
+    }
+
+    // Load, connect, initialize and configure one device, recording the outcome
+    // and timing in m_connectionResults. Progress lines are appended to log so
+    // concurrent bring-ups do not interleave their output.
+    bool bringUpDevice(int deviceIndex, const std::string &dllPath,
+                       std::chrono::steady_clock::time_point deadline, std::string &log)
+    {
+        HantekDevice &device = m_devices[deviceIndex];
+        ConnectionResult &result = m_connectionResults[deviceIndex];
+        const auto startTime = std::chrono::steady_clock::now();
+
+        // A failed device is closed again so it does not keep the DLL loaded
+        // or the unit claimed
+        auto fail = [&](const std::string &errorCode, const std::string &message)
+        {
+            device.close();
+            result.success = false;
+            result.errorCode = errorCode;
+            result.message = message;
+            result.connectionTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+            log += "  " + message + "\n";
+            return false;
+        };
+        auto pastDeadline = [&]()
+        {
+            return std::chrono::steady_clock::now() > deadline;
+        };
+
+        // Load DLL for this device (each device gets its own instance)
+        device.setBackend(createBackend());
+        if (!device.open(dllPath))
+        {
+            return fail("DLL_LOAD", "DLL load FAILED: " + device.getLastError());
+        }
+
+        // Connect using deviceIndex
+        if (!device.connect(deviceIndex))
+        {
+            return fail("CONN_FAILED", "Connection FAILED: " + device.getLastError());
+        }
+        if (pastDeadline())
+        {
+            return fail("DEADLINE", "Deadline exceeded after connect");
+        }
 
-                // Update device state
-                m_deviceStates[deviceIndex].connected = true;
-                m_deviceStates[deviceIndex].active = true;
-                m_deviceStates[deviceIndex].serialNumber = device.getSerialNumber();
-                m_deviceStates[deviceIndex].model = device.getModel();
-                m_deviceStates[deviceIndex].firmwareVersion = device.getFirmwareVersion();
-                m_activeDevices++;
+        // Initialize device
+        if (!device.initialize())
+        {
+            return fail("INIT_FAILED", "Initialization FAILED: " + device.getLastError());
+        }
+        if (pastDeadline())
+        {
+            return fail("DEADLINE", "Deadline exceeded after initialization");
+        }
+
+        // A replayed recording dictates the rate and depth it was captured with
+        unsigned short recordedRate = 0;
+        unsigned long recordedDepth = 0;
+        if (device.getRecordedSettings(recordedRate, recordedDepth))
+        {
+            m_configs[deviceIndex].sampleRateCode = recordedRate;
+            m_configs[deviceIndex].sampleDepth = recordedDepth;
+        }
+
+        // Apply configuration
+        // Past the last step the device is fully up, so it is kept even if
+        // configuration ran over the deadline
+        if (!applyConfiguration(deviceIndex))
+        {
+            return fail("CONFIG_FAILED", "Configuration FAILED: " + device.getLastError());
+        }
+
+        // Update device state
+        m_deviceStates[deviceIndex].connected = true;
+        m_deviceStates[deviceIndex].active = true;
+        m_deviceStates[deviceIndex].serialNumber = device.getSerialNumber();
+        m_deviceStates[deviceIndex].model = device.getModel();
+        m_deviceStates[deviceIndex].firmwareVersion = device.getFirmwareVersion();
+        publishHealthSnapshot(deviceIndex);
+        m_activeDevices++;
+
+        // Store device info
+        m_configs[deviceIndex].serialNumber = device.getSerialNumber();
+        m_configs[deviceIndex].model = device.getModel();
+
+        result.success = true;
+        result.errorCode.clear();
+        result.message = "Connected successfully";
+        result.connectionTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+        std::ostringstream line;
+        line << "  Connection SUCCESS (" << std::fixed << std::setprecision(2) << result.connectionTime << "s)\n";
+        log += line.str();
+        return true;
+    }
+
+    // Open a recorder for every connected device; a device whose file cannot
+    // be created runs without recording
+    void startRecording()
+    {
+        ensureDirectoryExists(m_options.recordDirectory);
+        for (int i = 0; i < m_numDevices; i++)
+        {
+            if (!m_deviceStates[i].connected)
+            {
+                continue;
+            }
+            CaptureRecorder &recorder = *m_recorders[i];
+            if (recorder.open(recordingFilePath(m_options.recordDirectory, i), i,
+                              m_devices[i].getSerialNumber(), m_devices[i].getModel()))
+            {
+                std::cout << "Recording device " << i << " to " << recorder.path() << "\n";
+            }
+            else
+            {
+                std::cerr << "Device " << i << " not recorded: " << recorder.getLastError() << "\n";
+            }
+        }
+    }
+
+    void stopRecording()
+    {
+        for (int i = 0; i < m_numDevices; i++)
+        {
+            CaptureRecorder &recorder = *m_recorders[i];
+            if (!recorder.isOpen())
+            {
+                continue;
+            }
+            recorder.close();
+            std::cout << "Recorded " << recorder.framesWritten() << " frames ("
+                      << std::fixed << std::setprecision(1) << recorder.bytesWritten() / (1024.0 * 1024.0)
+                      << " MB) from device " << i << " to " << recorder.path() << "\n";
+        }
+    }
+
+    // Open an archiver for every connected device, like startRecording
+    void startArchiving()
+    {
+        ensureDirectoryExists(m_options.archiveDirectory);
+        for (int i = 0; i < m_numDevices; i++)
+        {
+            if (!m_deviceStates[i].connected)
+            {
+                continue;
+            }
+            CaptureArchiver &archiver = *m_archivers[i];
+            if (archiver.open(archiveFilePath(m_options.archiveDirectory, i), i,
+                              m_devices[i].getSerialNumber(), m_devices[i].getModel()))
+            {
+                std::cout << "Archiving device " << i << " to " << archiver.path() << "\n";
+            }
+            else
+            {
+                std::cerr << "Device " << i << " not archived: " << archiver.getLastError() << "\n";
+            }
+        }
+    }
+
+    void stopArchiving()
+    {
+        for (int i = 0; i < m_numDevices; i++)
+        {
+            CaptureArchiver &archiver = *m_archivers[i];
+            if (!archiver.isOpen())
+            {
+                continue;
+            }
+            archiver.close();
+            const uint64_t bytes = archiver.bytesWritten();
+            std::cout << "Archived " << archiver.framesWritten() << " frames ("
+                      << std::fixed << std::setprecision(1) << bytes / (1024.0 * 1024.0) << " MB, "
+                      << (bytes > 0 ? archiver.rawBytes() / static_cast<double>(bytes) : 0.0) << "x smaller than raw";
+            if (archiver.framesDropped() > 0)
+            {
+                std::cout << ", " << archiver.framesDropped() << " dropped";
+            }
+            std::cout << ") from device " << i << " to " << archiver.path() << "\n";
+        }
+    }
+
+    // Per-device throughput, then every stage's latency over all devices
+    // (stages that never ran are left out)
+    void writePipelineStats(std::ostream &out) const
+    {
+        PipelineStats::Snapshot total;
+        out << "Device    Frames       FPS  MSamples/s   Dropped\n";
+        for (int i = 0; i < m_numDevices; i++)
+        {
+            if (!m_deviceStates[i].connected)
+            {
+                continue;
+            }
+            const PipelineStats::Snapshot snapshot = m_pipelineStats[i]->snapshot();
+            total.merge(snapshot);
+            out << std::setw(6) << i << std::setw(10) << snapshot.frames
+                << std::setw(10) << std::fixed << std::setprecision(1) << snapshot.framesPerSecond()
+                << std::setw(12) << std::setprecision(2) << snapshot.samplesPerSecond() / 1e6
+                << std::setw(10) << m_frameQueues[i]->droppedFrames() << "\n";
+        }
+        out << "Total " << std::setw(10) << total.frames
+            << std::setw(10) << std::fixed << std::setprecision(1) << total.framesPerSecond()
+            << std::setw(12) << std::setprecision(2) << total.samplesPerSecond() / 1e6 << "\n\n";
+
+        total.merge(m_exportStats.snapshot());
+        out << "Stage         Count   Mean(us)    p50(us)    p99(us)    Max(us)\n";
+        for (int stage = 0; stage < static_cast<int>(PipelineStage::COUNT); stage++)
+        {
+            const LatencyHistogram &latency = total.stages[stage];
+            if (latency.count() == 0)
+            {
+                continue;
+            }
+            out << std::left << std::setw(9) << getPipelineStageName(static_cast<PipelineStage>(stage))
+                << std::right << std::setw(10) << latency.count() << std::fixed << std::setprecision(1)
+                << std::setw(11) << latency.meanUs()
+                << std::setw(11) << latency.percentileUs(0.50)
+                << std::setw(11) << latency.percentileUs(0.99)
+                << std::setw(11) << latency.maxUs() << "\n";
+        }
+    }
+
+    static void appendStageJson(std::ostream &out, const PipelineStats::Snapshot &snapshot)
+    {
+        out << "{";
+        bool first = true;
+        for (int stage = 0; stage < static_cast<int>(PipelineStage::COUNT); stage++)
+        {
+            const LatencyHistogram &latency = snapshot.stages[stage];
+            if (latency.count() == 0)
+            {
+                continue;
+            }
+            out << (first ? "" : ",") << "\"" << getPipelineStageName(static_cast<PipelineStage>(stage))
+                << "\":{\"count\":" << latency.count() << ",\"meanUs\":" << latency.meanUs()
+                << ",\"p50Us\":" << latency.percentileUs(0.50) << ",\"p99Us\":" << latency.percentileUs(0.99)
+                << ",\"maxUs\":" << latency.maxUs() << "}";
+            first = false;
+        }
+        out << "}";
+    }
+
+    // Machine-readable form of writePipelineStats, replaced atomically so
+    // scrapers never read half a file
+    void exportPipelineStats()
+    {
+        std::ostringstream json;
+        json << std::fixed << std::setprecision(1) << "{\"time\":" << output_writers::toEpochMs(std::chrono::system_clock::now())
+             << ",\"devices\":[";
+        bool first = true;
+        for (int i = 0; i < m_numDevices; i++)
+        {
+            if (!m_deviceStates[i].connected)
+            {
+                continue;
+            }
+            const PipelineStats::Snapshot snapshot = m_pipelineStats[i]->snapshot();
+            json << (first ? "" : ",") << "{\"device\":" << i << ",\"frames\":" << snapshot.frames
+                 << ",\"framesPerSecond\":" << snapshot.framesPerSecond()
+                 << ",\"samplesPerSecond\":" << snapshot.samplesPerSecond()
+                 << ",\"dropped\":" << m_frameQueues[i]->droppedFrames() << ",\"stages\":";
+            appendStageJson(json, snapshot);
+            json << "}";
+            first = false;
+        }
+        json << "],\"exporter\":";
+        appendStageJson(json, m_exportStats.snapshot());
+        json << "}\n";
+
+        const std::string path = outputFilePath(STATS_FILENAME);
+        const std::string temporary = path + ".tmp";
+        {
+            std::ofstream file(temporary, std::ios::trunc);
+            file << json.str();
+            if (!file)
+            {
+                return;
+            }
+        }
+        if (!replaceFile(temporary, path))
+        {
+            std::remove(temporary.c_str());
+        }
+    }
+
+    // Throughput and per-stage latency of every device plus the combined
+    // figures, printed and written to reportPath so runs on the same
+    // recording can be compared
+    void reportPipelineStats(const std::string &reportPath)
+    {
+        std::ostringstream report;
+        report << "=== Pipeline Report (" << m_devices[0].getBackendName();
+        if (m_options.backend == BackendKind::REPLAY)
+        {
+            report << ", " << (m_options.replayPacing == ReplayPacing::FAST ? "fast" : "original") << " pacing";
+        }
+        report << ") ===\n";
 
-                // Store device info
-                m_configs[deviceIndex].serialNumber = device.getSerialNumber();
-                m_configs[deviceIndex].model = device.getModel();
+        writePipelineStats(report);
+        const ExportScheduler::Stats exportStats = m_exporter.stats();
+        report << "\nExporter: " << exportStats.flushes << " writes for " << exportStats.notifications
+               << " frames, last " << exportStats.lastFlushUs << " us, max " << exportStats.maxFlushUs << " us\n";
+        if (m_scheduler)
+        {
+            const TaskScheduler::Stats schedulerStats = m_scheduler->stats();
+            report << "Scheduler: " << m_scheduler->threadCount() << " workers, " << schedulerStats.executed
+                   << " tasks run, " << schedulerStats.stolen << " stolen, " << schedulerStats.inlined << " inline\n";
+        }
+        if (m_pushServer.isRunning())
+        {
+            const PushServer::Stats pushStats = m_pushServer.stats();
+            report << "Push server: " << pushStats.clients << " clients, " << pushStats.deltasSent << " deltas sent, "
+                   << pushStats.resyncs << " slow-client resyncs, " << pushStats.waveformRequests
+                   << " waveform requests\n";
+        }
+        if (m_resultsRing.isOpen())
+        {
+            report << "Results ring: " << m_resultsRing.recordsWritten() << " records ("
+                   << m_resultsRing.capacity() << " slots)\n";
+        }
+
+        std::cout << "\n" << report.str();
+        std::ofstream reportFile(reportPath);
+        if (reportFile.is_open())
+        {
+            reportFile << report.str();
+            std::cout << "Report written to " << reportPath << "\n";
+        }
+    }
+
+    void run()
+    {
+        std::cout << "Starting monitoring system...\n";
+        platform::installStopHandlers();
+        if (m_options.headless)
+        {
+            std::cout << "Running headless, writing to " << m_options.outputDirectory << "; stop with SIGINT or SIGTERM\n";
+            if (m_options.trace)
+            {
+                std::cout << "Tracing on: the Chrome trace is written at exit\n";
+            }
+        }
+        else
+        {
+            std::cout << "Press 'Q' to quit, 'R' to reset statistics, 'C' to reload config\n";
+            std::cout << "Press 'D' to cycle display modes (Summary/Details/Activity/Stats)\n";
+            if (m_options.trace)
+            {
+                std::cout << "Tracing on: press 'T' to dump a Chrome trace (also written at exit)\n";
+            }
+        }
+        std::cout << "\n";
 
-                std::cout << "  Connection SUCCESS\n";
+        if (!m_options.resultsRing.empty())
+        {
+            if (m_resultsRing.create(m_options.resultsRing, static_cast<uint32_t>(m_options.resultsRingCapacity)))
+            {
+                std::cout << "Publishing results to shared memory '" << m_options.resultsRing << "' ("
+                          << m_options.resultsRingCapacity << " records)\n";
+            }
+            else
+            {
+                std::cout << "Results ring disabled: " << m_resultsRing.getLastError() << "\n";
             }
         }
-        auto overallEndTime = std::chrono::steady_clock::now();
-        double totalTime = std::chrono::duration<double>(overallEndTime - overallStartTime).count();
-
-        std::cout << "\n=== Connection Process Complete ===\n";
-        std::cout << "Total time: " << std::fixed << std::setprecision(2) << totalTime << " seconds\n";
-        std::cout << "Connected devices: " << m_activeDevices << "/" << m_numDevices << "\n";
-    }
 
-    void run()
-    {
-        std::cout << "Starting monitoring system...\n";
-        std::cout << "Press 'Q' to quit, 'R' to reset statistics, 'C' to reload config\n";
-        std::cout << "Press 'D' to cycle display modes (Summary/Details/Activity)\n\n";
+        if (m_options.pushPort > 0)
+        {
+            if (m_pushServer.start(m_options.pushPort, m_options.pushOrigin))
+            {
+                std::cout << "Streaming deltas on ws://127.0.0.1:" << m_options.pushPort << "/stream\n";
+            }
+            else
+            {
+                std::cout << "Push server disabled: " << m_pushServer.getLastError() << "\n";
+            }
+        }
 
         // Create worker threads for each active device
         std::vector<std::thread> deviceThreads;
@@ -1237,25 +1403,71 @@ public:
             }
         }
 
-        // Also generate dummy data updates for disconnected devices
-        std::thread dummyDataThread([&]()
-                                    {
-            while (m_running) {
-                // Create/update dummy data for visualization compatibility
-                exportNeuralMonitorData();
-                std::this_thread::sleep_for(std::chrono::milliseconds(500));
-            } });
+        // Output files are written by the exporter only; it also refreshes
+        // logic_data.txt when no device delivers data
+        const int EXPORT_HEARTBEAT_MS = 500;
+        m_exporter.start(m_options.exportIntervalMs, EXPORT_HEARTBEAT_MS, [this](uint64_t dirtyDevices)
+                         {
+                             TraceScope trace("flush", "export");
+                             exportOutputs(dirtyDevices);
+                         });
+
+        const bool replaying = m_options.backend == BackendKind::REPLAY;
 
         // Main display loop
+        // The loop wakes every tick for keys and stop requests; the screen is
+        // redrawn on its own interval, independent of the capture rate
+        const int RUN_LOOP_TICK_MS = 50;
+        if (!m_options.headless)
+        {
+            m_screen.setAnsi(platform::enableAnsiOutput());
+        }
+        auto lastStatsExport = std::chrono::steady_clock::now();
+        auto lastStatusLine = std::chrono::steady_clock::now();
+        auto lastDisplay = std::chrono::steady_clock::time_point();
         while (m_running)
         {
-            // Display results
-            displayResults();
+            // Display results; a headless run logs one status line now and then instead
+            if (!m_options.headless)
+            {
+                if (std::chrono::steady_clock::now() - lastDisplay >= std::chrono::milliseconds(m_options.displayIntervalMs))
+                {
+                    displayResults();
+                    lastDisplay = std::chrono::steady_clock::now();
+                }
+            }
+            else if (std::chrono::steady_clock::now() - lastStatusLine >= std::chrono::seconds(HEADLESS_STATUS_SECONDS))
+            {
+                writeStatusLine(std::cout);
+                lastStatusLine = std::chrono::steady_clock::now();
+            }
+
+            if (m_options.statsIntervalMs > 0 &&
+                std::chrono::steady_clock::now() - lastStatsExport >= std::chrono::milliseconds(m_options.statsIntervalMs))
+            {
+                exportPipelineStats();
+                lastStatsExport = std::chrono::steady_clock::now();
+            }
+
+            // Every recording has played out
+            if (replaying && m_activeDevices == 0)
+            {
+                m_running = false;
+                std::cout << "\nReplay finished.\n";
+                break;
+            }
+
+            if (platform::stopRequested())
+            {
+                m_running = false;
+                std::cout << "\nStop requested, shutting down...\n";
+                break;
+            }
 
             // Check for user input
-            if (_kbhit())
+            if (!m_options.headless && platform::keyPressed())
             {
-                char key = _getch();
+                const int key = platform::readKey();
                 if (key == 'q' || key == 'Q')
                 {
                     m_running = false;
@@ -1282,13 +1494,20 @@ public:
                 else if (key == 'd' || key == 'D')
                 {
                     // Cycle display modes
-                    m_displayMode = static_cast<DisplayMode>((static_cast<int>(m_displayMode) + 1) % 3);
+                    m_displayMode = static_cast<DisplayMode>((static_cast<int>(m_displayMode) + 1) %
+                                                             static_cast<int>(DisplayMode::COUNT));
                     std::cout << "\nSwitched to " << getDisplayModeName() << " display mode\n";
                 }
+                else if ((key == 't' || key == 'T') && m_options.trace)
+                {
+                    dumpTrace();
+                }
+                // The message went below the frame; repaint it all next time
+                m_screen.invalidate();
             }
 
             // Sleep for a short period
-            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            std::this_thread::sleep_for(std::chrono::milliseconds(RUN_LOOP_TICK_MS));
         }
 
         // Join all device threads
@@ -1300,10 +1519,20 @@ public:
             }
         }
 
-        // Join dummy data thread
-        if (dummyDataThread.joinable())
+        // Write out the last frames
+        m_exporter.stop();
+
+        stopRecording();
+        stopArchiving();
+        if (replaying)
         {
-            dummyDataThread.join();
+            reportPipelineStats("replay_report.txt");
+        }
+        m_resultsRing.close();
+        m_pushServer.stop();
+        if (m_options.trace)
+        {
+            dumpTrace();
         }
 
         std::cout << "\nMonitoring stopped.\n";
@@ -1313,60 +1542,110 @@ public:
     {
         DeviceState &state = m_deviceStates[deviceIndex];
         HantekDevice &device = m_devices[deviceIndex];
-       
-        const int CHANGE_HIGHLIGHT_MS = 3000;
+        BoundedFrameQueue &queue = *m_frameQueues[deviceIndex];
+        CaptureRecorder &recorder = *m_recorders[deviceIndex];
+        CaptureArchiver &archiver = *m_archivers[deviceIndex];
+        std::thread analysisThread;
+        TraceRecorder::instance().setThreadName("device " + std::to_string(deviceIndex) + " capture");
+
+        // A fast replay measures the pipeline alone, so it does not wait between scans
+        const bool freeRunning = m_options.backend == BackendKind::REPLAY &&
+                                 m_options.replayPacing == ReplayPacing::FAST;
+
+        // Health counters as last published; they belong to this thread
+        int publishedErrors = state.errorsCount;
+        int publishedConsecutiveErrors = state.consecutiveErrors;
+
         while (m_running && state.active)
         {
-            bool configChanged = checkConfigurationChanges(deviceIndex);
-            if (configChanged)
+            const unsigned resetGeneration = m_statsResetRequests[deviceIndex].load();
+            if (resetGeneration != state.captureResetGeneration)
+            {
+                state.captureResetGeneration = resetGeneration;
+                state.errorsCount = 0;
+                state.consecutiveErrors = 0;
+            }
+            if (state.errorsCount != publishedErrors || state.consecutiveErrors != publishedConsecutiveErrors)
+            {
+                publishedErrors = state.errorsCount;
+                publishedConsecutiveErrors = state.consecutiveErrors;
+                publishHealthSnapshot(deviceIndex);
+            }
+
+            if (device.isSourceExhausted())
+            {
+                // Recording played out: analysis still gets the frames already queued
+                stopAnalysisThread(queue, analysisThread);
+                state.active = false;
+                m_activeDevices--;
+                break;
+            }
+
+            if (checkConfigurationChanges(deviceIndex))
+            {
+                // Queued frames are analysed with the config they were captured under
+                stopAnalysisThread(queue, analysisThread);
+                if (reloadConfiguration(deviceIndex))
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+                    continue;
+                }
+            }
+
+            // In pipeline mode analysis runs on its own thread, fed through the frame queue
+            const bool pipelined = m_configs[deviceIndex].pipelineMode;
+            if (pipelined && !analysisThread.joinable())
             {
-                std::this_thread::sleep_for(std::chrono::milliseconds(500));
+                queue.reopen(static_cast<size_t>(m_configs[deviceIndex].pipelineQueueDepth));
+                analysisThread = std::thread(&MultiLogicAnalyzer::analysisWorker, this, deviceIndex);
+            }
+            else if (!pipelined && analysisThread.joinable())
+            {
+                queue.close();
+                analysisThread.join();
+            }
+
+            // No free buffer means analysis still holds them all: skip this capture
+            // rather than arming the device for a frame that cannot be read
+            std::shared_ptr<CaptureBufferPool> pool = device.getBufferPool();
+            TraceScope bufferWait("buffer wait", "capture", "device", deviceIndex);
+            const bool bufferFree = !pool || pool->waitForBuffer(m_configs[deviceIndex].bufferPoolPolicy, 1000);
+            bufferWait.end();
+            if (!bufferFree)
+            {
+                pool.reset();
+                std::this_thread::sleep_for(std::chrono::milliseconds(pipelined ? 1 : m_configs[deviceIndex].scanIntervalMs));
                 continue;
             }
+            pool.reset();
+
             bool captureSuccess = false;
             try
             {
-                auto captureStartTime = std::chrono::steady_clock::now();
-                const auto captureTimeout = std::chrono::seconds(3);
-                if (!device.startCapture())
-                {
-                    handleDeviceError(deviceIndex, "Failed to start capture: " + device.getLastError());
-                    
-                }
-                else
+                CaptureFramePtr capturedFrame;
+                if (captureFrame(deviceIndex, capturedFrame))
                 {
-                    if (!device.waitForCaptureComplete(2000))
+                    captureSuccess = true;
+                    state.consecutiveErrors = 0;
+                    if (recorder.isOpen() && !recorder.submit(capturedFrame))
+                    {
+                        handleDeviceError(deviceIndex, "Recording stopped: " + recorder.getLastError());
+                        recorder.close();
+                    }
+                    // Never blocks: a lagging archive drops frames instead of stalling capture
+                    if (archiver.isOpen() && !archiver.submit(capturedFrame))
+                    {
+                        handleDeviceError(deviceIndex, "Archiving stopped: " + archiver.getLastError());
+                        archiver.close();
+                    }
+                    if (pipelined)
                     {
-                        state.consecutiveErrors++;
-                        handleDeviceError(deviceIndex, "Capture timeout");
-                        
+                        // Hand off and re-arm the hardware straight away
+                        queue.push(capturedFrame);
                     }
                     else
                     {
-                        auto elapsedTime = std::chrono::steady_clock::now() - captureStartTime;
-                        if (elapsedTime > captureTimeout)
-                        {
-                            handleDeviceError(deviceIndex, "Total capture operation timed out");
-                            state.consecutiveErrors++;
-                            
-                        }
-                        else
-                        {
-                            std::vector<uint32_t> capturedData;
-                            if (!device.readData(capturedData))
-                            {
-                                handleDeviceError(deviceIndex, "Failed to read data: " + device.getLastError());
-                               
-                            }
-                            else
-                            {
-                                processData(deviceIndex, capturedData);
-                                captureSuccess = true;
-                                state.consecutiveErrors = 0;
-                                state.capturesCount++;
-                                state.lastCaptureTime = std::chrono::system_clock::now();
-                            }
-                        }
+                        processData(deviceIndex, capturedFrame);
                     }
                 }
             }
@@ -1386,6 +1665,7 @@ public:
                 state.errorsCount++;
                 if (state.consecutiveErrors >= 5)
                 {
+                    stopAnalysisThread(queue, analysisThread);
                     if (device.resetAndReconnect())
                     {
                         if (applyConfiguration(deviceIndex))
@@ -1405,25 +1685,238 @@ public:
                 }
                 std::this_thread::sleep_for(std::chrono::milliseconds(200));
             }
-            auto now = std::chrono::system_clock::now();
-            std::vector<int> channelsToRemove;
+            if (!pipelined && !freeRunning)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(m_configs[deviceIndex].scanIntervalMs));
+            }
+        }
+
+        if (analysisThread.joinable())
+        {
+            queue.close();
+            analysisThread.join();
+        }
+        publishHealthSnapshot(deviceIndex);
+    }
+
+    // Arm the device, wait for the capture and read it into a frame
+    bool captureFrame(int deviceIndex, CaptureFramePtr &frame)
+    {
+        DeviceState &state = m_deviceStates[deviceIndex];
+        HantekDevice &device = m_devices[deviceIndex];
+        PipelineStats &stats = *m_pipelineStats[deviceIndex];
+
+        auto captureStartTime = std::chrono::steady_clock::now();
+        const auto captureTimeout = std::chrono::seconds(3);
+        TraceScope armTrace("arm", "capture", "device", deviceIndex);
+        if (!device.startCapture())
+        {
+            handleDeviceError(deviceIndex, "Failed to start capture: " + device.getLastError());
+            return false;
+        }
+        armTrace.end();
+        const auto waitStartTime = std::chrono::steady_clock::now();
+        stats.record(PipelineStage::ARM, waitStartTime - captureStartTime);
+        TraceScope waitTrace("wait", "capture", "device", deviceIndex);
+        if (!device.waitForCaptureComplete(2000))
+        {
+            state.consecutiveErrors++;
+            handleDeviceError(deviceIndex, "Capture timeout");
+            return false;
+        }
+        const auto readStartTime = std::chrono::steady_clock::now();
+        if (readStartTime - captureStartTime > captureTimeout)
+        {
+            handleDeviceError(deviceIndex, "Total capture operation timed out");
+            state.consecutiveErrors++;
+            return false;
+        }
+        stats.record(PipelineStage::WAIT, readStartTime - waitStartTime);
+        waitTrace.end();
+
+        TraceScope readTrace("read", "capture", "device", deviceIndex);
+        if (!device.readData(frame))
+        {
+            handleDeviceError(deviceIndex, "Failed to read data: " + device.getLastError());
+            return false;
+        }
+        stats.record(PipelineStage::READ, std::chrono::steady_clock::now() - readStartTime);
+        return true;
+    }
+
+    // Let a running analysis thread finish the frames already queued and
+    // join it; deviceWorker starts it again on its next pass
+    void stopAnalysisThread(BoundedFrameQueue &queue, std::thread &analysisThread)
+    {
+        if (analysisThread.joinable())
+        {
+            queue.finish();
+            analysisThread.join();
+        }
+    }
+
+    // Analysis stage of pipeline mode: processes frames queued by deviceWorker
+    void analysisWorker(int deviceIndex)
+    {
+        BoundedFrameQueue &queue = *m_frameQueues[deviceIndex];
+        TraceRecorder::instance().setThreadName("device " + std::to_string(deviceIndex) + " analysis");
+
+        CaptureFramePtr frame;
+        while (queue.pop(frame))
+        {
+            try
+            {
+                processData(deviceIndex, frame);
+            }
+            catch (const std::exception &e)
+            {
+                handleDeviceError(deviceIndex, std::string("Exception in analysis: ") + e.what());
+            }
+            frame.reset();
+        }
+    }
+
+    // Drop channels from the "recently changed" list once their highlight expires
+    void pruneChangedChannels(DeviceState &state)
+    {
+        auto now = std::chrono::system_clock::now();
+        std::vector<int> channelsToRemove;
+        for (const auto &entry : state.changedChannels)
+        {
+            int ch = entry.first;
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                               now - state.channelData[ch].lastChangeTime)
+                               .count();
+            if (elapsed > CHANGE_HIGHLIGHT_MS)
+            {
+                channelsToRemove.push_back(ch);
+            }
+        }
+        for (int ch : channelsToRemove)
+        {
+            state.changedChannels.erase(ch);
+        }
+    }
+
+    // Analysis side: publish the results of the frame just processed
+    void publishFrameSnapshot(int deviceIndex, uint64_t frameSequence)
+    {
+        const DeviceState &state = m_deviceStates[deviceIndex];
+        const int sliceCount = std::min(m_timeSliceCounts[deviceIndex], SNAPSHOT_MAX_SLICES);
+        m_snapshots[deviceIndex]->update([&](DeviceSnapshot &snapshot)
+                                         {
+            snapshot.capturesCount = state.capturesCount;
+            snapshot.lastCaptureTime = state.lastCaptureTime;
+            snapshot.frameSequence = frameSequence;
+            snapshot.sliceCount = sliceCount;
+            snapshot.changedMask = 0;
             for (const auto &entry : state.changedChannels)
             {
-                int ch = entry.first;
-                auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
-                                   now - state.channelData[ch].lastChangeTime)
-                                   .count();
-                if (elapsed > CHANGE_HIGHLIGHT_MS)
+                snapshot.changedMask |= 1u << entry.first;
+            }
+            for (int ch = 0; ch < 32; ch++)
+            {
+                const ChannelData &channel = state.channelData[ch];
+                ChannelSnapshot &out = snapshot.channels[ch];
+                out.currentState = channel.currentState;
+                out.transitions = channel.transitions;
+                out.totalTransitions = channel.totalTransitions;
+                out.changed = channel.changed;
+                out.meanPhase = channel.meanPhase;
+                out.phaseVariance = channel.phaseVariance;
+                out.dutyCycle = channel.dutyCycle;
+                out.meanHighPulseUs = channel.meanHighPulseUs;
+                out.lastChangeTime = channel.lastChangeTime;
+                const int slices = std::min(sliceCount, static_cast<int>(channel.sliceActivityLevels.size()));
+                for (int slice = 0; slice < SNAPSHOT_MAX_SLICES; slice++)
                 {
-                    channelsToRemove.push_back(ch);
+                    out.sliceActivityLevels[slice] = slice < slices ? channel.sliceActivityLevels[slice] : 0.0;
                 }
-            }
-            for (int ch : channelsToRemove)
+            } });
+    }
+
+    // Analysis side: append this frame's results to the shared-memory ring
+    void appendResultsRecord(int deviceIndex, uint64_t frameSequence)
+    {
+        if (!m_resultsRing.isOpen())
+            return;
+
+        const DeviceState &state = m_deviceStates[deviceIndex];
+        ResultsRecord record;
+        std::memset(&record, 0, sizeof(record));
+        record.frameSequence = frameSequence;
+        record.captureTimeMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                   state.lastCaptureTime.time_since_epoch())
+                                   .count();
+        record.deviceIndex = static_cast<uint32_t>(deviceIndex);
+        record.sliceCount = static_cast<uint32_t>(std::min(m_timeSliceCounts[deviceIndex], SNAPSHOT_MAX_SLICES));
+        for (const auto &entry : state.changedChannels)
+        {
+            record.changedMask |= 1u << entry.first;
+        }
+        for (int ch = 0; ch < 32; ch++)
+        {
+            const ChannelData &channel = state.channelData[ch];
+            record.stateMask |= (channel.currentState & 1u) << ch;
+            record.transitions[ch] = channel.transitions;
+        }
+        for (int ch = 0; ch < PHASE_CHANNELS; ch++)
+        {
+            const ChannelData &channel = state.channelData[ch];
+            const size_t slices = std::min<size_t>(record.sliceCount, channel.sliceActivityLevels.size());
+            for (size_t slice = 0; slice < slices; slice++)
             {
-                state.changedChannels.erase(ch);
+                record.sliceActivity[ch][slice] = static_cast<float>(channel.sliceActivityLevels[slice]);
             }
-            std::this_thread::sleep_for(std::chrono::milliseconds(m_configs[deviceIndex].scanIntervalMs));
+            record.meanPhase[ch] = static_cast<float>(channel.meanPhase);
+            record.phaseVariance[ch] = static_cast<float>(channel.phaseVariance);
+        }
+        m_resultsRing.append(record);
+    }
+
+    // Analysis side: hand this frame's channel values to the push server,
+    // which sends the ones that changed to subscribed clients
+    void pushFrameDelta(int deviceIndex, const CaptureFrame &frame)
+    {
+        if (!m_pushServer.isRunning())
+            return;
+
+        const DeviceState &state = m_deviceStates[deviceIndex];
+        PushChannelValue channels[PushServer::CHANNELS];
+        for (int ch = 0; ch < PushServer::CHANNELS; ch++)
+        {
+            const ChannelData &channel = state.channelData[ch];
+            channels[ch].state = channel.currentState;
+            channels[ch].transitions = channel.transitions;
+            channels[ch].totalTransitions = channel.totalTransitions;
         }
+        const int64_t timeMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                   state.lastCaptureTime.time_since_epoch())
+                                   .count();
+        m_pushServer.publish(deviceIndex, frame.sequence, timeMs, channels);
+
+        // Zoomable waveforms for /waveform, only while someone is fetching
+        // them. The bitsliced layout has already transposed the frame and
+        // bitSliced() hands back that copy; other layouts transpose here.
+        if (m_pushServer.wantsWaveform(deviceIndex))
+            m_pushServer.publishWaveform(deviceIndex, frame.sequence, WaveformPyramid::build(frame.bitSliced()));
+    }
+
+    // Capture side: publish connection state and error counters
+    void publishHealthSnapshot(int deviceIndex)
+    {
+        const DeviceState &state = m_deviceStates[deviceIndex];
+        m_snapshots[deviceIndex]->update([&](DeviceSnapshot &snapshot)
+                                         {
+            snapshot.connected = state.connected;
+            snapshot.active = state.active;
+            snapshot.consecutiveErrors = state.consecutiveErrors;
+            snapshot.errorsCount = state.errorsCount; });
+    }
+
+    DeviceSnapshot getSnapshot(int deviceIndex) const
+    {
+        return m_snapshots[deviceIndex]->read();
     }
 
     void handleDeviceError(int deviceIndex, const std::string &errorMsg)
@@ -1434,7 +1927,8 @@ public:
 
     bool loadConfiguration(int deviceIndex)
     {
-        if (deviceIndex >= m_configs.size())
+        TraceScope trace("load config", "config", "device", deviceIndex);
+        if (deviceIndex < 0 || static_cast<size_t>(deviceIndex) >= m_configs.size())
         {
             return false;
         }
@@ -1520,6 +2014,75 @@ public:
                 {
                     m_configs[deviceIndex].triggerRisingEdge = (value == "1" || value == "true");
                 }
+                else if (key == "analysis_layout")
+                {
+                    if (value == "packed")
+                    {
+                        m_configs[deviceIndex].analysisLayout = AnalysisLayout::PACKED;
+                    }
+                    else if (value == "bitsliced")
+                    {
+                        m_configs[deviceIndex].analysisLayout = AnalysisLayout::BITSLICED;
+                    }
+                    else if (value == "edges")
+                    {
+                        m_configs[deviceIndex].analysisLayout = AnalysisLayout::EDGES;
+                    }
+                }
+                else if (key == "pipeline_mode")
+                {
+                    m_configs[deviceIndex].pipelineMode = (value == "1" || value == "true");
+                }
+                else if (key == "pipeline_queue_depth")
+                {
+                    int depth = std::stoi(value);
+                    if (depth >= 1 && depth <= 64)
+                    {
+                        m_configs[deviceIndex].pipelineQueueDepth = depth;
+                    }
+                }
+                else if (key == "buffer_pool_size")
+                {
+                    int size = std::stoi(value);
+                    if (size >= 0 && size <= 256)
+                    {
+                        m_configs[deviceIndex].bufferPoolSize = size;
+                    }
+                }
+                else if (key == "buffer_pool_policy")
+                {
+                    if (value == "block")
+                    {
+                        m_configs[deviceIndex].bufferPoolPolicy = BufferPoolPolicy::BLOCK;
+                    }
+                    else if (value == "drop")
+                    {
+                        m_configs[deviceIndex].bufferPoolPolicy = BufferPoolPolicy::DROP;
+                    }
+                }
+                else if (key == "buffer_pool_memory")
+                {
+                    if (value == "normal")
+                    {
+                        m_configs[deviceIndex].bufferPoolMemory = BufferPoolMemory::NORMAL;
+                    }
+                    else if (value == "locked")
+                    {
+                        m_configs[deviceIndex].bufferPoolMemory = BufferPoolMemory::LOCKED;
+                    }
+                    else if (value == "large")
+                    {
+                        m_configs[deviceIndex].bufferPoolMemory = BufferPoolMemory::LARGE_PAGES;
+                    }
+                }
+                else if (key == "frame_history")
+                {
+                    int history = std::stoi(value);
+                    if (history >= 0 && history <= 64)
+                    {
+                        m_configs[deviceIndex].frameHistory = history;
+                    }
+                }
                 else if (key.substr(0, 8) == "channel_")
                 {
                     // Parse channel name (format: channel_X=Name)
@@ -1528,6 +2091,7 @@ public:
                         int ch = std::stoi(key.substr(8));
                         if (ch >= 0 && ch < 32)
                         {
+                            std::lock_guard<std::mutex> lock(m_channelNamesMutex);
                             m_channelNames[ch] = value;
                         }
                     }
@@ -1549,7 +2113,7 @@ public:
         struct stat configStat;
         if (stat(configPath.c_str(), &configStat) == 0)
         {
-            if (deviceIndex >= m_lastConfigModified.size())
+            if (deviceIndex < 0 || static_cast<size_t>(deviceIndex) >= m_lastConfigModified.size())
             {
                 m_lastConfigModified.resize(deviceIndex + 1, 0);
             }
@@ -1561,7 +2125,7 @@ public:
 
     void saveConfiguration(int deviceIndex)
     {
-        if (deviceIndex >= m_configs.size())
+        if (deviceIndex < 0 || static_cast<size_t>(deviceIndex) >= m_configs.size())
         {
             return;
         }
@@ -1572,6 +2136,7 @@ public:
 
         configFile << "# Logic Analyzer Configuration File for Device " << deviceIndex << "\n";
         configFile << "# Sample rate codes: 0=1MHz, 1=2MHz, 2=5MHz, 3=10MHz, 4=20MHz, 5=25MHz, 6=50MHz, 7=80MHz, 8=100MHz\n";
+        configFile << "# Codes 9-12 are passed to the device, but their rates are unknown to the monitor\n";
         configFile << "sample_rate_code=" << m_configs[deviceIndex].sampleRateCode << "\n";
         configFile << "sample_depth=" << m_configs[deviceIndex].sampleDepth << "\n";
         configFile << "scan_interval_ms=" << m_configs[deviceIndex].scanIntervalMs << "\n";
@@ -1579,11 +2144,22 @@ public:
         configFile << "enable_trigger=" << (m_configs[deviceIndex].enableTrigger ? "1" : "0") << "\n";
         configFile << "trigger_channel=" << m_configs[deviceIndex].triggerChannel << "\n";
         configFile << "trigger_rising_edge=" << (m_configs[deviceIndex].triggerRisingEdge ? "1" : "0") << "\n";
+        configFile << "# Previous capture frames kept in memory (0-64)\n";
+        configFile << "frame_history=" << m_configs[deviceIndex].frameHistory << "\n";
+        configFile << "# Analysis sample layout: packed, bitsliced or edges (best for sparse signals)\n";
+        configFile << "analysis_layout=" << getAnalysisLayoutName(m_configs[deviceIndex].analysisLayout) << "\n";
+        configFile << "# Pipeline mode re-arms the device while the previous frame is analyzed\n";
+        configFile << "pipeline_mode=" << (m_configs[deviceIndex].pipelineMode ? "1" : "0") << "\n";
+        configFile << "pipeline_queue_depth=" << m_configs[deviceIndex].pipelineQueueDepth << "\n";
+        configFile << "# Capture buffer pool: size (0 = automatic), policy block|drop, memory normal|locked|large\n";
+        configFile << "buffer_pool_size=" << m_configs[deviceIndex].bufferPoolSize << "\n";
+        configFile << "buffer_pool_policy=" << (m_configs[deviceIndex].bufferPoolPolicy == BufferPoolPolicy::DROP ? "drop" : "block") << "\n";
+        configFile << "buffer_pool_memory=" << getBufferPoolMemoryName(m_configs[deviceIndex].bufferPoolMemory) << "\n";
 
         // Save channel names
         for (int i = 0; i < 32; i++)
         {
-            configFile << "channel_" << i << "=" << m_channelNames[i] << "\n";
+            configFile << "channel_" << i << "=" << channelName(i) << "\n";
         }
 
         configFile.close();
@@ -1592,7 +2168,7 @@ public:
         struct stat configStat;
         if (stat(m_configs[deviceIndex].configFilePath.c_str(), &configStat) == 0)
         {
-            if (deviceIndex >= m_lastConfigModified.size())
+            if (deviceIndex < 0 || static_cast<size_t>(deviceIndex) >= m_lastConfigModified.size())
             {
                 m_lastConfigModified.resize(deviceIndex + 1, 0);
             }
@@ -1602,7 +2178,8 @@ public:
 
     bool applyConfiguration(int deviceIndex)
     {
-        if (deviceIndex >= m_devices.size() || deviceIndex >= m_configs.size())
+        if (deviceIndex < 0 || static_cast<size_t>(deviceIndex) >= m_devices.size() ||
+            static_cast<size_t>(deviceIndex) >= m_configs.size())
         {
             return false;
         }
@@ -1622,6 +2199,7 @@ public:
         {
             return false;
         }
+        updateBufferPool(deviceIndex);
 
         // Set voltage threshold (always use 1.7)
         device.setVoltageThreshold(1.7);
@@ -1634,25 +2212,87 @@ public:
 
         return true;
     }
+    std::string channelName(int channel) const
+    {
+        std::lock_guard<std::mutex> lock(m_channelNamesMutex);
+        auto it = m_channelNames.find(channel);
+        return it != m_channelNames.end() ? it->second : std::string();
+    }
+
     unsigned long getSamplingRateFromCode(unsigned short code)
     {
-        switch (code)
+        return sampleRateFromCode(code);
+    }
+
+    // Number of frames that can be alive at once: the one being captured, the
+    // one held as the latest result, the history, (in pipeline mode) the
+    // queue plus the frame under analysis and (when recording or archiving)
+    // the frames waiting for the writer plus the one being encoded
+    int getBufferPoolSize(const AnalyzerConfig &config) const
+    {
+        if (config.bufferPoolSize > 0)
+        {
+            return config.bufferPoolSize;
+        }
+        return config.frameHistory + 2 + (config.pipelineMode ? config.pipelineQueueDepth + 1 : 0) +
+               (m_options.recordDirectory.empty() ? 0 : CaptureRecorder::MAX_PENDING + 1) +
+               (m_options.archiveDirectory.empty() ? 0 : CaptureArchiver::MAX_PENDING + 1);
+    }
+
+    static const char *getAnalysisLayoutName(AnalysisLayout layout)
+    {
+        switch (layout)
+        {
+        case AnalysisLayout::BITSLICED:
+            return "bitsliced";
+        case AnalysisLayout::EDGES:
+            return "edges";
+        default:
+            return "packed";
+        }
+    }
+
+    static const char *getBufferPoolMemoryName(BufferPoolMemory memory)
+    {
+        switch (memory)
         {
-        case 0:
-            return 1000000; // 1 MS/s
-        case 1:
-            return 2000000; // 2 MS/s
-        case 2:
-            return 5000000; // 5 MS/s
-        // ... add cases 3-12 as per your device specs
+        case BufferPoolMemory::LOCKED:
+            return "locked";
+        case BufferPoolMemory::LARGE_PAGES:
+            return "large";
         default:
-            return 100000000; // Default 100 MS/s
+            return "normal";
+        }
+    }
+
+    // (Re)build the device's capture buffer pool when its shape changed.
+    // Frames still holding buffers of a replaced pool keep that pool alive
+    // until they are released.
+    void updateBufferPool(int deviceIndex)
+    {
+        HantekDevice &device = m_devices[deviceIndex];
+        const AnalyzerConfig &config = m_configs[deviceIndex];
+        const size_t bufferCount = static_cast<size_t>(getBufferPoolSize(config));
+
+        std::shared_ptr<CaptureBufferPool> pool = device.getBufferPool();
+        if (pool && pool->samplesPerBuffer() == config.sampleDepth &&
+            pool->bufferCount() == bufferCount && pool->memory() == config.bufferPoolMemory)
+        {
+            return;
         }
+
+        // Drop the old pool first so its memory can be reused
+        device.setBufferPool(nullptr);
+        pool.reset();
+        device.setBufferPool(CaptureBufferPool::create(bufferCount, config.sampleDepth, config.bufferPoolMemory));
     }
 
+    // Whether the device's config file was modified since it was last read;
+    // checked every 3 seconds
     bool checkConfigurationChanges(int deviceIndex)
     {
-        if (deviceIndex >= m_configs.size() || deviceIndex >= m_lastConfigModified.size())
+        if (deviceIndex < 0 || static_cast<size_t>(deviceIndex) >= m_configs.size() ||
+            static_cast<size_t>(deviceIndex) >= m_lastConfigModified.size())
         {
             return false;
         }
@@ -1677,10 +2317,19 @@ public:
         if (stat(configPath.c_str(), &configStat) != 0)
             return false;
 
-        if (configStat.st_mtime <= m_lastConfigModified[deviceIndex])
-            return false;
+        return configStat.st_mtime > m_lastConfigModified[deviceIndex];
+    }
 
-        m_lastConfigModified[deviceIndex] = configStat.st_mtime;
+    // Reread the modified config file and apply it; returns true when the
+    // device had to be reconfigured. The device's analysis must not be
+    // running, since processData reads the config and sampling rate.
+    bool reloadConfiguration(int deviceIndex)
+    {
+        struct stat configStat;
+        if (stat(m_configs[deviceIndex].configFilePath.c_str(), &configStat) == 0)
+        {
+            m_lastConfigModified[deviceIndex] = configStat.st_mtime;
+        }
 
         // Store the old configuration for comparison
         AnalyzerConfig oldConfig = m_configs[deviceIndex];
@@ -1704,6 +2353,12 @@ public:
             deviceNeedsReconfiguration = true;
         }
 
+        // Pool sizing also follows history and pipeline settings
+        if (!deviceNeedsReconfiguration)
+        {
+            updateBufferPool(deviceIndex);
+        }
+
         // Apply device changes if needed
         if (deviceNeedsReconfiguration)
         {
@@ -1719,28 +2374,66 @@ public:
         return deviceNeedsReconfiguration;
     }
 
-    void processData(int deviceIndex, const std::vector<uint32_t> &capturedData)
+    void processData(int deviceIndex, const CaptureFramePtr &frame)
     {
-      
+        TraceScope trace("processData", "analysis", "device", deviceIndex);
+        TraceScope analyzeTrace("analyze", "analysis", "device", deviceIndex);
+        PipelineStats &stats = *m_pipelineStats[deviceIndex];
+        const auto analyzeStartTime = std::chrono::steady_clock::now();
+        const uint32_t *capturedData = frame->data();
         DeviceState &state = m_deviceStates[deviceIndex];
+
+        // Statistics resets are applied here, on the thread that owns the counters
+        const unsigned resetGeneration = m_statsResetRequests[deviceIndex].load();
+        if (resetGeneration != state.analysisResetGeneration)
+        {
+            state.analysisResetGeneration = resetGeneration;
+            state.capturesCount = 0;
+            for (ChannelData &channel : state.channelData)
+            {
+                channel.totalTransitions = 0;
+                channel.transitions = 0;
+            }
+            state.changedChannels.clear();
+        }
         const unsigned long samplingRate = m_deviceSamplingRates[deviceIndex];
         const int numSlices = m_timeSliceCounts[deviceIndex];
         const double timeWindow = m_timeWindows[deviceIndex];
 
         // Calculate samples per slice
-        const size_t totalSamples = capturedData.size();
+        const size_t totalSamples = frame->size();
         const size_t samplesPerSlice = totalSamples / numSlices;
 
         // Get current time for change timestamp
         auto now = std::chrono::system_clock::now();
 
+        // Count edges for all 32 channels and every slice in a single pass
+        const AnalysisLayout layout = m_configs[deviceIndex].analysisLayout;
+        std::shared_ptr<const BitSlicedFrame> bitSliced;
+        std::shared_ptr<const EdgeListFrame> edgeList;
+        TransitionCounts counts;
+        if (layout == AnalysisLayout::BITSLICED)
+        {
+            bitSliced = frame->bitSliced();
+            bitSliced->countTransitions(numSlices, counts);
+        }
+        else if (layout == AnalysisLayout::EDGES)
+        {
+            edgeList = frame->edgeList();
+            edgeList->countTransitions(numSlices, counts);
+        }
+        else
+        {
+            TransitionCounter::count(capturedData, totalSamples, numSlices, counts);
+        }
+
         // Process each channel
         for (int ch = 0; ch < 32; ch++)
         {
             // Initialize channel data if first time
-            if (state.channelData[ch].samples.empty())
+            if (!state.channelData[ch].frame)
             {
-                state.channelData[ch].samples = capturedData;
+                state.channelData[ch].frame = frame;
                 state.channelData[ch].currentState = (capturedData[0] >> ch) & 1;
                 state.channelData[ch].transitions = 0;
                 state.channelData[ch].totalTransitions = 0;
@@ -1748,46 +2441,25 @@ public:
                 continue;
             }
             state.channelData[ch].sliceTransitions.assign(numSlices, 0);
+            state.channelData[ch].sliceActivityLevels.resize(numSlices, 0.0);
 
-            // Extract channel bit from each sample
-            int transitions = 0;
-            uint32_t lastState = (capturedData[0] >> ch) & 1;
+            int transitions = static_cast<int>(counts.transitions[ch]);
+            uint32_t lastState = (counts.lastWord >> ch) & 1;
 
-            // Count transitions (changes in state)
-            for (size_t i = 1; i < totalSamples; i++)
-            {
-                uint32_t currentState = (capturedData[i] >> ch) & 1;
-                if (currentState != lastState)
-                {
-                    transitions++;
-                    lastState = currentState;
-                }
-            }
             // Process each time slice
             for (int slice = 0; slice < numSlices; slice++)
             {
                 size_t start = slice * samplesPerSlice;
                 size_t end = (slice == numSlices - 1) ? totalSamples : (slice + 1) * samplesPerSlice;
 
-                uint32_t lastState = (capturedData[start] >> ch) & 1;
-                int sliceTransitions = 0;
-
-                for (size_t i = start + 1; i < end; i++)
-                {
-                    uint32_t currentState = (capturedData[i] >> ch) & 1;
-                    if (currentState != lastState)
-                    {
-                        sliceTransitions++;
-                        lastState = currentState;
-                    }
-                }
-
+                int sliceTransitions = static_cast<int>(counts.sliceTransitions[slice][ch]);
                 state.channelData[ch].sliceTransitions[slice] = sliceTransitions;
 
                 // Calculate activity level (normalized 0-100)
+                // Unknown sample rate (code without a documented rate): no scale
                 double maxPossible = (end - start) * samplingRate * timeWindow;
                 state.channelData[ch].sliceActivityLevels[slice] =
-                    std::min<double>(100.0, (sliceTransitions / maxPossible) * 1000.0);
+                    maxPossible > 0 ? std::min<double>(100.0, (sliceTransitions / maxPossible) * 1000.0) : 0.0;
             }
 
         
@@ -1796,6 +2468,29 @@ public:
             state.channelData[ch].transitions = transitions;
             state.channelData[ch].totalTransitions += transitions;
 
+            // Duty cycle is a popcount of the channel's slice words; pulse
+            // widths only cost O(edges) on the edge lists, so they are only
+            // kept in that layout
+            if (bitSliced)
+            {
+                state.channelData[ch].dutyCycle =
+                    totalSamples ? bitSliced->countHigh(ch, 0, totalSamples) * 100.0 / totalSamples : 0.0;
+                state.channelData[ch].meanHighPulseUs = -1.0;
+            }
+            else if (edgeList)
+            {
+                PulseStats pulses;
+                edgeList->pulseStats(ch, pulses);
+                state.channelData[ch].dutyCycle = pulses.dutyCycle * 100.0;
+                state.channelData[ch].meanHighPulseUs =
+                    samplingRate ? pulses.meanHighWidth * 1e6 / samplingRate : -1.0;
+            }
+            else
+            {
+                state.channelData[ch].dutyCycle = -1.0;
+                state.channelData[ch].meanHighPulseUs = -1.0;
+            }
+
             // Check if channel has changed since last capture
             bool hasChanged = false;
 
@@ -1817,26 +2512,45 @@ public:
                 state.channelData[ch].changed = false;
             }
 
-            // Store raw sample data
-            state.channelData[ch].samples = capturedData;
+            // Point at the shared frame instead of copying the samples
+            state.channelData[ch].frame = frame;
+        }
+
+        // Keep the configured number of previous frames alive
+        const size_t historyLimit = static_cast<size_t>(m_configs[deviceIndex].frameHistory);
+        if (historyLimit > 0)
+        {
+            state.frameHistory.push_back(frame);
+        }
+        while (state.frameHistory.size() > historyLimit)
+        {
+            state.frameHistory.pop_front();
         }
         
-        // Phase analysis for first 12 channels
-        std::vector<std::future<void>> futures;
-        for (int ch = 0; ch < 12; ch++) {
-            futures.emplace_back(
-                m_threadPool->enqueue([this, deviceIndex, ch, &capturedData]{
-                    computeInstantaneousPhase(deviceIndex, ch, capturedData);
-                })
-            );
-        }
-        for(auto &future : futures) {
-            future.wait();
-        }
-        // Export phase data to TXT for Next.js and processing
-        exportPhaseDataTXT();
-        // Export data to file for this device
-        exportDeviceData(deviceIndex);
+        const auto phaseStartTime = std::chrono::steady_clock::now();
+        stats.record(PipelineStage::ANALYZE, phaseStartTime - analyzeStartTime);
+        analyzeTrace.end();
+
+        // Phase analysis for first 12 channels, all in one batch
+        TraceScope phaseTrace("phase", "analysis", "device", deviceIndex);
+        computePhaseBatch(deviceIndex, *frame);
+        phaseTrace.end();
+        const auto exportStartTime = std::chrono::steady_clock::now();
+        stats.record(PipelineStage::PHASE, exportStartTime - phaseStartTime);
+
+        state.capturesCount++;
+        state.lastCaptureTime = std::chrono::system_clock::now();
+        pruneChangedChannels(state);
+        publishFrameSnapshot(deviceIndex, frame->sequence);
+        appendResultsRecord(deviceIndex, frame->sequence);
+        pushFrameDelta(deviceIndex, *frame);
+
+        // The exporter thread writes the files for Next.js on its own schedule
+        m_exporter.markDirty(deviceIndex);
+        const auto endTime = std::chrono::steady_clock::now();
+        stats.record(PipelineStage::EXPORT, endTime - exportStartTime);
+        stats.record(PipelineStage::FRAME, endTime - analyzeStartTime);
+        stats.frameDone(frame->size());
     }
     
     
@@ -1844,9 +2558,9 @@ public:
     
     void exportTimeSlicedData()
     {
-        std::lock_guard<std::mutex> lock(m_fileMutex);
+        std::unique_lock<std::mutex> lock = lockFiles();
 
-        std::string outputPath = OUTPUT_DIRECTORY + "\\time_sliced_data.txt";
+        std::string outputPath = outputFilePath("time_sliced_data.txt");
         std::ofstream outFile(outputPath);
 
         if (!outFile.is_open())
@@ -1855,59 +2569,143 @@ public:
             return;
         }
 
-        // Header
-        outFile << "# Time-sliced neural activity data\n";
-        outFile << "# Format:device_id,channel_id,slice0_activity,slice1_activity,slice2_activity,slice3_activity,slice4_activity\n";
-
-        for (int deviceIndex = 0; deviceIndex < m_deviceStates.size(); deviceIndex++)
+        output_writers::writeTimeSlicedData(outFile, collectExportedDevices());
+        outFile.close();
+    }
+    // Runs on the exporter thread: rewrite every output once for all the
+    // devices that produced frames since the last call, or just refresh
+    // logic_data.txt and the live state as a heartbeat when none did
+    void exportOutputs(uint64_t dirtyDevices)
+    {
+        // Each writer is timed as its own stage
+        if (m_options.textExports)
         {
-            const DeviceState &state = m_deviceStates[deviceIndex];
-            if (!state.connected)
-                continue;
-
-            // Only process first 12 channels (brain probes)
-            for (int ch = 0; ch < 12; ch++)
+            if (dirtyDevices != 0)
             {
-                const ChannelData &chData = state.channelData[ch];
-                outFile << deviceIndex << "," << ch;
-
-                // Slice activity levels
-                for (size_t i = 0; i < chData.sliceActivityLevels.size(); i++)
                 {
-                    outFile << "," << std::fixed << std::setprecision(1) << chData.sliceActivityLevels[i];
+                    StageTimer timer(m_exportStats, PipelineStage::WRITE_PHASE);
+                    TraceScope trace("write phase_data", "io");
+                    exportPhaseDataTXT();
+                }
+                {
+                    StageTimer timer(m_exportStats, PipelineStage::WRITE_SLICES);
+                    TraceScope trace("write time_sliced_data", "io");
+                    exportTimeSlicedData();
                 }
-                outFile << "\n";
             }
+            StageTimer timer(m_exportStats, PipelineStage::WRITE_MONITOR);
+            TraceScope trace("write logic_data", "io");
+            exportNeuralMonitorData();
         }
+        StageTimer timer(m_exportStats, PipelineStage::WRITE_LIVE_STATE);
+        TraceScope trace("write live_state", "io");
+        exportLiveState();
+    }
 
-        outFile.close();
+    // One line of totals over all devices, for the logs of a headless run
+    void writeStatusLine(std::ostream &out)
+    {
+        uint64_t frames = 0, dropped = 0;
+        double framesPerSecond = 0.0, samplesPerSecond = 0.0;
+        for (int i = 0; i < m_numDevices; i++)
+        {
+            if (!m_deviceStates[i].connected)
+            {
+                continue;
+            }
+            const PipelineStats::Snapshot snapshot = m_pipelineStats[i]->snapshot();
+            frames += snapshot.frames;
+            framesPerSecond += snapshot.framesPerSecond();
+            samplesPerSecond += snapshot.samplesPerSecond();
+            dropped += m_frameQueues[i]->droppedFrames();
+        }
+        const std::time_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+        char timestamp[32];
+        std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", std::localtime(&now));
+        out << timestamp << " | devices " << m_activeDevices << "/" << m_numDevices << " | frames " << frames
+            << std::fixed << std::setprecision(1) << " | " << framesPerSecond << " frames/s | "
+            << samplesPerSecond / 1e6 << " MS/s | dropped " << dropped << std::endl;
+    }
+
+    // Take m_fileMutex; the wait is traced so contention on it is visible
+    std::unique_lock<std::mutex> lockFiles()
+    {
+        TraceScope trace("file lock", "io");
+        return std::unique_lock<std::mutex>(m_fileMutex);
     }
-    // Export device data to a file for neural visualization
-    void exportDeviceData(int deviceIndex)
+
+    // Write the trace recorded so far to trace_<timestamp>.json in the output directory
+    void dumpTrace()
     {
-        if (deviceIndex >= m_deviceStates.size())
+        const std::time_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+        char name[64];
+        std::strftime(name, sizeof(name), "trace_%Y%m%d_%H%M%S.json", std::localtime(&now));
+        const std::string path = outputFilePath(name); // Next to the other outputs
+        size_t events = 0;
+        if (TraceRecorder::instance().dump(path, &events))
         {
-            return;
+            std::cout << "\nTrace written to " << path << " (" << events << " events)\n";
         }
+        else
+        {
+            std::cout << "\nTrace dump failed: " << TraceRecorder::instance().getLastError() << "\n";
+        }
+    }
 
-        const DeviceState &state = m_deviceStates[deviceIndex];
+    // Snapshots of the connected devices for the writers in output_writers.h.
+    // The vector is kept between calls, so once it has grown to the device
+    // count an export allocates nothing for it. Exporter thread only.
+    const std::vector<ExportedDevice> &collectExportedDevices()
+    {
+        std::vector<ExportedDevice> &devices = m_exportedDevices;
+        devices.resize(m_deviceStates.size());
+        size_t connected = 0;
+        for (size_t deviceIndex = 0; deviceIndex < m_deviceStates.size(); deviceIndex++)
+        {
+            ExportedDevice &device = devices[connected];
+            device.state = getSnapshot(static_cast<int>(deviceIndex));
+            if (device.state.connected)
+            {
+                device.deviceIndex = static_cast<int>(deviceIndex);
+                device.serialNumber = &m_deviceStates[deviceIndex].serialNumber;
+                device.model = &m_deviceStates[deviceIndex].model;
+                connected++;
+            }
+        }
+        devices.resize(connected);
+        return devices;
+    }
 
-        if (!state.connected || !state.active)
+    // Channel names for the text outputs, indexed by channel
+    const std::vector<std::string> &collectChannelNames()
+    {
+        m_exportChannelNames.resize(32);
+        for (int ch = 0; ch < 32; ch++)
         {
-            return;
+            m_exportChannelNames[ch] = channelName(ch);
         }
+        return m_exportChannelNames;
+    }
 
-        // Create a combined output for neural visualization
-        exportNeuralMonitorData();
-        exportTimeSlicedData();
-        
+    // Write every connected device to live_state.bin in one atomic replace
+    void exportLiveState()
+    {
+        std::unique_lock<std::mutex> lock = lockFiles();
+
+        // The file image is kept between calls as well
+        output_writers::fillLiveState(m_liveState, collectExportedDevices(), std::chrono::system_clock::now());
+        if (!m_liveState.commit(m_liveStatePath))
+        {
+            std::cerr << "Failed to write live state: " << m_liveState.getLastError() << std::endl;
+        }
     }
+
     // Export consolidated neural monitor data for all devices
     void exportNeuralMonitorData()
     {
-        std::lock_guard<std::mutex> lock(m_fileMutex);
+        std::unique_lock<std::mutex> lock = lockFiles();
 
-        std::string outputPath = OUTPUT_DIRECTORY + "\\" + OUTPUT_FILENAME;
+        std::string outputPath = outputFilePath(OUTPUT_FILENAME);
         std::ofstream outputFile(outputPath);
 
         if (!outputFile.is_open())
@@ -1916,100 +2714,28 @@ public:
             return;
         }
 
-        // Get current timestamp
-        auto now = std::chrono::system_clock::now();
-        std::time_t now_c = std::chrono::system_clock::to_time_t(now);
-        struct tm *timeinfo = std::localtime(&now_c);
-        char timestamp[100];
-        std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", timeinfo);
-
-        // Write header
-        outputFile << "# Neural Monitor Data - Updated: " << timestamp << "\n";
-        outputFile << "# Format: [device_id],[serial],[model],[channel_id],[state],[transitions],[active]\n\n";
-
-        // Write data for all devices
-        for (int deviceIndex = 0; deviceIndex < m_deviceStates.size(); deviceIndex++)
-        {
-            const DeviceState &state = m_deviceStates[deviceIndex];
-
-            // Skip disconnected devices
-            if (!state.connected)
-            {
-                continue;
-            }
-
-            // Write device header
-            outputFile << "DEVICE," << deviceIndex << "," << state.serialNumber << ","
-                       << state.model << "," << state.capturesCount << "\n";
-
-            // Write channel data
-            for (int ch = 0; ch < 32; ch++)
-            {
-                // Only include channels that have shown some activity
-                if (state.channelData[ch].totalTransitions > 0)
-                {
-                    // Calculate activity level based on recent changes (0-100)
-                    int activityLevel = 0;
-
-                    if (state.changedChannels.find(ch) != state.changedChannels.end())
-                    {
-                        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
-                                           now - state.channelData[ch].lastChangeTime)
-                                           .count();
-
-                        // More recent changes get higher activity levels
-                        if (elapsed < 500)
-                        {
-                            activityLevel = 100;
-                        }
-                        else if (elapsed < 1000)
-                        {
-                            activityLevel = 75;
-                        }
-                        else if (elapsed < 2000)
-                        {
-                            activityLevel = 50;
-                        }
-                        else
-                        {
-                            activityLevel = 25;
-                        }
-                    }
-
-                    // Format: channel_id, name, current_state, transitions, total_transitions, activity_level
-                    outputFile << "CHANNEL," << ch << "," << m_channelNames[ch] << ","
-                               << state.channelData[ch].currentState << ","
-                               << state.channelData[ch].transitions << ","
-                               << state.channelData[ch].totalTransitions << ","
-                               << activityLevel << "\n";
-                }
-            }
-           
-            outputFile << "\n";
-        }
-
+        output_writers::writeLogicData(outputFile, collectExportedDevices(), collectChannelNames(),
+                                       std::chrono::system_clock::now());
         outputFile.close();
     }
 
     void resetStatistics(int deviceIndex)
     {
-        if (deviceIndex < 0 || deviceIndex >= m_deviceStates.size())
+        if (deviceIndex < 0 || static_cast<size_t>(deviceIndex) >= m_deviceStates.size())
             return;
 
-        DeviceState &state = m_deviceStates[deviceIndex];
-        state.capturesCount = 0;
-        state.errorsCount = 0;
-        state.consecutiveErrors = 0;
-
-        // Reset channel statistics
-        for (int ch = 0; ch < 32; ch++)
+        // The counters belong to the device threads; they reset them before
+        // their next capture and frame
+        m_statsResetRequests[deviceIndex]++;
+        m_frameQueues[deviceIndex]->resetCounters();
+        m_pipelineStats[deviceIndex]->reset();
+        m_exportStats.reset();
+        m_exporter.resetStats();
+        std::shared_ptr<CaptureBufferPool> pool = m_devices[deviceIndex].getBufferPool();
+        if (pool)
         {
-            state.channelData[ch].totalTransitions = 0;
-            state.channelData[ch].transitions = 0;
+            pool->resetStats();
         }
-
-        // Clear changed channels
-        state.changedChannels.clear();
     }
 
     std::string getDisplayModeName() const
@@ -2022,26 +2748,35 @@ public:
             return "Details";
         case DisplayMode::ACTIVITY:
             return "Activity";
+        case DisplayMode::STATS:
+            return "Stats";
         default:
             return "Unknown";
         }
     }
 
+    // Draw the current view into the screen buffer and send the terminal
+    // only what changed since the last refresh
     void displayResults()
     {
-        // Clear screen
-        system("cls");
+        int rows = 0, columns = 0;
+        if (platform::terminalSize(rows, columns))
+        {
+            m_screen.setSize(rows, columns);
+        }
+        m_screen.begin();
+        std::ostream &out = m_screen.stream();
 
         // Display header
-        std::cout << "======== HANTEK MULTI-DEVICE NEURAL ANALYZER ========\n";
-        std::cout << "Active Devices: " << m_activeDevices << "/" << m_numDevices << " | ";
-        std::cout << "Display Mode: " << getDisplayModeName() << "\n";
-        std::cout << "Press 'Q' to quit, 'R' to reset statistics, 'C' to reload config, 'D' to change display mode\n\n";
+        out << "======== HANTEK MULTI-DEVICE NEURAL ANALYZER ========\n";
+        out << "Active Devices: " << m_activeDevices << "/" << m_numDevices << " | ";
+        out << "Display Mode: " << getDisplayModeName() << "\n";
+        out << "Press 'Q' to quit, 'R' to reset statistics, 'C' to reload config, 'D' to change display mode\n\n";
 
         // Current timestamp
         auto now = std::chrono::system_clock::now();
         std::time_t now_c = std::chrono::system_clock::to_time_t(now);
-        std::cout << "Last update: " << std::ctime(&now_c);
+        out << "Last update: " << std::ctime(&now_c);
 
         // Display according to mode
         switch (m_displayMode)
@@ -2055,36 +2790,45 @@ public:
         case DisplayMode::ACTIVITY:
             displayActivityView();
             break;
+        case DisplayMode::STATS:
+            displayStatsView();
+            break;
+        default:
+            break;
         }
+        m_screen.present();
     }
 
     void displaySummaryView()
     {
+        std::ostream &out = m_screen.stream();
         // Show summary of all devices
-        std::cout << "Device | Status   | Serial   | Model    | Active Channels\n";
-        std::cout << "-------+----------+----------+----------+----------------\n";
+        out << "Device | Status   | Serial   | Model    | Active Channels\n";
+        out << "-------+----------+----------+----------+----------------\n";
+        const auto now = std::chrono::system_clock::now();
         for (int i = 0; i < m_numDevices; i++)
         {
-            const DeviceState &state = m_deviceStates[i];
+            const DeviceSnapshot state = getSnapshot(i);
+            const DeviceState &info = m_deviceStates[i];
             if (!state.connected)
             {
-                ConsoleColors::setColor(ConsoleColors::DARKGRAY);
-                std::cout << std::setw(6) << i << " | ";
-                std::cout << "NOT FOUND | ";
-                std::cout << std::setw(8) << "-" << " | ";
-                std::cout << std::setw(8) << "-" << " | ";
-                std::cout << "-" << std::endl;
-                ConsoleColors::resetColor();
+                m_screen.setColor(ConsoleColors::DARKGRAY);
+                out << std::setw(6) << i << " | ";
+                out << "NOT FOUND | ";
+                out << std::setw(8) << "-" << " | ";
+                out << std::setw(8) << "-" << " | ";
+                out << "-" << std::endl;
+                m_screen.resetColor();
                 continue;
             }
             int activeChannels = 0;
             int changingChannels = 0;
             for (int ch = 0; ch < 32; ch++)
             {
-                if (state.channelData[ch].totalTransitions > 0)
+                if (state.channels[ch].totalTransitions > 0)
                 {
                     activeChannels++;
-                    if (state.changedChannels.find(ch) != state.changedChannels.end())
+                    if (state.isChanging(ch, now))
                     {
                         changingChannels++;
                     }
@@ -2092,59 +2836,63 @@ public:
             }
             if (!state.active)
             {
-                ConsoleColors::setColor(ConsoleColors::RED);
+                m_screen.setColor(ConsoleColors::RED);
             }
             else if (state.consecutiveErrors > 0)
             {
-                ConsoleColors::setColor(ConsoleColors::YELLOW);
+                m_screen.setColor(ConsoleColors::YELLOW);
             }
             else if (changingChannels > 0)
             {
-                ConsoleColors::setColor(ConsoleColors::LIGHTGREEN);
+                m_screen.setColor(ConsoleColors::LIGHTGREEN);
             }
             else
             {
-                ConsoleColors::setColor(ConsoleColors::LIGHTGRAY);
+                m_screen.setColor(ConsoleColors::LIGHTGRAY);
             }
-            std::cout << std::setw(6) << i << " | ";
+            out << std::setw(6) << i << " | ";
             if (!state.active)
             {
-                std::cout << "ERROR     | ";
+                out << "ERROR     | ";
             }
             else if (state.consecutiveErrors > 0)
             {
-                std::cout << "WARNING   | ";
+                out << "WARNING   | ";
             }
             else
             {
-                std::cout << "OK        | ";
+                out << "OK        | ";
             }
-            std::cout << std::setw(8) << state.serialNumber.substr(0, 8) << " | ";
-            std::cout << std::setw(8) << state.model.substr(0, 8) << " | ";
+            out << std::setw(8) << info.serialNumber.substr(0, 8) << " | ";
+            out << std::setw(8) << info.model.substr(0, 8) << " | ";
             if (activeChannels > 0)
             {
-                std::cout << activeChannels << " (" << changingChannels << " changing)";
+                out << activeChannels << " (" << changingChannels << " changing)";
             }
             else
             {
-                std::cout << "None";
+                out << "None";
             }
-            std::cout << std::endl;
-            ConsoleColors::resetColor();
+            out << std::endl;
+            m_screen.resetColor();
         }
     }
 
     void displayDetailView()
     {
+        std::ostream &out = m_screen.stream();
         // Find first active device if current selection is invalid
-        if (m_detailViewDevice >= m_deviceStates.size() ||
-            !m_deviceStates[m_detailViewDevice].connected ||
-            !m_deviceStates[m_detailViewDevice].active)
+        auto isShown = [this](int i)
+        {
+            const DeviceSnapshot snapshot = getSnapshot(i);
+            return snapshot.connected && snapshot.active;
+        };
+        if (static_cast<size_t>(m_detailViewDevice) >= m_deviceStates.size() || !isShown(m_detailViewDevice))
         {
             bool foundActive = false;
             for (int i = 0; i < m_numDevices; i++)
             {
-                if (i < m_deviceStates.size() && m_deviceStates[i].connected && m_deviceStates[i].active)
+                if (static_cast<size_t>(i) < m_deviceStates.size() && isShown(i))
                 {
                     m_detailViewDevice = i;
                     foundActive = true;
@@ -2154,41 +2902,79 @@ public:
 
             if (!foundActive)
             {
-                std::cout << "No active devices found.\n";
+                out << "No active devices found.\n";
                 return;
             }
         }
 
-        const DeviceState &state = m_deviceStates[m_detailViewDevice];
+        const DeviceSnapshot state = getSnapshot(m_detailViewDevice);
+        const DeviceState &info = m_deviceStates[m_detailViewDevice];
         auto now = std::chrono::system_clock::now();
 
         // Display device info
-        std::cout << "=== Device " << m_detailViewDevice << " Details ===\n";
-        std::cout << "Serial: " << state.serialNumber << " | Model: " << state.model;
-        std::cout << " | Firmware: " << state.firmwareVersion << "\n";
-        std::cout << "Captures: " << state.capturesCount << " | Errors: " << state.errorsCount;
+        out << "=== Device " << m_detailViewDevice << " Details ===\n";
+        out << "Serial: " << info.serialNumber << " | Model: " << info.model;
+        out << " | Firmware: " << info.firmwareVersion
+                  << " | Backend: " << m_devices[m_detailViewDevice].getBackendName() << "\n";
+        out << "Captures: " << state.capturesCount << " | Errors: " << state.errorsCount;
         if (state.consecutiveErrors > 0)
         {
-            std::cout << " | Consecutive Errors: " << state.consecutiveErrors;
+            out << " | Consecutive Errors: " << state.consecutiveErrors;
         }
-        std::cout << "\n";
+        out << "\n";
+        if (static_cast<size_t>(m_detailViewDevice) < m_configs.size() && m_configs[m_detailViewDevice].pipelineMode)
+        {
+            const BoundedFrameQueue &queue = *m_frameQueues[m_detailViewDevice];
+            out << "Pipeline: Queue " << queue.depth() << "/" << queue.capacity()
+                      << " (max " << queue.maxDepth() << ") | Dropped Frames: " << queue.droppedFrames() << "\n";
+        }
+        std::shared_ptr<CaptureBufferPool> pool = m_devices[m_detailViewDevice].getBufferPool();
+        if (pool)
+        {
+            const BufferPoolStats stats = pool->stats();
+            out << "Buffers: " << stats.inUse << "/" << stats.bufferCount << " in use (peak " << stats.peakInUse
+                      << ") | " << (stats.bufferBytes >> 20) << " MB each";
+            if (stats.largePageBuffers > 0)
+            {
+                out << ", large pages";
+            }
+            else if (stats.lockedBuffers > 0)
+            {
+                out << ", locked";
+            }
+            out << " | Waits: " << stats.waits << " | Skipped: " << stats.exhausted << "\n";
+        }
+        const CaptureCompletionWaiter::Stats waitStats = m_devices[m_detailViewDevice].getCaptureWaitStats();
+        if (waitStats.captures > 0)
+        {
+            out << std::fixed << std::setprecision(2)
+                      << "Capture Time: predicted " << waitStats.predictedUs / 1000.0 << " ms (nominal "
+                      << waitStats.nominalUs / 1000.0 << " ms) | p50 <= " << waitStats.percentileUs(0.5) / 1000.0
+                      << " ms, p99 <= " << waitStats.percentileUs(0.99) / 1000.0 << " ms | Polls/capture: "
+                      << static_cast<double>(waitStats.polls) / waitStats.captures << "\n";
+        }
+        const ExportScheduler::Stats exportStats = m_exporter.stats();
+        out << std::fixed << std::setprecision(1) << "Export: every " << m_exporter.periodMs()
+                  << " ms | Writes: " << exportStats.flushes << " for " << exportStats.notifications
+                  << " frames | Last write " << exportStats.lastFlushUs / 1000.0 << " ms (max "
+                  << exportStats.maxFlushUs / 1000.0 << " ms)\n";
 
-        if (m_detailViewDevice < m_configs.size())
+        if (static_cast<size_t>(m_detailViewDevice) < m_configs.size())
         {
             const AnalyzerConfig &config = m_configs[m_detailViewDevice];
-            std::cout << "Config: Rate=" << config.sampleRateCode << ", Depth=" << config.sampleDepth
+            out << "Config: Rate=" << config.sampleRateCode << ", Depth=" << config.sampleDepth
                       << ", Interval=" << config.scanIntervalMs << "ms";
             if (config.enableTrigger)
             {
-                std::cout << ", Trigger=CH" << config.triggerChannel << "(" << (config.triggerRisingEdge ? "↑" : "↓") << ")";
+                out << ", Trigger=CH" << config.triggerChannel << "(" << (config.triggerRisingEdge ? "↑" : "↓") << ")";
             }
         }
-        std::cout << "\n\n";
+        out << "\n\n";
 
         // Display active channels
-        std::cout << "Channel | State | Current | Total     | Last Change\n";
-        std::cout << "        |       | Changes | Changes   | Ago (ms)\n";
-        std::cout << "--------+-------+---------+-----------+------------\n";
+        out << "Channel | State | Current | Total     | Last Change\n";
+        out << "        |       | Changes | Changes   | Ago (ms)\n";
+        out << "--------+-------+---------+-----------+------------\n";
 
         bool anyActive = false;
 
@@ -2196,45 +2982,54 @@ public:
         for (int ch = 0; ch < 32; ch++)
         {
             // Skip inactive channels
-            if (state.channelData[ch].totalTransitions == 0 && !state.channelData[ch].changed)
+            if (state.channels[ch].totalTransitions == 0 && !state.channels[ch].changed)
                 continue;
 
             anyActive = true;
-            bool isCurrentlyChanged = state.changedChannels.find(ch) != state.changedChannels.end();
+            bool isCurrentlyChanged = state.isChanging(ch, now);
 
             if (isCurrentlyChanged)
             {
                 // Calculate time since last change
                 auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
-                                   now - state.channelData[ch].lastChangeTime)
+                                   now - state.channels[ch].lastChangeTime)
                                    .count();
 
                 // Set color based on recency
                 if (elapsed < 500)
                 {
-                    ConsoleColors::setColor(ConsoleColors::YELLOW, ConsoleColors::RED);
+                    m_screen.setColor(ConsoleColors::YELLOW, ConsoleColors::RED);
                 }
                 else
                 {
-                    ConsoleColors::setColor(ConsoleColors::YELLOW);
+                    m_screen.setColor(ConsoleColors::YELLOW);
                 }
 
                 // Display channel info
-                std::cout << std::left << std::setw(6) << m_channelNames[ch] << " | ";
-                std::cout << (state.channelData[ch].currentState ? "HIGH " : "LOW  ") << " | ";
-                std::cout << std::right << std::setw(7) << state.channelData[ch].transitions << " | ";
-                std::cout << std::setw(9) << state.channelData[ch].totalTransitions << " | ";
-                std::cout << std::setw(8) << elapsed << " ms *\n";
+                out << std::left << std::setw(6) << channelName(ch) << " | ";
+                out << (state.channels[ch].currentState ? "HIGH " : "LOW  ") << " | ";
+                out << std::right << std::setw(7) << state.channels[ch].transitions << " | ";
+                out << std::setw(9) << state.channels[ch].totalTransitions << " | ";
+                out << std::setw(8) << elapsed << " ms *\n";
 
 
                 // --- Display phase info for first 12 channels ---
                 if (ch < 12) {
-                    const ChannelData& chData = state.channelData[ch];
-                    std::cout << "    Phase: " << std::fixed << std::setprecision(2)
+                    const ChannelSnapshot& chData = state.channels[ch];
+                    out << "    Phase: " << std::fixed << std::setprecision(2)
                               << chData.meanPhase << " rad ("
                               << chData.phaseVariance * 100 << "% var)\n";
                 }
-                ConsoleColors::resetColor();
+                if (state.channels[ch].dutyCycle >= 0.0)
+                {
+                    out << "    Duty: " << std::fixed << std::setprecision(1) << state.channels[ch].dutyCycle << "%";
+                    if (state.channels[ch].meanHighPulseUs >= 0.0)
+                    {
+                        out << " | High pulse: " << std::setprecision(2) << state.channels[ch].meanHighPulseUs << " us";
+                    }
+                    out << "\n";
+                }
+                m_screen.resetColor();
             }
         }
 
@@ -2242,10 +3037,10 @@ public:
         for (int ch = 0; ch < 32; ch++)
         {
             // Skip inactive channels
-            if (state.channelData[ch].totalTransitions == 0)
+            if (state.channels[ch].totalTransitions == 0)
                 continue;
 
-            bool isCurrentlyChanged = state.changedChannels.find(ch) != state.changedChannels.end();
+            bool isCurrentlyChanged = state.isChanging(ch, now);
 
             // Skip already displayed channels
             if (isCurrentlyChanged)
@@ -2254,137 +3049,321 @@ public:
             anyActive = true;
 
             // Display in regular color
-            std::cout << std::left << std::setw(6) << m_channelNames[ch] << " | ";
-            std::cout << (state.channelData[ch].currentState ? "HIGH " : "LOW  ") << " | ";
-            std::cout << std::right << std::setw(7) << state.channelData[ch].transitions << " | ";
-            std::cout << std::setw(9) << state.channelData[ch].totalTransitions << " | ";
-            std::cout << std::setw(8) << "-" << std::endl;
+            out << std::left << std::setw(6) << channelName(ch) << " | ";
+            out << (state.channels[ch].currentState ? "HIGH " : "LOW  ") << " | ";
+            out << std::right << std::setw(7) << state.channels[ch].transitions << " | ";
+            out << std::setw(9) << state.channels[ch].totalTransitions << " | ";
+            out << std::setw(8) << "-" << std::endl;
             // --- Display phase info for first 12 channels ---
             if (ch < 12) {
-                const ChannelData& chData = state.channelData[ch];
-                std::cout << "    Phase: " << std::fixed << std::setprecision(2)
+                const ChannelSnapshot& chData = state.channels[ch];
+                out << "    Phase: " << std::fixed << std::setprecision(2)
                           << chData.meanPhase << " rad ("
                           << chData.phaseVariance * 100 << "% var)\n";
             }
         }
         if (!anyActive)
         {
-            std::cout << "No channel activity detected on device " << m_detailViewDevice << ".\n";
+            out << "No channel activity detected on device " << m_detailViewDevice << ".\n";
         }
         else
         {
-            std::cout << "\n* Channels marked with an asterisk have changed recently\n";
-            std::cout << "  " << state.changedChannels.size() << " channel(s) changing now\n";
+            out << "\n* Channels marked with an asterisk have changed recently\n";
+            out << "  " << state.changingCount(now) << " channel(s) changing now\n";
+        }
+    }
+
+    // Where each frame's time goes, since start or the last reset
+    void displayStatsView()
+    {
+        std::ostream &out = m_screen.stream();
+        writePipelineStats(out);
+        const ExportScheduler::Stats exportStats = m_exporter.stats();
+        out << "\nExporter: " << exportStats.flushes << " writes for " << exportStats.notifications << " frames";
+        if (m_options.statsIntervalMs > 0)
+        {
+            out << " | Stats file: " << STATS_FILENAME << " every " << m_options.statsIntervalMs << " ms";
         }
+        out << "\nConsole: " << m_screen.lastBytes() << " bytes last refresh, every " << m_options.displayIntervalMs << " ms\n";
     }
 
     void displayActivityView()
     {
+        std::ostream &out = m_screen.stream();
         // Implementation of activity view
-        std::cout << "Activity view shows only active channels across all devices.\n\n";
+        out << "Activity view shows only active channels across all devices.\n\n";
 
-        std::cout << "Device | Channel | State | Total Changes | Last Change\n";
-        std::cout << "-------+---------+-------+--------------+------------\n";
+        out << "Device | Channel | State | Total Changes | Last Change\n";
+        out << "-------+---------+-------+--------------+------------\n";
 
         bool anyActive = false;
 
         // First show channels that are currently changing
-        for (int i = 0; i < m_numDevices && i < m_deviceStates.size(); i++)
+        for (int i = 0; i < m_numDevices && static_cast<size_t>(i) < m_deviceStates.size(); i++)
         {
-            if (!m_deviceStates[i].connected || !m_deviceStates[i].active)
+            const DeviceSnapshot state = getSnapshot(i);
+            if (!state.connected || !state.active)
                 continue;
 
-            const DeviceState &state = m_deviceStates[i];
             auto now = std::chrono::system_clock::now();
 
-            for (const auto &entry : state.changedChannels)
+            for (int ch = 0; ch < 32; ch++)
             {
-                int ch = entry.first;
-                if (ch >= 0 && ch < state.channelData.size())
+                if (state.isChanging(ch, now))
                 {
                     anyActive = true;
 
                     // Calculate time since last change
                     auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
-                                       now - state.channelData[ch].lastChangeTime)
+                                       now - state.channels[ch].lastChangeTime)
                                        .count();
 
                     // Set color based on recency
                     if (elapsed < 500)
                     {
-                        ConsoleColors::setColor(ConsoleColors::YELLOW, ConsoleColors::RED);
+                        m_screen.setColor(ConsoleColors::YELLOW, ConsoleColors::RED);
                     }
                     else
                     {
-                        ConsoleColors::setColor(ConsoleColors::YELLOW);
+                        m_screen.setColor(ConsoleColors::YELLOW);
                     }
 
                     // Display channel info
-                    std::cout << std::setw(6) << i << " | ";
-                    std::cout << std::left << std::setw(7) << m_channelNames[ch] << " | ";
-                    std::cout << (state.channelData[ch].currentState ? "HIGH " : "LOW  ") << " | ";
-                    std::cout << std::right << std::setw(12) << state.channelData[ch].totalTransitions << " | ";
-                    std::cout << std::setw(8) << elapsed << " ms *\n";
+                    out << std::setw(6) << i << " | ";
+                    out << std::left << std::setw(7) << channelName(ch) << " | ";
+                    out << (state.channels[ch].currentState ? "HIGH " : "LOW  ") << " | ";
+                    out << std::right << std::setw(12) << state.channels[ch].totalTransitions << " | ";
+                    out << std::setw(8) << elapsed << " ms *\n";
 
-                    ConsoleColors::resetColor();
+                    m_screen.resetColor();
                 }
             }
         }
 
         if (!anyActive)
         {
-            std::cout << "No channel activity detected on any device.\n";
+            out << "No channel activity detected on any device.\n";
         }
     }
 
     // Add a function to export phase data to TXT in logic_data.txt style
     void exportPhaseDataTXT() {
-        std::string outputPath = OUTPUT_DIRECTORY + "\\phase_data.txt";
+        std::string outputPath = outputFilePath("phase_data.txt");
         std::ofstream outputFile(outputPath);
         if (!outputFile.is_open()) {
             std::cerr << "Failed to open phase data TXT: " << outputPath << std::endl;
             return;
         }
 
-        // Get current timestamp
-        auto now = std::chrono::system_clock::now();
-        std::time_t now_c = std::chrono::system_clock::to_time_t(now);
-        struct tm *timeinfo = std::localtime(&now_c);
-        char timestamp[100];
-        std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", timeinfo);
-
-        // Write header
-        outputFile << "# Phase Data - Updated: " << timestamp << "\n";
-        outputFile << "# Format: [device_id],[serial],[model],[channel_id],[meanPhase],[phaseVariance]\n\n";
-
-        // Write data for all devices
-        for (int deviceIndex = 0; deviceIndex < m_deviceStates.size(); deviceIndex++) {
-            const DeviceState &state = m_deviceStates[deviceIndex];
-            if (!state.connected) {
-                continue;
-            }
-
-            // Write device header
-            outputFile << "DEVICE," << deviceIndex << "," << state.serialNumber << ", "
-                       << state.model << "," << state.capturesCount << "\n";
-
-            // Write phase data for first 12 channels
-            for (int ch = 0; ch < 12; ch++) {
-                const ChannelData& chData = state.channelData[ch];
-                outputFile << "PHASE," << ch << "," << m_channelNames[ch] << ", "
-                           << chData.meanPhase << "," << chData.phaseVariance << "\n";
-            }
-            // Add a blank line between devices
-            outputFile << "\n";
-        }
-
+        output_writers::writePhaseData(outputFile, collectExportedDevices(), collectChannelNames(),
+                                       std::chrono::system_clock::now());
         outputFile.close();
     }
 };
+// Parse one --key=value option; returns false for unknown keys or bad values
+bool parseRuntimeOption(const std::string &arg, RuntimeOptions &options)
+{
+    size_t equalsPos = arg.find('=');
+    if (equalsPos == std::string::npos)
+        return false;
+
+    std::string key = arg.substr(2, equalsPos - 2);
+    std::string value = arg.substr(equalsPos + 1);
+    try
+    {
+        if (key == "connect")
+        {
+            if (value == "sequential")
+                options.connectMode = ConnectMode::SEQUENTIAL;
+            else if (value == "parallel")
+                options.connectMode = ConnectMode::PARALLEL;
+            else
+                return false;
+        }
+        else if (key == "backend")
+        {
+            if (value == "hantek")
+                options.backend = BackendKind::HANTEK;
+            else if (value == "synthetic")
+                options.backend = BackendKind::SYNTHETIC;
+            else if (value == "replay")
+                options.backend = BackendKind::REPLAY;
+            else
+                return false;
+        }
+        else if (key == "synthetic-spec")
+        {
+            options.syntheticSpec = value;
+        }
+        else if (key == "record")
+        {
+            options.recordDirectory = value;
+        }
+        else if (key == "archive")
+        {
+            options.archiveDirectory = value;
+        }
+        else if (key == "replay")
+        {
+            // Implies the replay backend
+            options.replayDirectory = value;
+            options.backend = BackendKind::REPLAY;
+        }
+        else if (key == "replay-pacing")
+        {
+            if (value == "fast")
+                options.replayPacing = ReplayPacing::FAST;
+            else if (value == "original")
+                options.replayPacing = ReplayPacing::ORIGINAL;
+            else
+                return false;
+        }
+        else if (key == "export-interval-ms")
+        {
+            int interval = std::stoi(value);
+            if (interval < 10 || interval > 10000)
+                return false;
+            options.exportIntervalMs = interval;
+        }
+        else if (key == "scheduler-threads")
+        {
+            int threads = std::stoi(value);
+            if (threads < 0 || threads > 256)
+                return false;
+            options.schedulerThreads = threads;
+        }
+        else if (key == "pin-threads")
+        {
+            if (value == "1")
+                options.pinThreads = true;
+            else if (value == "0")
+                options.pinThreads = false;
+            else
+                return false;
+        }
+        else if (key == "trace")
+        {
+            if (value == "1")
+                options.trace = true;
+            else if (value == "0")
+                options.trace = false;
+            else
+                return false;
+        }
+        else if (key == "headless")
+        {
+            if (value == "1")
+                options.headless = true;
+            else if (value == "0")
+                options.headless = false;
+            else
+                return false;
+        }
+        else if (key == "display-interval")
+        {
+            int interval = std::stoi(value);
+            if (interval < 20 || interval > 60000)
+                return false;
+            options.displayIntervalMs = interval;
+        }
+        else if (key == "output-dir")
+        {
+            if (value.empty())
+                return false;
+            options.outputDirectory = value;
+        }
+        else if (key == "text-exports")
+        {
+            if (value == "1")
+                options.textExports = true;
+            else if (value == "0")
+                options.textExports = false;
+            else
+                return false;
+        }
+        else if (key == "results-ring")
+        {
+            // --results-ring=brainviz_results publishes under that name
+            options.resultsRing = value;
+        }
+        else if (key == "results-ring-capacity")
+        {
+            int capacity = std::stoi(value);
+            if (capacity < 64 || capacity > 65536 || (capacity & (capacity - 1)) != 0)
+                return false;
+            options.resultsRingCapacity = capacity;
+        }
+        else if (key == "push-port")
+        {
+            int port = std::stoi(value);
+            if (port != 0 && (port < 1024 || port > 65535))
+                return false;
+            options.pushPort = port;
+        }
+        else if (key == "push-origin")
+        {
+            // --push-origin=http://127.0.0.1:3000 lets only that dashboard in
+            options.pushOrigin = value;
+        }
+        else if (key == "stats-interval")
+        {
+            // Milliseconds between pipeline_stats.json rewrites, 0 = off
+            int interval = std::stoi(value);
+            if (interval < 0 || interval > 3600000)
+                return false;
+            options.statsIntervalMs = interval;
+        }
+        else if (key == "replay-loops")
+        {
+            int loops = std::stoi(value);
+            if (loops < 1)
+                return false;
+            options.replayLoops = loops;
+        }
+        else if (key == "connect-concurrency")
+        {
+            int concurrency = std::stoi(value);
+            if (concurrency < 1 || concurrency > SyntheticBackend::MAX_DEVICES)
+                return false;
+            options.connectConcurrency = concurrency;
+        }
+        else if (key == "connect-deadline-ms")
+        {
+            // --connect-deadline-ms=5000 fails a device whose connect, init and
+            // configuration have not finished by then; it is checked between
+            // those steps and does not interrupt a DLL call in progress
+            int deadline = std::stoi(value);
+            if (deadline < 100 || deadline > 60000)
+                return false;
+            options.connectDeadlineMs = deadline;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    catch (...)
+    {
+        return false;
+    }
+    return true;
+}
+
 // Main function
+// Keep the console window open until a key is pressed; a service just exits
+void waitForKey(bool headless)
+{
+    if (!headless)
+    {
+        std::cout << "Press any key to exit..." << std::endl;
+        platform::readKey();
+    }
+}
+
 int main(int argc, char *argv[])
 {
     int exitCode = 0;
+    bool headless = false;
     try
     {
         // Default number of devices to scan (can be overridden by command line)
@@ -2393,15 +3372,38 @@ int main(int argc, char *argv[])
         // Path to Hantek DLL file (standard path for Hantek software)
         std::string dllPath = "C:\\Program Files (x86)\\Hantek4032L\\HTLAHard.dll";
 
+        // Split --key=value options from the positional device count and DLL path
+        RuntimeOptions options;
+        std::vector<std::string> positional;
+        for (int i = 1; i < argc; i++)
+        {
+            std::string arg = argv[i];
+            if (arg.compare(0, 2, "--") == 0)
+            {
+                if (!parseRuntimeOption(arg, options))
+                {
+                    std::cout << "Ignoring invalid option: " << arg << "\n";
+                }
+            }
+            else
+            {
+                positional.push_back(arg);
+            }
+        }
+        headless = options.headless;
+
+        // Virtual devices are not limited by the USB hub layout
+        const int maxDevices = options.backend != BackendKind::HANTEK ? static_cast<int>(SyntheticBackend::MAX_DEVICES) : MAX_DEVICES;
+
         // Check command line arguments for device count
-        if (argc > 1)
+        if (positional.size() > 0)
         {
             try
             {
-                numDevices = std::stoi(argv[1]);
-                if (numDevices < 1 || numDevices > MAX_DEVICES)
+                numDevices = std::stoi(positional[0]);
+                if (numDevices < 1 || numDevices > maxDevices)
                 {
-                    std::cout << "Invalid device count (must be 1-" << MAX_DEVICES << "). Using default: " << MAX_DEVICES << "\n";
+                    std::cout << "Invalid device count (must be 1-" << maxDevices << "). Using default: " << MAX_DEVICES << "\n";
                     numDevices = MAX_DEVICES;
                 }
             }
@@ -2412,15 +3414,16 @@ int main(int argc, char *argv[])
         }
 
         // Check command line arguments for DLL path
-        if (argc > 2)
+        if (positional.size() > 1)
         {
-            dllPath = argv[2];
+            dllPath = positional[1];
         }
 
         std::cout << "Initializing with " << numDevices << " devices and DLL: " << dllPath << std::endl;
 
         // Create the analyzer with specified number of devices
         MultiLogicAnalyzer analyzer(numDevices);
+        analyzer.setRuntimeOptions(options);
 
         // Initialize and run if successful
         if (analyzer.initialize(dllPath))
@@ -2430,23 +3433,20 @@ int main(int argc, char *argv[])
         else
         {
             std::cerr << "Failed to initialize MultiLogicAnalyzer. Exiting.\n";
-            std::cout << "Press any key to exit..." << std::endl;
-            _getch();
+            waitForKey(headless);
             exitCode = 1;
         }
     }
     catch (const std::exception &e)
     {
         std::cerr << "Exception in main: " << e.what() << std::endl;
-        std::cout << "Press any key to exit..." << std::endl;
-        _getch();
+        waitForKey(headless);
         exitCode = 1;
     }
     catch (...)
     {
         std::cerr << "Unknown exception in main" << std::endl;
-        std::cout << "Press any key to exit..." << std::endl;
-        _getch();
+        waitForKey(headless);
         exitCode = 1;
     }
 
@@ -2458,7 +3458,7 @@ int main(int argc, char *argv[])
     // Wait for a moment to ensure OS releases file handles
     std::this_thread::sleep_for(std::chrono::milliseconds(100));
 
-    std::cout << "Program finished. Press any key to exit..." << std::endl;
-    _getch();
+    std::cout << "Program finished." << std::endl;
+    waitForKey(headless);
     return exitCode;
 }
\ No newline at end of file
@@ -0,0 +1,216 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <ostream>
+#include <iomanip>
+#include <algorithm>
+#include "device_snapshot.h"
+#include "live_state.h"
+
+// The visualizer's outputs, written from snapshots of the connected devices.
+// The exporter opens the files and takes the file lock; these only format,
+// so bench_kernels times exactly the code the monitor runs.
+
+// One connected device as the writers see it. Serial and model point into
+// the device's state, where they are set once at bring-up.
+struct ExportedDevice
+{
+    int deviceIndex = 0;
+    const std::string *serialNumber = nullptr;
+    const std::string *model = nullptr;
+    DeviceSnapshot state;
+};
+
+namespace output_writers
+{
+// Activity level of a channel (0-100), from how recently it changed
+inline int activityLevel(const DeviceSnapshot &state, int ch, std::chrono::system_clock::time_point now)
+{
+    if (!state.isChanging(ch, now))
+    {
+        return 0;
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                       now - state.channels[ch].lastChangeTime)
+                       .count();
+
+    // More recent changes get higher activity levels
+    if (elapsed < 500)
+    {
+        return 100;
+    }
+    else if (elapsed < 1000)
+    {
+        return 75;
+    }
+    else if (elapsed < 2000)
+    {
+        return 50;
+    }
+    return 25;
+}
+
+inline int64_t toEpochMs(std::chrono::system_clock::time_point time)
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count();
+}
+
+inline std::string timestamp(std::chrono::system_clock::time_point now)
+{
+    std::time_t now_c = std::chrono::system_clock::to_time_t(now);
+    struct tm *timeinfo = std::localtime(&now_c);
+    char text[100];
+    std::strftime(text, sizeof(text), "%Y-%m-%d %H:%M:%S", timeinfo);
+    return text;
+}
+
+// Name of a channel for the text outputs; channelNames may be shorter than 32
+inline const std::string &channelName(const std::vector<std::string> &channelNames, int ch)
+{
+    static const std::string unnamed;
+    return ch < static_cast<int>(channelNames.size()) ? channelNames[ch] : unnamed;
+}
+
+// logic_data.txt: state and transitions of every channel that has toggled
+inline void writeLogicData(std::ostream &outputFile, const std::vector<ExportedDevice> &devices,
+                           const std::vector<std::string> &channelNames, std::chrono::system_clock::time_point now)
+{
+    // Write header
+    outputFile << "# Neural Monitor Data - Updated: " << timestamp(now) << "\n";
+    outputFile << "# Format: [device_id],[serial],[model],[channel_id],[state],[transitions],[active]\n\n";
+
+    // Write data for all devices
+    for (const ExportedDevice &device : devices)
+    {
+        const DeviceSnapshot &state = device.state;
+
+        // Write device header
+        outputFile << "DEVICE," << device.deviceIndex << "," << *device.serialNumber << ","
+                   << *device.model << "," << state.capturesCount << "\n";
+
+        // Write channel data
+        for (int ch = 0; ch < 32; ch++)
+        {
+            // Only include channels that have shown some activity
+            if (state.channels[ch].totalTransitions > 0)
+            {
+                // Format: channel_id, name, current_state, transitions, total_transitions, activity_level
+                outputFile << "CHANNEL," << ch << "," << channelName(channelNames, ch) << ","
+                           << state.channels[ch].currentState << ","
+                           << state.channels[ch].transitions << ","
+                           << state.channels[ch].totalTransitions << ","
+                           << activityLevel(state, ch, now) << "\n";
+            }
+        }
+
+        outputFile << "\n";
+    }
+}
+
+// phase_data.txt: mean phase and variance of the phase channels
+inline void writePhaseData(std::ostream &outputFile, const std::vector<ExportedDevice> &devices,
+                           const std::vector<std::string> &channelNames, std::chrono::system_clock::time_point now)
+{
+    // Write header
+    outputFile << "# Phase Data - Updated: " << timestamp(now) << "\n";
+    outputFile << "# Format: [device_id],[serial],[model],[channel_id],[meanPhase],[phaseVariance]\n\n";
+
+    // Write data for all devices
+    for (const ExportedDevice &device : devices)
+    {
+        // Write device header
+        outputFile << "DEVICE," << device.deviceIndex << "," << *device.serialNumber << ", "
+                   << *device.model << "," << device.state.capturesCount << "\n";
+
+        // Write phase data for the phase channels
+        for (int ch = 0; ch < PHASE_CHANNELS; ch++)
+        {
+            const ChannelSnapshot &chData = device.state.channels[ch];
+            outputFile << "PHASE," << ch << "," << channelName(channelNames, ch) << ", "
+                       << chData.meanPhase << "," << chData.phaseVariance << "\n";
+        }
+        // Add a blank line between devices
+        outputFile << "\n";
+    }
+}
+
+// time_sliced_data.txt: activity of each time slice of the phase channels
+inline void writeTimeSlicedData(std::ostream &outFile, const std::vector<ExportedDevice> &devices)
+{
+    // Header
+    outFile << "# Time-sliced neural activity data\n";
+    outFile << "# Format:device_id,channel_id,slice0_activity,slice1_activity,slice2_activity,slice3_activity,slice4_activity\n";
+
+    for (const ExportedDevice &device : devices)
+    {
+        const DeviceSnapshot &state = device.state;
+        for (int ch = 0; ch < PHASE_CHANNELS; ch++)
+        {
+            const ChannelSnapshot &chData = state.channels[ch];
+            outFile << device.deviceIndex << "," << ch;
+
+            // Slice activity levels
+            for (int i = 0; i < state.sliceCount; i++)
+            {
+                outFile << "," << std::fixed << std::setprecision(1) << chData.sliceActivityLevels[i];
+            }
+            outFile << "\n";
+        }
+    }
+}
+
+// Fill the live-state image for every device; the caller commits it
+inline void fillLiveState(LiveStateWriter &writer, const std::vector<ExportedDevice> &devices,
+                          std::chrono::system_clock::time_point now)
+{
+    const uint32_t deviceCount = static_cast<uint32_t>(devices.size());
+    writer.begin(deviceCount);
+    for (uint32_t entry = 0; entry < deviceCount; entry++)
+    {
+        const ExportedDevice &source = devices[entry];
+        const DeviceSnapshot &state = source.state;
+
+        LiveStateDevice &device = writer.device(entry);
+        device.deviceIndex = static_cast<uint32_t>(source.deviceIndex);
+        device.flags = LIVE_DEVICE_CONNECTED | (state.active ? LIVE_DEVICE_ACTIVE : 0);
+        device.capturesCount = static_cast<uint32_t>(state.capturesCount);
+        device.errorsCount = static_cast<uint32_t>(state.errorsCount);
+        device.consecutiveErrors = static_cast<uint32_t>(state.consecutiveErrors);
+        device.changedMask = state.changedMask;
+        device.sliceCount = static_cast<uint32_t>(std::min(state.sliceCount, SNAPSHOT_MAX_SLICES));
+        device.frameSequence = state.frameSequence;
+        device.lastCaptureMs = toEpochMs(state.lastCaptureTime);
+        std::strncpy(device.serialNumber, source.serialNumber->c_str(), sizeof(device.serialNumber) - 1);
+        std::strncpy(device.model, source.model->c_str(), sizeof(device.model) - 1);
+
+        for (int ch = 0; ch < 32; ch++)
+        {
+            const ChannelSnapshot &chData = state.channels[ch];
+            LiveStateChannel &channel = writer.channel(entry, ch);
+            channel.currentState = chData.currentState;
+            channel.activityLevel = static_cast<uint32_t>(activityLevel(state, ch, now));
+            channel.transitions = chData.transitions;
+            channel.totalTransitions = chData.totalTransitions;
+            channel.lastChangeMs = toEpochMs(chData.lastChangeTime);
+        }
+
+        for (int ch = 0; ch < PHASE_CHANNELS; ch++)
+        {
+            const ChannelSnapshot &chData = state.channels[ch];
+            float *slices = writer.slices(entry, ch);
+            for (uint32_t i = 0; i < device.sliceCount; i++)
+            {
+                slices[i] = static_cast<float>(chData.sliceActivityLevels[i]);
+            }
+            LiveStatePhase &phase = writer.phase(entry, ch);
+            phase.meanPhase = chData.meanPhase;
+            phase.phaseVariance = chData.phaseVariance;
+        }
+    }
+}
+}
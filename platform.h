@@ -0,0 +1,208 @@
+#pragma once
+#include <string>
+#include <atomic>
+#include <csignal>
+#include <cerrno>
+#ifdef _WIN32
+#include <winsock2.h> // Before windows.h, which would pull in the old winsock.h
+#include <windows.h>
+#undef max
+#undef min
+#include <conio.h>
+#include <direct.h>
+#else
+#include <dlfcn.h>
+#include <sys/stat.h>
+#include <sys/select.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+// The OS services the analyzer uses beyond the standard library: console
+// keys and ANSI output, directories, loading the vendor library and stop
+// requests from a service manager. Everything else in the core is portable,
+// so this is all a Linux build has to provide.
+//
+// On Windows this header must come before any other that includes
+// windows.h, so that winsock2.h is seen first.
+namespace platform
+{
+#ifdef _WIN32
+const char PATH_SEPARATOR = '\\';
+typedef HMODULE LibraryHandle;
+#else
+const char PATH_SEPARATOR = '/';
+typedef void *LibraryHandle;
+#endif
+
+inline std::string joinPath(const std::string &directory, const std::string &name)
+{
+    return directory + PATH_SEPARATOR + name;
+}
+
+// Create one directory; an existing one counts as success
+inline bool makeDirectory(const std::string &path)
+{
+#ifdef _WIN32
+    return _mkdir(path.c_str()) == 0 || errno == EEXIST;
+#else
+    return mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+#endif
+}
+
+// Load a shared library; on failure returns nullptr and the reason in error
+inline LibraryHandle loadLibrary(const std::string &path, std::string &error)
+{
+#ifdef _WIN32
+    LibraryHandle library = LoadLibraryA(path.c_str());
+    if (!library)
+        error = "Error code: " + std::to_string(GetLastError());
+#else
+    LibraryHandle library = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!library)
+        error = dlerror();
+#endif
+    return library;
+}
+
+inline void *findSymbol(LibraryHandle library, const char *name)
+{
+#ifdef _WIN32
+    return reinterpret_cast<void *>(GetProcAddress(library, name));
+#else
+    return dlsym(library, name);
+#endif
+}
+
+inline void freeLibrary(LibraryHandle library)
+{
+#ifdef _WIN32
+    FreeLibrary(library);
+#else
+    dlclose(library);
+#endif
+}
+
+#ifndef _WIN32
+// Unbuffered, no-echo input while the process runs, so single key presses
+// reach the run loop as they do through conio on Windows. Only applied when
+// stdin is a terminal; restored at exit.
+class TerminalMode
+{
+public:
+    static void ensure()
+    {
+        static TerminalMode mode;
+    }
+
+private:
+    TerminalMode() : m_active(false)
+    {
+        if (isatty(STDIN_FILENO) && tcgetattr(STDIN_FILENO, &m_saved) == 0)
+        {
+            termios raw = m_saved;
+            raw.c_lflag &= ~static_cast<tcflag_t>(ICANON | ECHO);
+            raw.c_cc[VMIN] = 1;
+            raw.c_cc[VTIME] = 0;
+            m_active = tcsetattr(STDIN_FILENO, TCSANOW, &raw) == 0;
+        }
+    }
+
+    ~TerminalMode()
+    {
+        if (m_active)
+            tcsetattr(STDIN_FILENO, TCSANOW, &m_saved);
+    }
+
+    termios m_saved;
+    bool m_active;
+};
+#endif
+
+// Whether a key is waiting, without blocking
+inline bool keyPressed()
+{
+#ifdef _WIN32
+    return _kbhit() != 0;
+#else
+    TerminalMode::ensure();
+    fd_set input;
+    FD_ZERO(&input);
+    FD_SET(STDIN_FILENO, &input);
+    timeval noWait = {0, 0};
+    return select(STDIN_FILENO + 1, &input, nullptr, nullptr, &noWait) > 0;
+#endif
+}
+
+// Next key, waiting for one; -1 once input has ended
+inline int readKey()
+{
+#ifdef _WIN32
+    return _getch();
+#else
+    TerminalMode::ensure();
+    unsigned char key = 0;
+    return read(STDIN_FILENO, &key, 1) == 1 ? key : -1;
+#endif
+}
+
+// Turn on ANSI escape handling for stdout; false when stdout is not a
+// terminal that understands them
+inline bool enableAnsiOutput()
+{
+#ifdef _WIN32
+    HANDLE output = GetStdHandle(STD_OUTPUT_HANDLE);
+    DWORD mode = 0;
+    if (!GetConsoleMode(output, &mode))
+        return false;
+    return SetConsoleMode(output, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING) != 0;
+#else
+    return isatty(STDOUT_FILENO) != 0;
+#endif
+}
+
+// Visible size of the console; false when unknown
+inline bool terminalSize(int &rows, int &columns)
+{
+#ifdef _WIN32
+    CONSOLE_SCREEN_BUFFER_INFO info;
+    if (!GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &info))
+        return false;
+    rows = info.srWindow.Bottom - info.srWindow.Top + 1;
+    columns = info.srWindow.Right - info.srWindow.Left + 1;
+#else
+    winsize size;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) != 0 || size.ws_row == 0)
+        return false;
+    rows = size.ws_row;
+    columns = size.ws_col;
+#endif
+    return true;
+}
+
+inline std::atomic<bool> &stopFlag()
+{
+    static std::atomic<bool> requested(false);
+    return requested;
+}
+
+inline void onStopSignal(int)
+{
+    stopFlag().store(true);
+}
+
+// Turn Ctrl+C and SIGTERM (systemctl stop, docker stop) into a stop request
+// the run loop polls, so the analyzer shuts down through its normal path
+inline void installStopHandlers()
+{
+    stopFlag();
+    std::signal(SIGINT, onStopSignal);
+    std::signal(SIGTERM, onStopSignal);
+}
+
+inline bool stopRequested()
+{
+    return stopFlag().load();
+}
+} // namespace platform
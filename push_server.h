@@ -0,0 +1,989 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <cctype>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#include "waveform_pyramid.h"
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "ws2_32.lib")
+#endif
+typedef SOCKET PushSocket;
+const PushSocket PUSH_INVALID_SOCKET = INVALID_SOCKET;
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+typedef int PushSocket;
+const PushSocket PUSH_INVALID_SOCKET = -1;
+#endif
+
+// SHA-1 and base64, only for the WebSocket handshake
+class WebSocketHandshake
+{
+public:
+    // Sec-WebSocket-Accept value for a client's Sec-WebSocket-Key
+    static std::string acceptKey(const std::string &clientKey)
+    {
+        unsigned char digest[20];
+        sha1(clientKey + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11", digest);
+        return base64(digest, sizeof(digest));
+    }
+
+private:
+    static uint32_t rotl(uint32_t value, int bits)
+    {
+        return (value << bits) | (value >> (32 - bits));
+    }
+
+    static void sha1(const std::string &text, unsigned char digest[20])
+    {
+        uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+        std::vector<unsigned char> message(text.begin(), text.end());
+        const uint64_t bitLength = static_cast<uint64_t>(message.size()) * 8;
+        message.push_back(0x80);
+        while (message.size() % 64 != 56)
+            message.push_back(0);
+        for (int i = 7; i >= 0; i--)
+            message.push_back(static_cast<unsigned char>(bitLength >> (i * 8)));
+
+        for (size_t block = 0; block < message.size(); block += 64)
+        {
+            uint32_t w[80];
+            for (int i = 0; i < 16; i++)
+            {
+                const unsigned char *p = &message[block + i * 4];
+                w[i] = (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+            }
+            for (int i = 16; i < 80; i++)
+                w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+            uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+            for (int i = 0; i < 80; i++)
+            {
+                uint32_t f, k;
+                if (i < 20)
+                {
+                    f = (b & c) | (~b & d);
+                    k = 0x5A827999;
+                }
+                else if (i < 40)
+                {
+                    f = b ^ c ^ d;
+                    k = 0x6ED9EBA1;
+                }
+                else if (i < 60)
+                {
+                    f = (b & c) | (b & d) | (c & d);
+                    k = 0x8F1BBCDC;
+                }
+                else
+                {
+                    f = b ^ c ^ d;
+                    k = 0xCA62C1D6;
+                }
+                const uint32_t temp = rotl(a, 5) + f + e + k + w[i];
+                e = d;
+                d = c;
+                c = rotl(b, 30);
+                b = a;
+                a = temp;
+            }
+            h[0] += a;
+            h[1] += b;
+            h[2] += c;
+            h[3] += d;
+            h[4] += e;
+        }
+        for (int i = 0; i < 5; i++)
+        {
+            digest[i * 4] = static_cast<unsigned char>(h[i] >> 24);
+            digest[i * 4 + 1] = static_cast<unsigned char>(h[i] >> 16);
+            digest[i * 4 + 2] = static_cast<unsigned char>(h[i] >> 8);
+            digest[i * 4 + 3] = static_cast<unsigned char>(h[i]);
+        }
+    }
+
+    static std::string base64(const unsigned char *data, size_t size)
+    {
+        static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        std::string out;
+        for (size_t i = 0; i < size; i += 3)
+        {
+            const uint32_t chunk = (uint32_t(data[i]) << 16) | (i + 1 < size ? uint32_t(data[i + 1]) << 8 : 0) |
+                                   (i + 2 < size ? uint32_t(data[i + 2]) : 0);
+            out += alphabet[(chunk >> 18) & 63];
+            out += alphabet[(chunk >> 12) & 63];
+            out += i + 1 < size ? alphabet[(chunk >> 6) & 63] : '=';
+            out += i + 2 < size ? alphabet[chunk & 63] : '=';
+        }
+        return out;
+    }
+};
+
+// What the push server knows about one channel
+struct PushChannelValue
+{
+    uint32_t state;
+    int32_t transitions; // In the last frame
+    int32_t totalTransitions;
+};
+
+// Embedded localhost WebSocket/HTTP server that pushes per-frame deltas to
+// the visualizer, so it no longer has to poll the exported files.
+//
+//   GET /state   -> JSON with the latest state of every device
+//   GET /waveform?device=D&channel=C&start=S&end=E&buckets=N
+//                -> Samples [S, E) of one channel of the device's latest
+//                   frame as at most N (default 1024) WaveformPyramid buckets:
+//     {"device":D,"channel":C,"seq":S,"samples":total,"start":first,"bucketSamples":K,
+//      "flags":"3312...","toggles":[...]}
+//     flags has one digit per bucket, 1 = high, 2 = low, 3 = both (a toggle).
+//     start/end default to the whole frame.
+//   GET /stream  -> WebSocket. Server messages are JSON text:
+//     {"type":"state","device":D,"seq":S,"time":MS,"channels":[[ch,state,transitions,total],...]}
+//     {"type":"delta", same fields, only channels whose values changed since the previous frame}
+//   A client message {"devices":[0,3],"channels":[0,1,2]} replaces the
+//   client's subscription (a missing list means all); the server answers
+//   with a full state of every subscribed device.
+//
+// Each client has a bounded queue of pending deltas. A client that cannot
+// keep up (queue full) loses its queued deltas and gets the latest full
+// state of its devices instead, so a slow client costs bounded memory and
+// always converges to the current state.
+//
+// Publishers only hold m_mutex to update the device entries and queue
+// deltas. The server thread takes it just long enough to swap out a
+// client's queue or copy the entries it answers from; it encodes, parses
+// and sends with the lock released, so a slow client never holds up the
+// analysis threads that publish.
+class PushServer
+{
+public:
+    enum
+    {
+        MAX_DEVICES = 64,
+        CHANNELS = 32,
+        MAX_CLIENTS = 16,
+        CLIENT_QUEUE_LIMIT = 64,   // Deltas waiting per client before it falls back to latest state
+        MAX_CLIENT_MESSAGE = 4096, // Longest subscription message accepted
+        POLL_INTERVAL_MS = 5,      // Longest time a new delta waits before it is sent
+        CLIENT_SEND_BUFFER = 32768, // Kernel send buffer per client, kept small so backpressure shows up early
+        WAVEFORM_INTEREST_MS = 5000 // How long a /waveform request keeps pyramids being built for its device
+    };
+
+    struct Stats
+    {
+        uint64_t clients = 0;        // Currently connected WebSocket clients
+        uint64_t deltasSent = 0;
+        uint64_t resyncs = 0;        // Times a slow client was dropped to latest state
+        uint64_t framesPublished = 0;
+        uint64_t waveformRequests = 0;
+    };
+
+    PushServer() : m_listener(PUSH_INVALID_SOCKET), m_running(false), m_port(0)
+    {
+        for (DeviceEntry &device : m_devices)
+        {
+            device.known = false;
+            device.frameSequence = 0;
+            device.timeMs = 0;
+            device.waveformSequence = 0;
+            device.waveformRequestedMs = 0;
+            std::memset(device.channels, 0, sizeof(device.channels));
+        }
+    }
+
+    ~PushServer()
+    {
+        stop();
+    }
+
+    // Listen on 127.0.0.1:port and start the server thread. Browsers may only
+    // read responses and open /stream from allowedOrigin (e.g.
+    // "http://127.0.0.1:3000"); when it is empty, any page served from this
+    // host (127.0.0.1 or localhost, any port) is allowed.
+    bool start(int port, const std::string &allowedOrigin = std::string())
+    {
+        stop();
+        m_allowedOrigin = allowedOrigin;
+#ifdef _WIN32
+        WSADATA wsa;
+        if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0)
+        {
+            m_lastError = "WSAStartup failed";
+            return false;
+        }
+#endif
+        m_listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (m_listener == PUSH_INVALID_SOCKET)
+        {
+            m_lastError = "Cannot create the listening socket";
+            return false;
+        }
+        int reuse = 1;
+        setsockopt(m_listener, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char *>(&reuse), sizeof(reuse));
+
+        sockaddr_in address;
+        std::memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(port));
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(m_listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 ||
+            listen(m_listener, 8) != 0)
+        {
+            m_lastError = "Cannot listen on 127.0.0.1:" + std::to_string(port);
+            closeSocket(m_listener);
+            m_listener = PUSH_INVALID_SOCKET;
+            return false;
+        }
+        setNonBlocking(m_listener);
+
+        m_port = port;
+        m_running = true;
+        m_thread = std::thread(&PushServer::serverLoop, this);
+        return true;
+    }
+
+    void stop()
+    {
+        if (!m_running)
+            return;
+        m_running = false;
+        if (m_thread.joinable())
+            m_thread.join();
+        for (std::unique_ptr<Client> &client : m_clients)
+            closeSocket(client->socket);
+        m_clients.clear();
+        closeSocket(m_listener);
+        m_listener = PUSH_INVALID_SOCKET;
+#ifdef _WIN32
+        WSACleanup();
+#endif
+    }
+
+    bool isRunning() const
+    {
+        return m_running;
+    }
+
+    int port() const
+    {
+        return m_port;
+    }
+
+    // Record a device's values after a frame and queue the channels that
+    // changed for the clients subscribed to them. Called by device threads.
+    void publish(int device, uint64_t frameSequence, int64_t timeMs, const PushChannelValue (&channels)[CHANNELS])
+    {
+        if (!m_running || device < 0 || device >= MAX_DEVICES)
+            return;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        DeviceEntry &entry = m_devices[device];
+        Delta delta;
+        delta.device = device;
+        delta.frameSequence = frameSequence;
+        delta.timeMs = timeMs;
+        delta.changedMask = 0;
+        for (int ch = 0; ch < CHANNELS; ch++)
+        {
+            const PushChannelValue &value = channels[ch];
+            const PushChannelValue &previous = entry.channels[ch];
+            if (!entry.known || value.state != previous.state || value.transitions != previous.transitions ||
+                value.totalTransitions != previous.totalTransitions)
+            {
+                delta.changedMask |= 1u << ch;
+            }
+            delta.channels[ch] = value;
+        }
+        std::memcpy(entry.channels, channels, sizeof(entry.channels));
+        entry.known = true;
+        entry.frameSequence = frameSequence;
+        entry.timeMs = timeMs;
+        m_stats.framesPublished++;
+
+        if (delta.changedMask == 0)
+            return;
+        for (std::unique_ptr<Client> &client : m_clients)
+        {
+            if (!client->upgraded || !client->wantsDevice(device) || (delta.changedMask & client->channelMask) == 0)
+                continue;
+            if (client->pending.size() >= CLIENT_QUEUE_LIMIT)
+            {
+                // Too slow: forget the backlog, send the latest state instead
+                client->pending.clear();
+                if (!client->resync)
+                    m_stats.resyncs++;
+                client->resync = true;
+                continue;
+            }
+            if (!client->resync)
+                client->pending.push_back(delta);
+        }
+    }
+
+    // Whether anyone has asked for the device's waveform recently, i.e. whether
+    // publishWaveform is worth building a pyramid for. Once interest lapses
+    // the last pyramid is dropped, so a new client never sees a stale one.
+    bool wantsWaveform(int device)
+    {
+        if (!m_running || device < 0 || device >= MAX_DEVICES)
+            return false;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        DeviceEntry &entry = m_devices[device];
+        if (entry.waveformRequestedMs != 0 && steadyMs() - entry.waveformRequestedMs < WAVEFORM_INTEREST_MS)
+            return true;
+        entry.waveform.reset();
+        return false;
+    }
+
+    // Make a frame's waveform pyramid the one /waveform serves for the device
+    void publishWaveform(int device, uint64_t frameSequence, std::shared_ptr<const WaveformPyramid> pyramid)
+    {
+        if (!m_running || device < 0 || device >= MAX_DEVICES)
+            return;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_devices[device].waveform = std::move(pyramid);
+        m_devices[device].waveformSequence = frameSequence;
+    }
+
+    Stats stats() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Stats result = m_stats;
+        result.clients = 0;
+        for (const std::unique_ptr<Client> &client : m_clients)
+            result.clients += client->upgraded ? 1 : 0;
+        return result;
+    }
+
+    std::string getLastError() const
+    {
+        return m_lastError;
+    }
+
+private:
+    struct Delta
+    {
+        int device;
+        uint64_t frameSequence;
+        int64_t timeMs;
+        uint32_t changedMask;
+        PushChannelValue channels[CHANNELS];
+    };
+
+    struct DeviceEntry
+    {
+        bool known;
+        uint64_t frameSequence;
+        int64_t timeMs;
+        PushChannelValue channels[CHANNELS];
+        std::shared_ptr<const WaveformPyramid> waveform; // Latest frame's pyramid
+        uint64_t waveformSequence;
+        int64_t waveformRequestedMs; // Steady clock of the last /waveform request, 0 if none
+    };
+
+    // Fields up to pending are shared with publish() and guarded by
+    // m_mutex (upgraded is only written by the server thread, so that thread
+    // reads it without the lock); the rest belong to the server thread
+    struct Client
+    {
+        bool upgraded;      // WebSocket handshake done
+        bool resync;        // Owes the client a full state of its devices
+        uint64_t deviceMask;
+        uint32_t channelMask;
+        std::deque<Delta> pending;
+
+        PushSocket socket;
+        bool closing;       // Close once the output is flushed
+        std::string input;  // Received, not yet parsed
+        std::string output; // Encoded, not yet sent
+
+        bool wantsDevice(int device) const
+        {
+            return ((deviceMask >> device) & 1) != 0;
+        }
+    };
+
+    static void closeSocket(PushSocket socket)
+    {
+        if (socket == PUSH_INVALID_SOCKET)
+            return;
+#ifdef _WIN32
+        closesocket(socket);
+#else
+        ::close(socket);
+#endif
+    }
+
+    static void setNonBlocking(PushSocket socket)
+    {
+#ifdef _WIN32
+        u_long mode = 1;
+        ioctlsocket(socket, FIONBIO, &mode);
+#else
+        fcntl(socket, F_SETFL, fcntl(socket, F_GETFL, 0) | O_NONBLOCK);
+#endif
+    }
+
+    static bool wouldBlock()
+    {
+#ifdef _WIN32
+        return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+#endif
+    }
+
+    // Only this thread adds or removes clients (under m_mutex, for
+    // publish()), so it walks the list without the lock
+    void serverLoop()
+    {
+        while (m_running)
+        {
+            fd_set readable, writable;
+            FD_ZERO(&readable);
+            FD_ZERO(&writable);
+            FD_SET(m_listener, &readable);
+            PushSocket highest = m_listener;
+            for (std::unique_ptr<Client> &client : m_clients)
+            {
+                FD_SET(client->socket, &readable);
+                if (!client->output.empty())
+                    FD_SET(client->socket, &writable);
+                highest = std::max(highest, client->socket);
+            }
+
+            timeval timeout;
+            timeout.tv_sec = 0;
+            timeout.tv_usec = POLL_INTERVAL_MS * 1000;
+            const int ready = select(static_cast<int>(highest + 1), &readable, &writable, nullptr, &timeout);
+            if (ready < 0)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(POLL_INTERVAL_MS));
+                continue;
+            }
+
+            if (FD_ISSET(m_listener, &readable))
+                acceptClients();
+
+            for (size_t i = 0; i < m_clients.size();)
+            {
+                Client &client = *m_clients[i];
+                bool alive = true;
+                if (FD_ISSET(client.socket, &readable))
+                    alive = receive(client);
+                if (alive)
+                    alive = flush(client);
+                if (!alive)
+                {
+                    closeSocket(client.socket);
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_clients.erase(m_clients.begin() + i);
+                    continue;
+                }
+                i++;
+            }
+        }
+    }
+
+    void acceptClients()
+    {
+        while (true)
+        {
+            const PushSocket socket = accept(m_listener, nullptr, nullptr);
+            if (socket == PUSH_INVALID_SOCKET)
+                return;
+            if (m_clients.size() >= MAX_CLIENTS)
+            {
+                closeSocket(socket);
+                continue;
+            }
+            setNonBlocking(socket);
+            int noDelay = 1;
+            setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char *>(&noDelay), sizeof(noDelay));
+            int sendBuffer = CLIENT_SEND_BUFFER;
+            setsockopt(socket, SOL_SOCKET, SO_SNDBUF, reinterpret_cast<const char *>(&sendBuffer), sizeof(sendBuffer));
+
+            std::unique_ptr<Client> client(new Client());
+            client->socket = socket;
+            client->upgraded = false;
+            client->closing = false;
+            client->resync = false;
+            client->deviceMask = ~uint64_t(0);
+            client->channelMask = ~uint32_t(0);
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_clients.push_back(std::move(client));
+        }
+    }
+
+    // Read what the client sent; false to drop the connection
+    bool receive(Client &client)
+    {
+        char buffer[4096];
+        const int received = recv(client.socket, buffer, sizeof(buffer), 0);
+        if (received == 0)
+            return false;
+        if (received < 0)
+            return wouldBlock();
+        client.input.append(buffer, static_cast<size_t>(received));
+        if (client.input.size() > 2 * MAX_CLIENT_MESSAGE)
+            return false;
+        return client.upgraded ? parseFrames(client) : parseRequest(client);
+    }
+
+    // HTTP request: upgrade /stream to a WebSocket, answer /state and /waveform directly
+    bool parseRequest(Client &client)
+    {
+        const size_t end = client.input.find("\r\n\r\n");
+        if (end == std::string::npos)
+            return true;
+        const std::string request = client.input.substr(0, end);
+        client.input.erase(0, end + 4);
+
+        // Requests without an Origin come from native clients; browsers always
+        // send one, so other web pages cannot read the analyzer from localhost
+        const std::string origin = headerValue(request, "Origin");
+        const bool originAllowed = origin.empty() || isAllowedOrigin(origin);
+        const std::string key = headerValue(request, "Sec-WebSocket-Key");
+        if (request.compare(0, 12, "GET /stream ") == 0 && !key.empty() && !originAllowed)
+        {
+            const std::string body = "{\"error\":\"origin not allowed\"}";
+            client.output += "HTTP/1.1 403 Forbidden\r\nContent-Type: application/json\r\nConnection: close\r\n"
+                             "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+            client.closing = true;
+            return true;
+        }
+        if (request.compare(0, 12, "GET /stream ") == 0 && !key.empty())
+        {
+            client.output += "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                             "Sec-WebSocket-Accept: " +
+                             WebSocketHandshake::acceptKey(key) + "\r\n\r\n";
+            std::lock_guard<std::mutex> lock(m_mutex);
+            client.upgraded = true;
+            client.resync = true;
+            return true;
+        }
+
+        std::string body;
+        std::string status = "200 OK";
+        if (request.compare(0, 11, "GET /state ") == 0)
+        {
+            copyDeviceValues(~uint64_t(0));
+            body = "[";
+            bool first = true;
+            for (int device = 0; device < MAX_DEVICES; device++)
+            {
+                const DeviceEntry &entry = m_sendDevices[device];
+                if (!entry.known)
+                    continue;
+                if (!first)
+                    body += ",";
+                appendDeviceJson(body, "state", device, entry.frameSequence, entry.timeMs, entry.channels, ~uint32_t(0));
+                first = false;
+            }
+            body += "]";
+        }
+        else if (request.compare(0, 14, "GET /waveform?") == 0 || request.compare(0, 14, "GET /waveform ") == 0)
+        {
+            bool building = false;
+            if (!appendWaveformJson(body, request.substr(4, request.find(' ', 4) - 4), building))
+            {
+                status = building ? "503 Service Unavailable" : "404 Not Found";
+                body = building ? "{\"error\":\"waveform is being built, retry shortly\"}"
+                                : "{\"error\":\"no waveform for that device and channel\"}";
+            }
+        }
+        else
+        {
+            status = "404 Not Found";
+            body = "{\"error\":\"use /state, /waveform or /stream\"}";
+        }
+        client.output += "HTTP/1.1 " + status + "\r\nContent-Type: application/json\r\n";
+        if (!origin.empty() && originAllowed)
+            client.output += "Access-Control-Allow-Origin: " + origin + "\r\nVary: Origin\r\n";
+        client.output += "Cache-Control: no-store\r\nConnection: close\r\n"
+                         "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+        client.closing = true;
+        return true;
+    }
+
+    static int64_t steadyMs()
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    // Numeric query parameter of a request target, or fallback when absent
+    static uint64_t queryValue(const std::string &target, const char *name, uint64_t fallback)
+    {
+        const std::string key = std::string(name) + "=";
+        size_t position = target.find('?');
+        while (position != std::string::npos)
+        {
+            position++;
+            if (target.compare(position, key.size(), key) == 0)
+            {
+                const char *digits = target.c_str() + position + key.size();
+                if (!std::isdigit(static_cast<unsigned char>(*digits)))
+                    return fallback;
+                return std::strtoull(digits, nullptr, 10);
+            }
+            position = target.find('&', position);
+        }
+        return fallback;
+    }
+
+    // Pyramids are only built while someone asks for them, so the first
+    // request for a device sets building and fails; the next frame has one
+    bool appendWaveformJson(std::string &out, const std::string &target, bool &building)
+    {
+        const uint64_t device = queryValue(target, "device", MAX_DEVICES);
+        const uint64_t channel = queryValue(target, "channel", CHANNELS);
+        if (device >= MAX_DEVICES || channel >= CHANNELS)
+            return false;
+        std::shared_ptr<const WaveformPyramid> waveform;
+        uint64_t waveformSequence = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            DeviceEntry &entry = m_devices[device];
+            m_stats.waveformRequests++;
+            entry.waveformRequestedMs = steadyMs();
+            waveform = entry.waveform;
+            waveformSequence = entry.waveformSequence;
+            building = entry.known && !waveform;
+        }
+        if (!waveform)
+            return false;
+
+        // The pyramid is immutable; holding it keeps it alive while we read
+        const WaveformPyramid &pyramid = *waveform;
+        WaveformView view;
+        pyramid.query(static_cast<int>(channel), queryValue(target, "start", 0), queryValue(target, "end", pyramid.size()),
+                      static_cast<size_t>(queryValue(target, "buckets", 1024)), view);
+
+        char number[160];
+        std::snprintf(number, sizeof(number),
+                      "{\"device\":%d,\"channel\":%d,\"seq\":%llu,\"samples\":%llu,\"start\":%llu,\"bucketSamples\":%llu,\"flags\":\"",
+                      static_cast<int>(device), static_cast<int>(channel),
+                      static_cast<unsigned long long>(waveformSequence),
+                      static_cast<unsigned long long>(pyramid.size()), static_cast<unsigned long long>(view.start),
+                      static_cast<unsigned long long>(view.bucketSamples));
+        out += number;
+        for (uint8_t flags : view.flags)
+            out += static_cast<char>('0' + flags);
+        out += "\",\"toggles\":[";
+        for (size_t b = 0; b < view.toggles.size(); b++)
+        {
+            std::snprintf(number, sizeof(number), "%s%u", b ? "," : "", view.toggles[b]);
+            out += number;
+        }
+        out += "]}";
+        return true;
+    }
+
+    bool isAllowedOrigin(const std::string &origin) const
+    {
+        if (!m_allowedOrigin.empty())
+            return origin == m_allowedOrigin;
+        const size_t hostStart = origin.find("://");
+        if (hostStart == std::string::npos)
+            return false;
+        const std::string scheme = origin.substr(0, hostStart);
+        std::string host = origin.substr(hostStart + 3);
+        const size_t portStart = host.find(':');
+        if (portStart != std::string::npos)
+        {
+            const std::string port = host.substr(portStart + 1);
+            if (port.empty() || port.size() > 5 ||
+                !std::all_of(port.begin(), port.end(), [](char c)
+                             { return std::isdigit(static_cast<unsigned char>(c)) != 0; }))
+                return false;
+            host.erase(portStart);
+        }
+        return (scheme == "http" || scheme == "https") && (host == "127.0.0.1" || host == "localhost");
+    }
+
+    static std::string headerValue(const std::string &request, const std::string &name)
+    {
+        size_t position = 0;
+        while ((position = request.find("\r\n", position)) != std::string::npos)
+        {
+            position += 2;
+            if (request.size() - position > name.size() &&
+                std::equal(name.begin(), name.end(), request.begin() + position, [](char a, char b)
+                           { return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b)); }) &&
+                request[position + name.size()] == ':')
+            {
+                size_t start = position + name.size() + 1;
+                const size_t end = request.find("\r\n", start);
+                while (start < request.size() && request[start] == ' ')
+                    start++;
+                return request.substr(start, end == std::string::npos ? std::string::npos : end - start);
+            }
+        }
+        return std::string();
+    }
+
+    // Client frames (always masked): text = subscription, ping, close
+    bool parseFrames(Client &client)
+    {
+        while (client.input.size() >= 2)
+        {
+            const unsigned char *data = reinterpret_cast<const unsigned char *>(client.input.data());
+            const int opcode = data[0] & 0x0F;
+            const bool masked = (data[1] & 0x80) != 0;
+            uint64_t length = data[1] & 0x7F;
+            size_t headerSize = 2;
+            if (length == 126)
+            {
+                if (client.input.size() < 4)
+                    return true;
+                length = (uint64_t(data[2]) << 8) | data[3];
+                headerSize = 4;
+            }
+            else if (length == 127)
+            {
+                return false; // Nothing we accept is that long
+            }
+            if (!masked || length > MAX_CLIENT_MESSAGE)
+                return false;
+            if (client.input.size() < headerSize + 4 + length)
+                return true;
+
+            const unsigned char *mask = data + headerSize;
+            std::string payload(static_cast<size_t>(length), '\0');
+            for (size_t i = 0; i < length; i++)
+                payload[i] = static_cast<char>(data[headerSize + 4 + i] ^ mask[i % 4]);
+            client.input.erase(0, headerSize + 4 + static_cast<size_t>(length));
+
+            if (opcode == 0x8)
+            {
+                client.output += encodeFrame(0x8, std::string());
+                client.closing = true;
+                return true;
+            }
+            if (opcode == 0x9)
+                client.output += encodeFrame(0xA, payload);
+            else if (opcode == 0x1)
+                subscribe(client, payload);
+        }
+        return true;
+    }
+
+    // {"devices":[...],"channels":[...]}; a missing list means all
+    void subscribe(Client &client, const std::string &message)
+    {
+        std::vector<int> devices, channels;
+        uint64_t deviceMask = parseList(message, "devices", devices) ? 0 : ~uint64_t(0);
+        for (int device : devices)
+            if (device >= 0 && device < MAX_DEVICES)
+                deviceMask |= uint64_t(1) << device;
+        uint32_t channelMask = parseList(message, "channels", channels) ? 0 : ~uint32_t(0);
+        for (int channel : channels)
+            if (channel >= 0 && channel < CHANNELS)
+                channelMask |= 1u << channel;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        client.deviceMask = deviceMask;
+        client.channelMask = channelMask;
+        client.pending.clear();
+        client.resync = true;
+    }
+
+    static bool parseList(const std::string &message, const std::string &key, std::vector<int> &values)
+    {
+        const size_t keyPosition = message.find("\"" + key + "\"");
+        if (keyPosition == std::string::npos)
+            return false;
+        const size_t open = message.find('[', keyPosition);
+        const size_t close = message.find(']', open);
+        if (open == std::string::npos || close == std::string::npos)
+            return false;
+        const std::string list = message.substr(open + 1, close - open - 1);
+        for (size_t i = 0; i < list.size();)
+        {
+            if (list[i] >= '0' && list[i] <= '9')
+            {
+                // Stop accumulating past any valid index so long numbers
+                // cannot overflow; such entries are dropped
+                int value = 0;
+                bool tooLarge = false;
+                while (i < list.size() && list[i] >= '0' && list[i] <= '9')
+                {
+                    if (value >= MAX_DEVICES)
+                        tooLarge = true;
+                    else
+                        value = value * 10 + (list[i] - '0');
+                    i++;
+                }
+                if (!tooLarge && value < MAX_DEVICES)
+                    values.push_back(value);
+            }
+            else
+            {
+                i++;
+            }
+        }
+        return true;
+    }
+
+    // Encode what the client is owed and send as much as the socket takes;
+    // false when the connection is done or broken
+    bool flush(Client &client)
+    {
+        if (client.upgraded && client.output.empty())
+        {
+            // Take what the client is owed, then encode it unlocked
+            bool resync = false;
+            uint32_t channelMask = 0;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                resync = client.resync;
+                client.resync = false;
+                channelMask = client.channelMask;
+                m_sendQueue.swap(client.pending);
+                m_stats.deltasSent += m_sendQueue.size();
+                if (resync)
+                    copyDeviceValuesLocked(client.deviceMask);
+            }
+            if (resync)
+            {
+                for (int device = 0; device < MAX_DEVICES; device++)
+                {
+                    const DeviceEntry &entry = m_sendDevices[device];
+                    if (!entry.known)
+                        continue;
+                    std::string message;
+                    appendDeviceJson(message, "state", device, entry.frameSequence, entry.timeMs, entry.channels,
+                                     channelMask);
+                    client.output += encodeFrame(0x1, message);
+                }
+            }
+            for (const Delta &delta : m_sendQueue)
+            {
+                std::string message;
+                appendDeviceJson(message, "delta", delta.device, delta.frameSequence, delta.timeMs, delta.channels,
+                                 delta.changedMask & channelMask);
+                client.output += encodeFrame(0x1, message);
+            }
+            m_sendQueue.clear();
+        }
+
+        while (!client.output.empty())
+        {
+#ifdef MSG_NOSIGNAL
+            const int flags = MSG_NOSIGNAL; // A client that went away must not raise SIGPIPE
+#else
+            const int flags = 0;
+#endif
+            const int sent = send(client.socket, client.output.data(), static_cast<int>(client.output.size()), flags);
+            if (sent < 0)
+                return wouldBlock();
+            client.output.erase(0, static_cast<size_t>(sent));
+        }
+        return !client.closing;
+    }
+
+    // Copy the values of the known devices in deviceMask into m_sendDevices;
+    // the others are marked unknown there
+    void copyDeviceValues(uint64_t deviceMask)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        copyDeviceValuesLocked(deviceMask);
+    }
+
+    void copyDeviceValuesLocked(uint64_t deviceMask)
+    {
+        for (int device = 0; device < MAX_DEVICES; device++)
+        {
+            const DeviceEntry &entry = m_devices[device];
+            DeviceEntry &copy = m_sendDevices[device];
+            copy.known = entry.known && ((deviceMask >> device) & 1) != 0;
+            if (!copy.known)
+                continue;
+            copy.frameSequence = entry.frameSequence;
+            copy.timeMs = entry.timeMs;
+            std::memcpy(copy.channels, entry.channels, sizeof(copy.channels));
+        }
+    }
+
+    static void appendDeviceJson(std::string &out, const char *type, int device, uint64_t frameSequence, int64_t timeMs,
+                                 const PushChannelValue *channels, uint32_t channelMask)
+    {
+        char number[96];
+        std::snprintf(number, sizeof(number), "{\"type\":\"%s\",\"device\":%d,\"seq\":%llu,\"time\":%lld,\"channels\":[",
+                      type, device, static_cast<unsigned long long>(frameSequence), static_cast<long long>(timeMs));
+        out += number;
+        bool first = true;
+        for (int ch = 0; ch < CHANNELS; ch++)
+        {
+            if (((channelMask >> ch) & 1) == 0)
+                continue;
+            std::snprintf(number, sizeof(number), "%s[%d,%u,%d,%d]", first ? "" : ",", ch, channels[ch].state,
+                          channels[ch].transitions, channels[ch].totalTransitions);
+            out += number;
+            first = false;
+        }
+        out += "]}";
+    }
+
+    // Unmasked server frame
+    static std::string encodeFrame(int opcode, const std::string &payload)
+    {
+        std::string frame;
+        frame += static_cast<char>(0x80 | opcode);
+        const size_t length = payload.size();
+        if (length < 126)
+        {
+            frame += static_cast<char>(length);
+        }
+        else if (length < 65536)
+        {
+            frame += static_cast<char>(126);
+            frame += static_cast<char>(length >> 8);
+            frame += static_cast<char>(length & 0xFF);
+        }
+        else
+        {
+            frame += static_cast<char>(127);
+            for (int i = 7; i >= 0; i--)
+                frame += static_cast<char>((static_cast<uint64_t>(length) >> (i * 8)) & 0xFF);
+        }
+        return frame + payload;
+    }
+
+    PushSocket m_listener;
+    std::atomic<bool> m_running;
+    int m_port;
+    std::thread m_thread;
+    mutable std::mutex m_mutex; // Guards the client list and shared client fields, device entries and stats
+    std::vector<std::unique_ptr<Client>> m_clients;
+    DeviceEntry m_devices[MAX_DEVICES];
+    Stats m_stats;
+    DeviceEntry m_sendDevices[MAX_DEVICES]; // Server thread: values copied out for a state message
+    std::deque<Delta> m_sendQueue;          // Server thread: deltas being encoded
+    std::string m_allowedOrigin; // Browser origin allowed in; empty = pages from this host
+    std::string m_lastError;
+};
@@ -0,0 +1,238 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include "capture_backend.h"
+#include "capture_recording.h"
+
+// How a recording is played back
+enum class ReplayPacing
+{
+    FAST,    // Every capture completes as soon as it is armed
+    ORIGINAL // Frames become ready at the times they were recorded
+};
+
+// Plays a recording made with --record back as if it came from the device,
+// so processData and the exporters see exactly the captured samples. Each
+// device reads <directory>/device_<index>.lacap; the recording runs
+// `loops` times and the source is exhausted afterwards.
+class ReplayBackend : public CaptureBackend
+{
+public:
+    ReplayBackend(ReplayPacing pacing, int loops)
+        : m_pacing(pacing), m_loops(std::max(1, loops)), m_loopsDone(0), m_deviceIndex(0),
+          m_connected(false), m_armed(false), m_haveNext(false), m_rateCode(0), m_depth(0),
+          m_loopStartOffsetNs(0)
+    {
+    }
+
+    const char *name() const
+    {
+        return "replay";
+    }
+
+    bool open(const std::string &directory)
+    {
+        m_directory = directory;
+        return true;
+    }
+
+    bool connect(unsigned short deviceIndex)
+    {
+        m_deviceIndex = deviceIndex;
+        if (!m_reader.open(recordingFilePath(m_directory, deviceIndex)))
+        {
+            m_lastError = m_reader.getLastError();
+            return false;
+        }
+        if (!m_reader.nextFrame(m_next))
+        {
+            m_lastError = m_reader.getLastError().empty() ? "Recording has no frames" : m_reader.getLastError();
+            return false;
+        }
+        m_haveNext = true;
+        m_rateCode = m_next.sampleRateCode;
+        m_depth = static_cast<unsigned long>(m_next.sampleCount);
+        m_loopStartOffsetNs = m_next.offsetNs;
+        m_connected = true;
+        return true;
+    }
+
+    bool initialize()
+    {
+        if (!m_connected)
+        {
+            m_lastError = "Replay device not connected";
+            return false;
+        }
+        m_armed = false;
+        return true;
+    }
+
+    // The recorded samples cannot be captured again at another rate or depth
+    bool setSampleRate(unsigned short rateCode)
+    {
+        if (rateCode != m_rateCode)
+        {
+            m_lastError = "Recording was captured with rate code " + std::to_string(m_rateCode);
+            return false;
+        }
+        return true;
+    }
+
+    bool setSampleDepth(unsigned long depth)
+    {
+        if (depth != m_depth)
+        {
+            m_lastError = "Recording was captured with depth " + std::to_string(m_depth);
+            return false;
+        }
+        return true;
+    }
+
+    bool setVoltageThreshold(double threshold)
+    {
+        (void)threshold;
+        return true;
+    }
+
+    bool configureTrigger(bool enabled, unsigned short channel, bool risingEdge)
+    {
+        (void)enabled;
+        (void)channel;
+        (void)risingEdge;
+        return true;
+    }
+
+    bool setPreTrigger(unsigned short percentage)
+    {
+        (void)percentage;
+        return true;
+    }
+
+    bool startCapture()
+    {
+        if (!m_haveNext)
+        {
+            m_lastError = "Replay finished";
+            return false;
+        }
+        if (m_loopStart == std::chrono::steady_clock::time_point())
+        {
+            m_loopStart = std::chrono::steady_clock::now();
+        }
+        m_current = m_next;
+        m_armed = true;
+        return true;
+    }
+
+    int readStatus()
+    {
+        if (!m_armed)
+        {
+            m_lastError = "No capture armed";
+            return -1;
+        }
+        if (m_pacing == ReplayPacing::FAST)
+        {
+            return 1;
+        }
+        const auto due = m_loopStart + std::chrono::nanoseconds(m_current.offsetNs - m_loopStartOffsetNs);
+        return std::chrono::steady_clock::now() >= due ? 1 : 0;
+    }
+
+    // A frame recorded at a different depth than the first one (the config
+    // changed while recording) is cut to the configured depth, or read as
+    // the shorter frame it is
+    bool readSamples(uint32_t *samples, unsigned long sampleCount, unsigned long &samplesRead)
+    {
+        samplesRead = 0;
+        if (!m_armed)
+        {
+            m_lastError = "No capture armed";
+            return false;
+        }
+        m_armed = false;
+
+        if (!m_reader.readSamples(m_current, samples, sampleCount))
+        {
+            m_lastError = m_reader.getLastError();
+            m_haveNext = false;
+            return false;
+        }
+        samplesRead = m_current.sampleCount < sampleCount ? static_cast<unsigned long>(m_current.sampleCount)
+                                                          : sampleCount;
+        advance();
+        return true;
+    }
+
+    bool isPaced() const
+    {
+        return m_pacing == ReplayPacing::ORIGINAL;
+    }
+
+    bool isExhausted() const
+    {
+        return m_connected && !m_haveNext && !m_armed;
+    }
+
+    bool recordedSettings(unsigned short &rateCode, unsigned long &depth) const
+    {
+        if (!m_connected)
+            return false;
+        rateCode = m_rateCode;
+        depth = m_depth;
+        return true;
+    }
+
+    std::string serialNumber() const
+    {
+        const RecordingFileHeader &header = m_reader.header();
+        return std::string(header.serialNumber, strnlen(header.serialNumber, sizeof(header.serialNumber)));
+    }
+
+    std::string model() const
+    {
+        const RecordingFileHeader &header = m_reader.header();
+        return std::string(header.model, strnlen(header.model, sizeof(header.model))) + " (replay)";
+    }
+
+    std::string firmwareVersion() const
+    {
+        return "replay-" + std::to_string(RECORDING_VERSION);
+    }
+
+private:
+    // Look ahead to the next frame, starting another pass when the recording ends
+    void advance()
+    {
+        m_haveNext = m_reader.nextFrame(m_next);
+        if (m_haveNext || !m_reader.getLastError().empty())
+        {
+            return;
+        }
+        if (++m_loopsDone < m_loops && m_reader.rewind() && m_reader.nextFrame(m_next))
+        {
+            m_haveNext = true;
+            m_loopStart = std::chrono::steady_clock::time_point();
+            m_loopStartOffsetNs = m_next.offsetNs;
+        }
+    }
+
+    const ReplayPacing m_pacing;
+    const int m_loops;
+    int m_loopsDone;
+    std::string m_directory;
+    CaptureRecordingReader m_reader;
+    unsigned short m_deviceIndex;
+    bool m_connected;
+    bool m_armed;
+    bool m_haveNext;
+    RecordingFrameHeader m_current; // Frame of the armed capture
+    RecordingFrameHeader m_next;    // Frame the next capture will return
+    unsigned short m_rateCode;
+    unsigned long m_depth;
+    std::chrono::steady_clock::time_point m_loopStart; // Replay time of the first frame of this pass
+    int64_t m_loopStartOffsetNs;                       // Recorded offset of that frame
+};
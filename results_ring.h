@@ -0,0 +1,480 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#ifdef _WIN32
+#include <windows.h>
+#undef max
+#undef min
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Analysis results of one frame of one device, as appended to the results ring
+struct ResultsRecord
+{
+    uint64_t sequence;      // Position in the ring's stream, set by the ring
+    uint64_t frameSequence; // Device frame counter
+    int64_t captureTimeMs;  // Wall clock when the frame was analysed (ms since the epoch)
+    uint32_t deviceIndex;
+    uint32_t sliceCount;    // Valid columns of sliceActivity
+    uint32_t changedMask;   // Channels with an edge within the highlight window
+    uint32_t stateMask;     // Current level of every channel
+    int32_t transitions[32];
+    float sliceActivity[12][16]; // Probe channels x slices, %
+    float meanPhase[12];         // Radians
+    float phaseVariance[12];
+};
+
+static_assert(sizeof(ResultsRecord) % sizeof(uint64_t) == 0, "records are copied in 64-bit words");
+
+// Shared-memory ring of ResultsRecords that other processes follow without
+// locks and without touching the filesystem.
+//
+// The mapping holds a ResultsRingHeader followed by capacity slots. Record n
+// goes to slot n % capacity; the slot's sequence word is 2n+1 while the record
+// is being written and 2n+2 once it is complete, and the header's writeCount
+// is advanced to n+1 afterwards. A reader wanting record n copies the slot and
+// accepts the copy only if the sequence was 2n+2 both before and after; a
+// larger value means the writer has already reused the slot, i.e. the reader
+// fell more than capacity records behind.
+//
+// The shared object is "Local\<name>" on Windows and "/<name>" (shm_open) on
+// POSIX. The analyzer creates it, only when asked to, accessible to its own
+// user alone; readers open it read-only. On shutdown the analyzer clears the
+// magic, which readers see as RESTARTED, and removes the object, so nothing
+// is left behind in /dev/shm.
+struct ResultsRingHeader
+{
+    char magic[8];       // "LARESRNG"
+    uint32_t version;    // RESULTS_RING_VERSION
+    uint32_t recordSize; // sizeof(ResultsRecord)
+    uint32_t capacity;   // Slots, a power of two
+    uint32_t slotSize;   // Bytes per slot including its sequence word
+    int64_t createdMs;   // Changes when the analyzer recreates the ring
+    std::atomic<uint64_t> writeCount; // Records completed so far
+};
+
+const uint32_t RESULTS_RING_VERSION = 1;
+
+// Platform shared-memory mapping, created by the writer or opened by readers
+class SharedMemoryRegion
+{
+public:
+    SharedMemoryRegion() : m_data(nullptr), m_size(0)
+#ifdef _WIN32
+                           , m_mapping(nullptr)
+#endif
+    {
+    }
+
+    ~SharedMemoryRegion()
+    {
+        close();
+    }
+
+    SharedMemoryRegion(const SharedMemoryRegion &) = delete;
+    SharedMemoryRegion &operator=(const SharedMemoryRegion &) = delete;
+
+    // create: make (or resize) the region read-write; otherwise map an existing one read-only
+    bool open(const std::string &name, size_t size, bool create)
+    {
+        close();
+#ifdef _WIN32
+        const std::string objectName = "Local\\" + name;
+        if (create)
+        {
+            m_mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                           static_cast<DWORD>(static_cast<uint64_t>(size) >> 32),
+                                           static_cast<DWORD>(size), objectName.c_str());
+        }
+        else
+        {
+            m_mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, objectName.c_str());
+        }
+        if (!m_mapping)
+        {
+            m_lastError = "Cannot open shared memory " + objectName + " (error " + std::to_string(GetLastError()) + ")";
+            return false;
+        }
+        m_data = MapViewOfFile(m_mapping, create ? FILE_MAP_ALL_ACCESS : FILE_MAP_READ, 0, 0, size);
+        if (!m_data)
+        {
+            m_lastError = "Cannot map shared memory " + objectName;
+            close();
+            return false;
+        }
+#else
+        const std::string objectName = "/" + name;
+        const int fd = create ? shm_open(objectName.c_str(), O_CREAT | O_RDWR, 0600)
+                              : shm_open(objectName.c_str(), O_RDONLY, 0);
+        if (fd < 0)
+        {
+            m_lastError = "Cannot open shared memory " + objectName;
+            return false;
+        }
+        if (create && ftruncate(fd, static_cast<off_t>(size)) != 0)
+        {
+            m_lastError = "Cannot size shared memory " + objectName;
+            ::close(fd);
+            return false;
+        }
+        if (!create)
+        {
+            struct stat info;
+            if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < size)
+            {
+                m_lastError = "Shared memory " + objectName + " is smaller than expected";
+                ::close(fd);
+                return false;
+            }
+        }
+        void *data = mmap(nullptr, size, create ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (data == MAP_FAILED)
+        {
+            m_lastError = "Cannot map shared memory " + objectName;
+            return false;
+        }
+        m_data = data;
+#endif
+        m_size = size;
+        return true;
+    }
+
+    void close()
+    {
+#ifdef _WIN32
+        if (m_data)
+            UnmapViewOfFile(m_data);
+        if (m_mapping)
+            CloseHandle(m_mapping);
+        m_mapping = nullptr;
+#else
+        if (m_data)
+            munmap(m_data, m_size);
+#endif
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+    // Remove a created object by name; mappings still open stay valid.
+    // Windows frees the object with its last handle, so there is nothing to do.
+    static void remove(const std::string &name)
+    {
+#ifndef _WIN32
+        shm_unlink(("/" + name).c_str());
+#else
+        (void)name;
+#endif
+    }
+
+    void *data() const
+    {
+        return m_data;
+    }
+
+    size_t size() const
+    {
+        return m_size;
+    }
+
+    std::string getLastError() const
+    {
+        return m_lastError;
+    }
+
+private:
+    void *m_data;
+    size_t m_size;
+#ifdef _WIN32
+    HANDLE m_mapping;
+#endif
+    std::string m_lastError;
+};
+
+// Slot of the ring: sequence word followed by the record as relaxed atomic
+// words, so concurrent copies are well defined (as in SnapshotPublisher)
+struct ResultsRingSlot
+{
+    enum
+    {
+        WORDS = sizeof(ResultsRecord) / sizeof(uint64_t)
+    };
+
+    std::atomic<uint64_t> sequence;
+    std::atomic<uint64_t> words[WORDS];
+};
+
+static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t), "shared ring needs plain 64-bit atomics");
+
+inline size_t resultsRingSize(uint32_t capacity)
+{
+    return sizeof(ResultsRingHeader) + static_cast<size_t>(capacity) * sizeof(ResultsRingSlot);
+}
+
+// Appending side, owned by the analyzer. Device threads append concurrently,
+// so appends are serialized by a local mutex; readers never take it.
+class ResultsRingWriter
+{
+public:
+    ResultsRingWriter() : m_header(nullptr), m_slots(nullptr), m_capacity(0), m_next(0) {}
+
+    ~ResultsRingWriter()
+    {
+        close();
+    }
+
+    // capacity must be a power of two
+    bool create(const std::string &name, uint32_t capacity)
+    {
+        if (capacity == 0 || (capacity & (capacity - 1)) != 0)
+        {
+            m_lastError = "Ring capacity must be a power of two";
+            return false;
+        }
+        if (!std::atomic<uint64_t>().is_lock_free())
+        {
+            m_lastError = "64-bit atomics are not lock-free on this platform";
+            return false;
+        }
+        if (!m_region.open(name, resultsRingSize(capacity), true))
+        {
+            m_lastError = m_region.getLastError();
+            return false;
+        }
+
+        // Invalidate the header first so readers attached to an earlier ring
+        // notice the restart instead of mixing old and new records
+        char *base = static_cast<char *>(m_region.data());
+        m_header = reinterpret_cast<ResultsRingHeader *>(base);
+        m_slots = reinterpret_cast<ResultsRingSlot *>(base + sizeof(ResultsRingHeader));
+        std::memset(m_header->magic, 0, sizeof(m_header->magic));
+        std::atomic_thread_fence(std::memory_order_release);
+        for (uint32_t i = 0; i < capacity; i++)
+        {
+            m_slots[i].sequence.store(0, std::memory_order_relaxed);
+        }
+        m_header->version = RESULTS_RING_VERSION;
+        m_header->recordSize = sizeof(ResultsRecord);
+        m_header->capacity = capacity;
+        m_header->slotSize = sizeof(ResultsRingSlot);
+        m_header->createdMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                  std::chrono::system_clock::now().time_since_epoch())
+                                  .count();
+        m_header->writeCount.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(m_header->magic, "LARESRNG", sizeof(m_header->magic));
+        std::atomic_thread_fence(std::memory_order_release);
+
+        m_capacity = capacity;
+        m_next = 0;
+        m_name = name;
+        return true;
+    }
+
+    // Tell readers the ring is gone and remove the shared object
+    void close()
+    {
+        if (!m_header)
+            return;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::memset(m_header->magic, 0, sizeof(m_header->magic));
+        std::atomic_thread_fence(std::memory_order_release);
+        m_region.close();
+        SharedMemoryRegion::remove(m_name);
+        m_header = nullptr;
+        m_slots = nullptr;
+    }
+
+    bool isOpen() const
+    {
+        return m_header != nullptr;
+    }
+
+    // Append a record; its sequence field is filled in
+    void append(ResultsRecord &record)
+    {
+        if (!m_header)
+            return;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_header)
+            return; // Closed meanwhile
+        const uint64_t n = m_next++;
+        record.sequence = n;
+
+        ResultsRingSlot &slot = m_slots[n & (m_capacity - 1)];
+        slot.sequence.store(2 * n + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        const unsigned char *bytes = reinterpret_cast<const unsigned char *>(&record);
+        for (size_t i = 0; i < ResultsRingSlot::WORDS; i++)
+        {
+            uint64_t word;
+            std::memcpy(&word, bytes + i * sizeof(uint64_t), sizeof(word));
+            slot.words[i].store(word, std::memory_order_relaxed);
+        }
+        slot.sequence.store(2 * n + 2, std::memory_order_release);
+        m_header->writeCount.store(n + 1, std::memory_order_release);
+    }
+
+    uint64_t recordsWritten() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_next;
+    }
+
+    uint32_t capacity() const
+    {
+        return m_capacity;
+    }
+
+    std::string getLastError() const
+    {
+        return m_lastError;
+    }
+
+private:
+    SharedMemoryRegion m_region;
+    ResultsRingHeader *m_header;
+    ResultsRingSlot *m_slots;
+    uint32_t m_capacity;
+    uint64_t m_next;
+    std::string m_name;
+    mutable std::mutex m_mutex;
+    std::string m_lastError;
+};
+
+// Following side, for other processes. Each reader keeps its own cursor.
+class ResultsRingReader
+{
+public:
+    enum class ReadStatus
+    {
+        OK,        // record holds the next record
+        EMPTY,     // Caught up with the writer
+        OVERRUN,   // Fell behind; the cursor skipped to the oldest record still in the ring (see lost())
+        RESTARTED  // The analyzer recreated the ring; reopen it
+    };
+
+    ResultsRingReader() : m_header(nullptr), m_slots(nullptr), m_capacity(0), m_createdMs(0), m_cursor(0), m_lost(0) {}
+
+    // Attach to the ring; fromOldest starts at the oldest record still
+    // available, otherwise only records appended from now on are read
+    bool open(const std::string &name, bool fromOldest = false)
+    {
+        // Map the header alone first to learn the capacity
+        if (!m_region.open(name, sizeof(ResultsRingHeader), false))
+        {
+            m_lastError = m_region.getLastError();
+            return false;
+        }
+        const ResultsRingHeader *header = static_cast<const ResultsRingHeader *>(m_region.data());
+        if (std::memcmp(header->magic, "LARESRNG", sizeof(header->magic)) != 0 ||
+            header->version != RESULTS_RING_VERSION || header->recordSize != sizeof(ResultsRecord) ||
+            header->slotSize != sizeof(ResultsRingSlot))
+        {
+            m_lastError = "Shared memory " + name + " is not a compatible results ring";
+            m_region.close();
+            return false;
+        }
+        const uint32_t capacity = header->capacity;
+        if (!m_region.open(name, resultsRingSize(capacity), false))
+        {
+            m_lastError = m_region.getLastError();
+            return false;
+        }
+
+        const char *base = static_cast<const char *>(m_region.data());
+        m_header = reinterpret_cast<const ResultsRingHeader *>(base);
+        m_slots = reinterpret_cast<const ResultsRingSlot *>(base + sizeof(ResultsRingHeader));
+        m_capacity = capacity;
+        m_createdMs = m_header->createdMs;
+        const uint64_t written = m_header->writeCount.load(std::memory_order_acquire);
+        m_cursor = fromOldest && written > capacity ? written - capacity : (fromOldest ? 0 : written);
+        m_lost = 0;
+        return true;
+    }
+
+    ReadStatus read(ResultsRecord &record)
+    {
+        if (!m_header)
+            return ReadStatus::EMPTY;
+        if (m_header->createdMs != m_createdMs || std::memcmp(m_header->magic, "LARESRNG", 8) != 0)
+            return ReadStatus::RESTARTED;
+
+        const uint64_t written = m_header->writeCount.load(std::memory_order_acquire);
+        if (m_cursor >= written)
+            return ReadStatus::EMPTY;
+        if (written - m_cursor > m_capacity)
+        {
+            return skipToOldest(written);
+        }
+
+        const ResultsRingSlot &slot = m_slots[m_cursor & (m_capacity - 1)];
+        const uint64_t expected = 2 * m_cursor + 2;
+        const uint64_t before = slot.sequence.load(std::memory_order_acquire);
+        if (before == expected)
+        {
+            unsigned char *bytes = reinterpret_cast<unsigned char *>(&record);
+            for (size_t i = 0; i < ResultsRingSlot::WORDS; i++)
+            {
+                const uint64_t word = slot.words[i].load(std::memory_order_relaxed);
+                std::memcpy(bytes + i * sizeof(uint64_t), &word, sizeof(word));
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.sequence.load(std::memory_order_relaxed) == expected)
+            {
+                m_cursor++;
+                return ReadStatus::OK;
+            }
+        }
+        // The slot moved on while (or before) we looked at it
+        return skipToOldest(m_header->writeCount.load(std::memory_order_acquire));
+    }
+
+    // Records skipped because the reader fell behind, since open()
+    uint64_t lost() const
+    {
+        return m_lost;
+    }
+
+    // Sequence of the next record read() will return
+    uint64_t cursor() const
+    {
+        return m_cursor;
+    }
+
+    std::string getLastError() const
+    {
+        return m_lastError;
+    }
+
+private:
+    ReadStatus skipToOldest(uint64_t written)
+    {
+        // Leave a little headroom so the writer does not lap us again at once
+        const uint64_t oldest = written > m_capacity ? written - m_capacity + m_capacity / 8 : 0;
+        if (oldest > m_cursor)
+        {
+            m_lost += oldest - m_cursor;
+            m_cursor = oldest;
+        }
+        return ReadStatus::OVERRUN;
+    }
+
+    SharedMemoryRegion m_region;
+    const ResultsRingHeader *m_header;
+    const ResultsRingSlot *m_slots;
+    uint32_t m_capacity;
+    int64_t m_createdMs;
+    uint64_t m_cursor;
+    uint64_t m_lost;
+    std::string m_lastError;
+};
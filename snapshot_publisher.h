@@ -0,0 +1,140 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <atomic>
+#include <mutex>
+#include <type_traits>
+#include <algorithm>
+
+// Publishes consistent copies of a plain-data value to any number of
+// readers without locks (a double-buffered seqlock).
+// The writer fills the slot readers are not pointed at, bumping that slot's
+// sequence to odd while it writes and back to even when done, then points
+// readers at it. A reader copies the current slot and retries only if the
+// sequence changed under it, which needs the writer to publish twice during
+// one copy. Readers never block writers and writers never wait for readers;
+// writers only serialize among themselves.
+// The payload is stored as relaxed atomic words so the concurrent copy is
+// well defined; T must be trivially copyable.
+template <typename T>
+class SnapshotPublisher
+{
+    static_assert(std::is_trivially_copyable<T>::value, "snapshots are copied bytewise");
+
+public:
+    SnapshotPublisher() : m_current(0), m_version(0)
+    {
+        for (Slot &slot : m_slots)
+        {
+            slot.sequence.store(0, std::memory_order_relaxed);
+            storeWords(slot, m_staging);
+        }
+    }
+
+    // Change the published value in place: update(T&) runs on the writer's
+    // copy under the writer lock, the result is then published. Each field
+    // should have a single writing thread; update() only prevents two
+    // writers from publishing at the same time.
+    template <typename Update>
+    void update(Update update)
+    {
+        std::lock_guard<std::mutex> lock(m_writerMutex);
+        update(m_staging);
+        publishLocked();
+    }
+
+    void publish(const T &value)
+    {
+        std::lock_guard<std::mutex> lock(m_writerMutex);
+        m_staging = value;
+        publishLocked();
+    }
+
+    // Copy the latest published value
+    void read(T &out) const
+    {
+        while (true)
+        {
+            const Slot &slot = m_slots[m_current.load(std::memory_order_acquire)];
+            const uint64_t before = slot.sequence.load(std::memory_order_acquire);
+            if (before & 1)
+            {
+                continue; // Writer lapped us and is filling this slot
+            }
+            loadWords(slot, out);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.sequence.load(std::memory_order_relaxed) == before)
+            {
+                return;
+            }
+        }
+    }
+
+    T read() const
+    {
+        T value;
+        read(value);
+        return value;
+    }
+
+    // Number of values published so far
+    uint64_t version() const
+    {
+        return m_version.load(std::memory_order_acquire);
+    }
+
+private:
+    enum
+    {
+        WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t)
+    };
+
+    struct Slot
+    {
+        std::atomic<uint64_t> sequence;
+        std::atomic<uint64_t> words[WORDS];
+    };
+
+    void publishLocked()
+    {
+        const unsigned next = m_current.load(std::memory_order_relaxed) ^ 1u;
+        Slot &slot = m_slots[next];
+        const uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+        slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        storeWords(slot, m_staging);
+        slot.sequence.store(sequence + 2, std::memory_order_release);
+        m_current.store(next, std::memory_order_release);
+        m_version.fetch_add(1, std::memory_order_release);
+    }
+
+    static void storeWords(Slot &slot, const T &value)
+    {
+        const unsigned char *bytes = reinterpret_cast<const unsigned char *>(&value);
+        for (size_t i = 0; i < WORDS; i++)
+        {
+            uint64_t word = 0;
+            const size_t offset = i * sizeof(uint64_t);
+            std::memcpy(&word, bytes + offset, std::min(sizeof(uint64_t), sizeof(T) - offset));
+            slot.words[i].store(word, std::memory_order_relaxed);
+        }
+    }
+
+    static void loadWords(const Slot &slot, T &value)
+    {
+        unsigned char *bytes = reinterpret_cast<unsigned char *>(&value);
+        for (size_t i = 0; i < WORDS; i++)
+        {
+            const uint64_t word = slot.words[i].load(std::memory_order_relaxed);
+            const size_t offset = i * sizeof(uint64_t);
+            std::memcpy(bytes + offset, &word, std::min(sizeof(uint64_t), sizeof(T) - offset));
+        }
+    }
+
+    Slot m_slots[2];
+    std::atomic<unsigned> m_current; // Slot readers copy from
+    std::atomic<uint64_t> m_version;
+    std::mutex m_writerMutex;
+    T m_staging; // Writer-side value, only touched under m_writerMutex
+};
@@ -1,6 +1,7 @@
 // pages/api/brain-data.js - Simple robust solution
 import fs from 'fs';
 import path from 'path';
+import { readLiveState } from '../../utils/liveState';
 
 // Cache for the most recent successful read
 let lastSuccessfulData = null;
@@ -17,6 +18,12 @@ export default async function handler(req, res) {
       
       while (retryCount <= maxRetries) {
         try {
+          // Prefer the binary live state when the monitor writes it
+          const liveState = readLiveState();
+          if (liveState) {
+            return liveStateToBrainData(liveState);
+          }
+
           // Check if file exists
           if (!fs.existsSync(filePath)) {
             throw new Error('File not found');
@@ -90,6 +97,31 @@ export default async function handler(req, res) {
   }
 }
 
+// Same shape parseLogicData produces: only channels that have ever changed
+function liveStateToBrainData(liveState) {
+  return liveState.devices.map(device => {
+    const channels = device.channels
+      .filter(ch => ch.totalTransitions > 0)
+      .map(ch => ({
+        channel: ch.channel,
+        name: ch.name,
+        currentState: ch.currentState,
+        transitions: ch.transitions,
+        totalTransitions: ch.totalTransitions,
+        activityLevel: ch.activityLevel,
+        changed: ch.activityLevel > 0
+      }));
+    return {
+      id: device.id,
+      serialNumber: device.serialNumber || 'Unknown',
+      model: device.model || 'Unknown',
+      captureCount: device.captureCount,
+      channels,
+      isActive: channels.length > 0
+    };
+  });
+}
+
 // Function to parse the logic data file
 function parseLogicData(fileContent) {
   try {
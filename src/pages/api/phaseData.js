@@ -1,9 +1,30 @@
 // pages/api/phaseData.js
 import fs from 'fs';
 import path from 'path';
+import { readLiveStateOrNull } from '../../utils/liveState';
 
 export default function handler(req, res) {
   try {
+    // Prefer the binary live state when the monitor writes it and it parses
+    const liveState = readLiveStateOrNull();
+    if (liveState) {
+      const devices = liveState.devices.map(device => ({
+        id: device.id,
+        serial: device.serialNumber,
+        model: device.model,
+        captureCount: device.captureCount,
+        channels: device.phases.map((phase, ch) => ({
+          channel: ch,
+          name: device.channels[ch].name,
+          meanPhase: phase.meanPhase,
+          meanPhaseDeg: phase.meanPhase * 180 / Math.PI,
+          variance: phase.variance
+        }))
+      }));
+      res.setHeader('Cache-Control', 'no-store');
+      return res.status(200).json(devices);
+    }
+
     const filePath = path.join(process.cwd(), 'public', 'data', 'phase_data.txt');
     const raw = fs.readFileSync(filePath, 'utf8');
 
@@ -1,14 +1,34 @@
 import fs from 'fs';
 import path from 'path';
+import { readLiveStateOrNull } from '../../utils/liveState';
 
 export default function handler(req, res) {
   const filePath = path.join(process.cwd(), 'public', 'data', 'time_sliced_data.txt');
   
   try {
-    const data = fs.readFileSync(filePath, 'utf8');
     const devices = Array(12).fill().map(() => ({ slices: Array(5).fill([]) }));
-    
-    const lines = data.split('\n');
+
+    // Prefer the binary live state when the monitor writes it and it parses
+    const liveState = readLiveStateOrNull();
+    const lines = liveState ? [] : fs.readFileSync(filePath, 'utf8').split('\n');
+    if (liveState) {
+      for (const device of liveState.devices) {
+        if (device.id > 11) continue;
+        const slices = Array(5).fill().map(() => []);
+        // The live state carries no frequency, so the field is left out
+        device.slices.forEach((levels, channelId) => {
+          for (let sliceIndex = 0; sliceIndex < 5; sliceIndex++) {
+            slices[sliceIndex].push({
+              id: channelId,
+              activity: levels[sliceIndex] || 0,
+              phase: device.phases[channelId].meanPhase
+            });
+          }
+        });
+        devices[device.id].slices = slices;
+      }
+    }
+
     for (const line of lines) {
       if (!line.trim() || line.startsWith('#')) continue;
       
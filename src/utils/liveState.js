@@ -0,0 +1,137 @@
+// liveState.js - Reader for live_state.bin, the binary form of the text outputs
+// (layout in live_state.h). One read and a few DataView lookups instead of
+// parsing logic_data.txt / phase_data.txt / time_sliced_data.txt.
+import fs from 'fs';
+import path from 'path';
+
+export const LIVE_STATE_PATH = path.join(process.cwd(), 'public', 'data', 'live_state.bin');
+
+const MAGIC = 'LALIVEST';
+const VERSION = 1;
+const HEADER_SIZE = 72;
+const DEVICE_SIZE = 112;
+const CHANNEL_SIZE = 24;
+const PHASE_SIZE = 16;
+const DEVICE_CONNECTED = 1;
+const DEVICE_ACTIVE = 2;
+
+// Same names the monitor gives its channels
+export function channelName(channel) {
+  return channel < 16 ? `A${channel}` : `B${channel - 16}`;
+}
+
+function readString(buffer, offset, length) {
+  const end = buffer.indexOf(0, offset);
+  return buffer.toString('latin1', offset, end >= 0 && end < offset + length ? end : offset + length);
+}
+
+// Parse a live-state buffer; throws if it is not a complete version 1 file
+export function parseLiveState(buffer) {
+  if (buffer.length < HEADER_SIZE || buffer.toString('latin1', 0, 8) !== MAGIC) {
+    throw new Error('Not a live-state file');
+  }
+  const view = new DataView(buffer.buffer, buffer.byteOffset, buffer.byteLength);
+  const version = view.getUint32(8, true);
+  if (version !== VERSION) {
+    throw new Error(`Unsupported live-state version ${version}`);
+  }
+
+  const deviceCount = view.getUint32(16, true);
+  const channelsPerDevice = view.getUint32(20, true);
+  const phaseChannels = view.getUint32(24, true);
+  const maxSlices = view.getUint32(28, true);
+  const deviceTable = view.getUint32(32, true);
+  const channelTable = view.getUint32(36, true);
+  const sliceTable = view.getUint32(40, true);
+  const phaseTable = view.getUint32(44, true);
+  const fileSize = view.getUint32(48, true);
+  if (fileSize > buffer.length) {
+    throw new Error('Truncated live-state file');
+  }
+
+  const devices = [];
+  for (let entry = 0; entry < deviceCount; entry++) {
+    const d = deviceTable + entry * DEVICE_SIZE;
+    const flags = view.getUint32(d + 4, true);
+    const sliceCount = view.getUint32(d + 24, true);
+
+    const channels = [];
+    for (let ch = 0; ch < channelsPerDevice; ch++) {
+      const c = channelTable + (entry * channelsPerDevice + ch) * CHANNEL_SIZE;
+      channels.push({
+        channel: ch,
+        name: channelName(ch),
+        currentState: view.getUint32(c, true),
+        activityLevel: view.getUint32(c + 4, true),
+        transitions: view.getInt32(c + 8, true),
+        totalTransitions: view.getInt32(c + 12, true),
+        lastChangeMs: Number(view.getBigInt64(c + 16, true))
+      });
+    }
+
+    const slices = [];
+    const phases = [];
+    for (let ch = 0; ch < phaseChannels; ch++) {
+      const s = sliceTable + (entry * phaseChannels + ch) * maxSlices * 4;
+      const levels = [];
+      for (let i = 0; i < sliceCount; i++) {
+        levels.push(view.getFloat32(s + i * 4, true));
+      }
+      slices.push(levels);
+
+      const p = phaseTable + (entry * phaseChannels + ch) * PHASE_SIZE;
+      phases.push({
+        meanPhase: view.getFloat64(p, true),
+        variance: view.getFloat64(p + 8, true)
+      });
+    }
+
+    devices.push({
+      id: view.getUint32(d, true),
+      connected: (flags & DEVICE_CONNECTED) !== 0,
+      active: (flags & DEVICE_ACTIVE) !== 0,
+      captureCount: view.getUint32(d + 8, true),
+      errorsCount: view.getUint32(d + 12, true),
+      consecutiveErrors: view.getUint32(d + 16, true),
+      changedMask: view.getUint32(d + 20, true),
+      sliceCount,
+      frameSequence: Number(view.getBigUint64(d + 32, true)),
+      lastCaptureMs: Number(view.getBigInt64(d + 40, true)),
+      serialNumber: readString(buffer, d + 48, 32),
+      model: readString(buffer, d + 80, 32),
+      channels,
+      slices,
+      phases
+    });
+  }
+
+  return {
+    sequence: Number(view.getBigUint64(56, true)),
+    updatedMs: Number(view.getBigInt64(64, true)),
+    devices
+  };
+}
+
+// Read and parse the live-state file; null when the monitor does not write
+// one (older build, or text outputs only), so callers can use the text files
+export function readLiveState(filePath = LIVE_STATE_PATH) {
+  let buffer;
+  try {
+    buffer = fs.readFileSync(filePath);
+  } catch (error) {
+    if (error.code === 'ENOENT') return null;
+    throw error;
+  }
+  return parseLiveState(buffer);
+}
+
+// readLiveState for callers that can fall back to the text files: a corrupt
+// or unreadable live-state file is logged and treated like a missing one
+export function readLiveStateOrNull(filePath = LIVE_STATE_PATH) {
+  try {
+    return readLiveState(filePath);
+  } catch (error) {
+    console.warn(`Ignoring live state ${filePath}: ${error.message}`);
+    return null;
+  }
+}
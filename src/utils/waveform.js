@@ -0,0 +1,40 @@
+// waveform.js - Zoomable channel waveforms from the monitor's push server
+// (/waveform, see push_server.h). Each request returns at most `buckets`
+// min/max buckets for the range, so any zoom level costs bounded bytes.
+
+export const PUSH_PORT = Number(process.env.NEXT_PUBLIC_PUSH_PORT || 0);
+
+// Decode a /waveform response into per-bucket levels
+export function parseWaveform(json) {
+  const buckets = [];
+  for (let i = 0; i < json.flags.length; i++) {
+    const flags = json.flags.charCodeAt(i) - 48;
+    const start = json.start + i * json.bucketSamples;
+    buckets.push({
+      start,
+      end: Math.min(start + json.bucketSamples, json.samples),
+      high: (flags & 1) !== 0,
+      low: (flags & 2) !== 0,
+      toggles: json.toggles[i]
+    });
+  }
+  return {
+    device: json.device,
+    channel: json.channel,
+    sequence: json.seq,
+    samples: json.samples,
+    bucketSamples: json.bucketSamples,
+    buckets
+  };
+}
+
+// Fetch samples [start, end) of one channel of the latest frame; null when
+// the push server is not enabled or has no frame for that device yet
+export async function fetchWaveform(device, channel, { start = 0, end, buckets = 1024, port = PUSH_PORT } = {}) {
+  if (!port) return null;
+  const params = new URLSearchParams({ device, channel, start, buckets });
+  if (end !== undefined) params.set('end', end);
+  const response = await fetch(`http://127.0.0.1:${port}/waveform?${params}`);
+  if (!response.ok) return null;
+  return parseWaveform(await response.json());
+}
@@ -0,0 +1,362 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+
+// Steps a frame goes through, timed separately so builds can be compared
+// stage by stage on the same input. The WRITE_ stages are the exporter's
+// file writers, which run once per export rather than once per frame.
+enum class PipelineStage
+{
+    ARM,     // Start the capture on the device
+    WAIT,    // Wait for the capture to complete
+    READ,    // Copy the samples into a frame
+    ANALYZE, // Transition counting and per-channel state
+    PHASE,   // Phase analysis of the probe channels
+    EXPORT,  // Hand-off of the results to the export stage
+    FRAME,   // processData as a whole
+    WRITE_PHASE,      // phase_data.txt
+    WRITE_SLICES,     // time_sliced_data.txt
+    WRITE_MONITOR,    // logic_data.txt
+    WRITE_LIVE_STATE, // live_state.bin
+    COUNT
+};
+
+inline const char *getPipelineStageName(PipelineStage stage)
+{
+    switch (stage)
+    {
+    case PipelineStage::ARM:
+        return "arm";
+    case PipelineStage::WAIT:
+        return "wait";
+    case PipelineStage::READ:
+        return "read";
+    case PipelineStage::ANALYZE:
+        return "analyze";
+    case PipelineStage::PHASE:
+        return "phase";
+    case PipelineStage::EXPORT:
+        return "export";
+    case PipelineStage::FRAME:
+        return "frame";
+    case PipelineStage::WRITE_PHASE:
+        return "w.phase";
+    case PipelineStage::WRITE_SLICES:
+        return "w.slices";
+    case PipelineStage::WRITE_MONITOR:
+        return "w.logic";
+    case PipelineStage::WRITE_LIVE_STATE:
+        return "w.live";
+    default:
+        return "?";
+    }
+}
+
+// Latency distribution with log-linear buckets: every power of two of
+// nanoseconds is split into SUB_BUCKETS linear steps, so percentiles are
+// within 1/SUB_BUCKETS of the true value from nanoseconds up to minutes.
+class LatencyHistogram
+{
+public:
+    enum
+    {
+        SUB_BUCKET_BITS = 3,
+        SUB_BUCKETS = 1 << SUB_BUCKET_BITS,
+        OCTAVES = 40, // 2^40 ns is about 18 minutes
+        BUCKETS = OCTAVES * SUB_BUCKETS
+    };
+
+    void record(uint64_t ns)
+    {
+        m_buckets[bucketFor(ns)]++;
+        m_count++;
+        m_totalNs += ns;
+        m_minNs = m_count == 1 ? ns : std::min(m_minNs, ns);
+        m_maxNs = std::max(m_maxNs, ns);
+    }
+
+    void merge(const LatencyHistogram &other)
+    {
+        if (other.m_count == 0)
+            return;
+        for (size_t i = 0; i < m_buckets.size(); i++)
+            m_buckets[i] += other.m_buckets[i];
+        m_minNs = m_count == 0 ? other.m_minNs : std::min(m_minNs, other.m_minNs);
+        m_maxNs = std::max(m_maxNs, other.m_maxNs);
+        m_count += other.m_count;
+        m_totalNs += other.m_totalNs;
+    }
+
+    uint64_t count() const
+    {
+        return m_count;
+    }
+
+    double meanUs() const
+    {
+        return m_count ? m_totalNs / 1000.0 / m_count : 0.0;
+    }
+
+    double minUs() const
+    {
+        return m_minNs / 1000.0;
+    }
+
+    double maxUs() const
+    {
+        return m_maxNs / 1000.0;
+    }
+
+    // Upper bound of the bucket holding the given quantile, capped at the maximum seen
+    double percentileUs(double quantile) const
+    {
+        if (m_count == 0)
+            return 0.0;
+        const double target = quantile * static_cast<double>(m_count);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < m_buckets.size(); i++)
+        {
+            seen += m_buckets[i];
+            if (seen > 0 && static_cast<double>(seen) >= target)
+                return std::min(bucketUpperNs(i), m_maxNs) / 1000.0;
+        }
+        return maxUs();
+    }
+
+private:
+    friend class StageRecorder;
+
+    // Values below SUB_BUCKETS ns map linearly; above that the top
+    // SUB_BUCKET_BITS bits after the leading one pick the sub-bucket
+    static size_t bucketFor(uint64_t ns)
+    {
+        if (ns < SUB_BUCKETS)
+            return static_cast<size_t>(ns);
+        int msb = 63;
+        while (!(ns >> msb))
+            msb--;
+        const int octave = msb - SUB_BUCKET_BITS + 1;
+        const size_t sub = static_cast<size_t>((ns >> (msb - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1));
+        return std::min<size_t>(static_cast<size_t>(octave) * SUB_BUCKETS + sub, BUCKETS - 1);
+    }
+
+    static uint64_t bucketUpperNs(size_t bucket)
+    {
+        if (bucket < SUB_BUCKETS)
+            return bucket + 1;
+        const int octave = static_cast<int>(bucket / SUB_BUCKETS);
+        const uint64_t sub = bucket % SUB_BUCKETS;
+        const int shift = octave - 1;
+        return ((SUB_BUCKETS + sub + 1) << shift);
+    }
+
+    std::array<uint64_t, BUCKETS> m_buckets{};
+    uint64_t m_count = 0;
+    uint64_t m_totalNs = 0;
+    uint64_t m_minNs = 0;
+    uint64_t m_maxNs = 0;
+};
+
+// Latency histogram of one stage, written by a single thread and read by
+// any. The writer bumps plain relaxed atomics (a load and a store, no
+// read-modify-write), so recording costs about as much as an unsynchronised
+// counter; readers copy the counters out and may see a record half applied,
+// which is harmless for statistics. A reset is a new generation: the writer
+// clears the counters itself on its next record, and readers treat a stage
+// from an older generation as empty.
+class StageRecorder
+{
+public:
+    StageRecorder() : m_generation(0)
+    {
+        clear();
+    }
+
+    void record(uint64_t ns, unsigned generation)
+    {
+        if (m_generation.load(std::memory_order_relaxed) != generation)
+        {
+            clear();
+            m_generation.store(generation, std::memory_order_release);
+        }
+        bump(m_buckets[LatencyHistogram::bucketFor(ns)], 1);
+        const uint64_t count = m_count.load(std::memory_order_relaxed) + 1;
+        m_count.store(count, std::memory_order_relaxed);
+        bump(m_totalNs, ns);
+        if (count == 1 || ns < m_minNs.load(std::memory_order_relaxed))
+            m_minNs.store(ns, std::memory_order_relaxed);
+        if (ns > m_maxNs.load(std::memory_order_relaxed))
+            m_maxNs.store(ns, std::memory_order_relaxed);
+    }
+
+    void read(unsigned generation, LatencyHistogram &out) const
+    {
+        out = LatencyHistogram();
+        if (m_generation.load(std::memory_order_acquire) != generation)
+            return;
+        for (size_t i = 0; i < out.m_buckets.size(); i++)
+            out.m_buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+        out.m_count = m_count.load(std::memory_order_relaxed);
+        out.m_totalNs = m_totalNs.load(std::memory_order_relaxed);
+        out.m_minNs = m_minNs.load(std::memory_order_relaxed);
+        out.m_maxNs = m_maxNs.load(std::memory_order_relaxed);
+    }
+
+private:
+    static void bump(std::atomic<uint64_t> &counter, uint64_t amount)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    void clear()
+    {
+        for (std::atomic<uint64_t> &bucket : m_buckets)
+            bucket.store(0, std::memory_order_relaxed);
+        m_count.store(0, std::memory_order_relaxed);
+        m_totalNs.store(0, std::memory_order_relaxed);
+        m_minNs.store(0, std::memory_order_relaxed);
+        m_maxNs.store(0, std::memory_order_relaxed);
+    }
+
+    std::array<std::atomic<uint64_t>, LatencyHistogram::BUCKETS> m_buckets;
+    std::atomic<uint64_t> m_count;
+    std::atomic<uint64_t> m_totalNs;
+    std::atomic<uint64_t> m_minNs;
+    std::atomic<uint64_t> m_maxNs;
+    std::atomic<unsigned> m_generation;
+};
+
+// Per-device stage latencies and frame throughput. Each stage is recorded
+// by one thread only (capture stages by the capture thread, the rest by the
+// analysis thread, WRITE_ stages by the exporter), and frameDone() by the
+// analysis thread, so recording takes no lock and can stay on in
+// production; snapshot() aggregates on the reader's side.
+class PipelineStats
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    PipelineStats() : m_generation(0), m_frameGeneration(0), m_frames(0), m_samples(0), m_firstFrame(0), m_lastFrame(0) {}
+
+    void record(PipelineStage stage, Clock::duration elapsed)
+    {
+        const long long ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        m_stages[static_cast<size_t>(stage)].record(ns > 0 ? static_cast<uint64_t>(ns) : 0,
+                                                    m_generation.load(std::memory_order_relaxed));
+    }
+
+    // Count a fully processed frame of sampleCount samples
+    void frameDone(size_t sampleCount)
+    {
+        const Clock::rep now = Clock::now().time_since_epoch().count();
+        const unsigned generation = m_generation.load(std::memory_order_relaxed);
+        uint64_t frames = m_frames.load(std::memory_order_relaxed);
+        uint64_t samples = m_samples.load(std::memory_order_relaxed);
+        if (m_frameGeneration.load(std::memory_order_relaxed) != generation)
+        {
+            frames = 0;
+            samples = 0;
+        }
+        if (frames == 0)
+            m_firstFrame.store(now, std::memory_order_relaxed);
+        m_lastFrame.store(now, std::memory_order_relaxed);
+        m_frames.store(frames + 1, std::memory_order_relaxed);
+        m_samples.store(samples + sampleCount, std::memory_order_relaxed);
+        m_frameGeneration.store(generation, std::memory_order_release);
+    }
+
+    // Forget everything recorded so far; the writers clear their own
+    // counters on their next record
+    void reset()
+    {
+        m_generation.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    struct Snapshot
+    {
+        std::array<LatencyHistogram, static_cast<size_t>(PipelineStage::COUNT)> stages;
+        uint64_t frames = 0;
+        uint64_t samples = 0;
+        Clock::time_point firstFrame;
+        Clock::time_point lastFrame;
+
+        double seconds() const
+        {
+            return std::chrono::duration<double>(lastFrame - firstFrame).count();
+        }
+
+        // Frames per second between the first and the last processed frame
+        double framesPerSecond() const
+        {
+            return frames > 1 && seconds() > 0.0 ? (frames - 1) / seconds() : 0.0;
+        }
+
+        // Samples per second over the same span, leaving out the first
+        // frame's samples like framesPerSecond leaves out the first frame
+        double samplesPerSecond() const
+        {
+            return frames > 1 && seconds() > 0.0 ? samples * (frames - 1.0) / frames / seconds() : 0.0;
+        }
+
+        void merge(const Snapshot &other)
+        {
+            for (size_t i = 0; i < stages.size(); i++)
+                stages[i].merge(other.stages[i]);
+            if (other.frames == 0)
+                return;
+            firstFrame = frames == 0 ? other.firstFrame : std::min(firstFrame, other.firstFrame);
+            lastFrame = frames == 0 ? other.lastFrame : std::max(lastFrame, other.lastFrame);
+            frames += other.frames;
+            samples += other.samples;
+        }
+    };
+
+    Snapshot snapshot() const
+    {
+        const unsigned generation = m_generation.load(std::memory_order_relaxed);
+        Snapshot result;
+        for (size_t i = 0; i < result.stages.size(); i++)
+            m_stages[i].read(generation, result.stages[i]);
+        if (m_frameGeneration.load(std::memory_order_acquire) == generation)
+        {
+            result.frames = m_frames.load(std::memory_order_relaxed);
+            result.samples = m_samples.load(std::memory_order_relaxed);
+            result.firstFrame = Clock::time_point(Clock::duration(m_firstFrame.load(std::memory_order_relaxed)));
+            result.lastFrame = Clock::time_point(Clock::duration(m_lastFrame.load(std::memory_order_relaxed)));
+        }
+        return result;
+    }
+
+private:
+    std::array<StageRecorder, static_cast<size_t>(PipelineStage::COUNT)> m_stages;
+    std::atomic<unsigned> m_generation;
+    std::atomic<unsigned> m_frameGeneration; // Generation the frame counters belong to
+    std::atomic<uint64_t> m_frames;
+    std::atomic<uint64_t> m_samples;
+    std::atomic<Clock::rep> m_firstFrame;
+    std::atomic<Clock::rep> m_lastFrame;
+};
+
+// Times the enclosing scope into one stage
+class StageTimer
+{
+public:
+    StageTimer(PipelineStats &stats, PipelineStage stage)
+        : m_stats(stats), m_stage(stage), m_start(PipelineStats::Clock::now())
+    {
+    }
+
+    ~StageTimer()
+    {
+        m_stats.record(m_stage, PipelineStats::Clock::now() - m_start);
+    }
+
+private:
+    PipelineStats &m_stats;
+    PipelineStage m_stage;
+    PipelineStats::Clock::time_point m_start;
+};
@@ -0,0 +1,495 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <cctype>
+#include <string>
+#include <vector>
+#include <array>
+#include <fstream>
+#include <chrono>
+#include <algorithm>
+#include "capture_backend.h"
+#include "bitsliced_frame.h"
+
+// Signal produced on one synthetic channel
+struct SyntheticChannel
+{
+    double frequencyHz = 0.0; // Square wave frequency, 0 = constant low
+    double dutyCycle = 0.5;   // High fraction of each period
+    double phase = 0.0;       // Offset of the first rising edge, in periods
+    double burstOnMs = 0.0;   // Length of a burst, 0 = wave runs continuously
+    double burstOffMs = 0.0;  // Silence between bursts
+    double jitterNs = 0.0;    // Peak random displacement of each edge
+    double noise = 0.0;       // Probability that a sample is flipped (single-sample glitch)
+};
+
+// Deterministic signal generator standing in for a logic analyzer.
+// Each channel is a square wave with optional burst gating, edge jitter and
+// glitch noise; the same seed, spec and capture sequence always produce the
+// same samples, so analysis runs on it are reproducible. Captures follow each
+// other on a continuous timeline and, with realtime enabled, take as long as
+// the configured rate and depth would on hardware.
+//
+// The spec file given to open() holds key=value lines; missing keys keep the
+// defaults chosen per device and channel:
+//   seed=1                 realtime=1            devices=64
+//   ch*.noise=1e-6         ch3.freq=125000       dev2.ch3.duty=0.25
+// Channel keys: freq, duty, phase, burst_on_ms, burst_off_ms, jitter_ns, noise.
+class SyntheticBackend : public CaptureBackend
+{
+public:
+    enum
+    {
+        MAX_DEVICES = 64 // Virtual devices a spec can ask for
+    };
+
+    SyntheticBackend()
+        : m_seed(1), m_realtime(true), m_deviceCount(MAX_DEVICES), m_deviceIndex(0), m_connected(false),
+          m_rateCode(0), m_depth(0), m_triggerEnabled(false), m_triggerChannel(0), m_triggerRising(true),
+          m_preTrigger(50), m_armed(false), m_timeline(0), m_frameIndex(0)
+    {
+    }
+
+    const char *name() const
+    {
+        return "synthetic";
+    }
+
+    // A missing spec file is not an error: every channel gets its default signal
+    bool open(const std::string &specPath)
+    {
+        m_specPath = specPath;
+        return true;
+    }
+
+    bool connect(unsigned short deviceIndex)
+    {
+        m_deviceIndex = deviceIndex;
+        loadSpec();
+        if (deviceIndex >= m_deviceCount)
+        {
+            m_lastError = "No synthetic device at index " + std::to_string(deviceIndex);
+            return false;
+        }
+        m_connected = true;
+        return true;
+    }
+
+    bool initialize()
+    {
+        if (!m_connected)
+        {
+            m_lastError = "Synthetic device not connected";
+            return false;
+        }
+        m_timeline = 0;
+        m_frameIndex = 0;
+        m_armed = false;
+        return true;
+    }
+
+    bool setSampleRate(unsigned short rateCode)
+    {
+        if (sampleRateFromCode(rateCode) == 0)
+        {
+            m_lastError = "Sample rate code " + std::to_string(rateCode) + " has no known rate to simulate";
+            return false;
+        }
+        m_rateCode = rateCode;
+        return true;
+    }
+
+    bool setSampleDepth(unsigned long depth)
+    {
+        m_depth = depth;
+        return true;
+    }
+
+    bool setVoltageThreshold(double threshold)
+    {
+        (void)threshold; // Generated levels are already logic levels
+        return true;
+    }
+
+    bool configureTrigger(bool enabled, unsigned short channel, bool risingEdge)
+    {
+        if (channel >= 32)
+        {
+            m_lastError = "Invalid trigger channel";
+            return false;
+        }
+        m_triggerEnabled = enabled;
+        m_triggerChannel = channel;
+        m_triggerRising = risingEdge;
+        return true;
+    }
+
+    bool setPreTrigger(unsigned short percentage)
+    {
+        m_preTrigger = std::min<unsigned short>(percentage, 100);
+        return true;
+    }
+
+    bool startCapture()
+    {
+        if (!m_connected)
+        {
+            m_lastError = "Synthetic device not connected";
+            return false;
+        }
+        m_armed = true;
+        m_armTime = std::chrono::steady_clock::now();
+        return true;
+    }
+
+    int readStatus()
+    {
+        if (!m_armed)
+        {
+            m_lastError = "No capture armed";
+            return -1;
+        }
+        if (!m_realtime)
+        {
+            return 1;
+        }
+        const double captureSeconds = static_cast<double>(m_depth) / sampleRateFromCode(m_rateCode);
+        const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_armTime).count();
+        return elapsed >= captureSeconds ? 1 : 0;
+    }
+
+    bool readSamples(uint32_t *samples, unsigned long sampleCount, unsigned long &samplesRead)
+    {
+        samplesRead = 0;
+        if (!m_armed)
+        {
+            m_lastError = "No capture armed";
+            return false;
+        }
+        m_armed = false;
+
+        const double rate = static_cast<double>(sampleRateFromCode(m_rateCode));
+        if (m_triggerEnabled)
+        {
+            alignToTrigger(rate, sampleCount);
+        }
+        generate(rate, samples, sampleCount);
+
+        // The next capture starts where this one ended
+        m_timeline += sampleCount;
+        m_frameIndex++;
+        samplesRead = sampleCount;
+        return true;
+    }
+
+    // Without realtime pacing a capture is ready the moment it is armed
+    bool isPaced() const
+    {
+        return m_realtime;
+    }
+
+    std::string serialNumber() const
+    {
+        return "SIM" + std::to_string(1000 + m_deviceIndex);
+    }
+
+    std::string model() const
+    {
+        return "Synthetic";
+    }
+
+    std::string firmwareVersion() const
+    {
+        return "sim-1";
+    }
+
+    const SyntheticChannel &channel(int ch) const
+    {
+        return m_channels[ch];
+    }
+
+private:
+    // Default signals: frequencies spread per device and channel, every
+    // fourth channel bursting, a little jitter and noise everywhere
+    void setDefaults()
+    {
+        for (int ch = 0; ch < 32; ch++)
+        {
+            SyntheticChannel &c = m_channels[ch];
+            c = SyntheticChannel();
+            c.frequencyHz = 1000.0 * (ch + 1) * (m_deviceIndex + 1);
+            c.phase = ch / 32.0;
+            if (ch % 4 == 3)
+            {
+                c.burstOnMs = 0.2;
+                c.burstOffMs = 0.3;
+            }
+            c.jitterNs = 0.01 * 1e9 / c.frequencyHz;
+            c.noise = 1e-7;
+        }
+    }
+
+    void loadSpec()
+    {
+        setDefaults();
+        if (m_specPath.empty())
+            return;
+
+        std::ifstream spec(m_specPath);
+        if (!spec.is_open())
+            return;
+
+        const std::string devicePrefix = "dev" + std::to_string(m_deviceIndex) + ".";
+        std::string line;
+        while (std::getline(spec, line))
+        {
+            if (line.empty() || line[0] == '#')
+                continue;
+            size_t equalsPos = line.find('=');
+            if (equalsPos == std::string::npos)
+                continue;
+            std::string key = line.substr(0, equalsPos);
+            std::string value = line.substr(equalsPos + 1);
+
+            // Keys for another device are skipped, keys for this one lose their prefix
+            if (key.size() > 3 && key.compare(0, 3, "dev") == 0 && isdigit(static_cast<unsigned char>(key[3])))
+            {
+                if (key.compare(0, devicePrefix.size(), devicePrefix) != 0)
+                    continue;
+                key = key.substr(devicePrefix.size());
+            }
+
+            try
+            {
+                if (key == "seed")
+                    m_seed = std::stoull(value);
+                else if (key == "realtime")
+                    m_realtime = (value == "1" || value == "true");
+                else if (key == "devices")
+                    m_deviceCount = std::min<int>(std::max(std::stoi(value), 1), MAX_DEVICES);
+                else if (key.compare(0, 2, "ch") == 0)
+                    applyChannelKey(key.substr(2), std::stod(value));
+            }
+            catch (...)
+            {
+                // Skip invalid values
+            }
+        }
+    }
+
+    // key is "<channel or *>.<name>"
+    void applyChannelKey(const std::string &key, double value)
+    {
+        size_t dotPos = key.find('.');
+        if (dotPos == std::string::npos)
+            return;
+        const std::string target = key.substr(0, dotPos);
+        const std::string name = key.substr(dotPos + 1);
+        int first = 0, last = 31;
+        if (target != "*")
+        {
+            first = last = std::stoi(target);
+            if (first < 0 || first > 31)
+                return;
+        }
+        for (int ch = first; ch <= last; ch++)
+        {
+            SyntheticChannel &c = m_channels[ch];
+            if (name == "freq")
+                c.frequencyHz = std::max(0.0, value);
+            else if (name == "duty")
+                c.dutyCycle = std::min(std::max(value, 0.0), 1.0);
+            else if (name == "phase")
+                c.phase = value;
+            else if (name == "burst_on_ms")
+                c.burstOnMs = std::max(0.0, value);
+            else if (name == "burst_off_ms")
+                c.burstOffMs = std::max(0.0, value);
+            else if (name == "jitter_ns")
+                c.jitterNs = std::max(0.0, value);
+            else if (name == "noise")
+                c.noise = std::min(std::max(value, 0.0), 1.0);
+        }
+    }
+
+    static uint64_t mix(uint64_t x)
+    {
+        // splitmix64 finalizer
+        x += 0x9E3779B97F4A7C15ULL;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+    }
+
+    // Uniform in [0, 1) from a hash value
+    static double unit(uint64_t x)
+    {
+        return static_cast<double>(x >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    uint64_t channelSeed(int ch) const
+    {
+        return mix(m_seed ^ mix((static_cast<uint64_t>(m_deviceIndex) << 8) | static_cast<uint64_t>(ch)));
+    }
+
+    // Calls emit(begin, end) for every high interval of a channel that
+    // overlaps [from, to), in order, on the absolute sample timeline
+    template <typename Emit>
+    void forEachPulse(int ch, double rate, double from, double to, Emit emit) const
+    {
+        const SyntheticChannel &c = m_channels[ch];
+        if (c.frequencyHz <= 0.0 || c.dutyCycle <= 0.0)
+            return;
+
+        const double period = std::max(2.0, rate / c.frequencyHz);
+        const double offset = c.phase * period;
+        const double jitter = c.jitterNs * 1e-9 * rate;
+        const double burstOn = c.burstOnMs * 1e-3 * rate;
+        const double burstPeriod = burstOn + c.burstOffMs * 1e-3 * rate;
+        const bool bursts = burstOn > 0.0 && burstPeriod > burstOn;
+        const uint64_t seed = channelSeed(ch);
+
+        for (int64_t k = static_cast<int64_t>(std::floor((from - offset) / period)) - 1;; k++)
+        {
+            const double start = offset + k * period;
+            if (start - jitter >= to)
+                break;
+
+            double rise = start;
+            double fall = start + c.dutyCycle * period;
+            if (jitter > 0.0)
+            {
+                const uint64_t h = mix(seed ^ static_cast<uint64_t>(k));
+                rise += (2.0 * unit(h) - 1.0) * jitter;
+                fall += (2.0 * unit(mix(h)) - 1.0) * jitter;
+            }
+            if (fall <= rise)
+                continue;
+
+            if (!bursts)
+            {
+                if (fall > from)
+                    emit(rise, fall);
+                continue;
+            }
+
+            // Keep only the part of the pulse inside burst windows
+            for (int64_t m = static_cast<int64_t>(std::floor(rise / burstPeriod));
+                 m * burstPeriod < fall; m++)
+            {
+                const double begin = std::max(rise, m * burstPeriod);
+                const double end = std::min(fall, m * burstPeriod + burstOn);
+                if (end > begin && end > from)
+                    emit(begin, end);
+            }
+        }
+    }
+
+    // Move the timeline forward so the next trigger edge lands at the
+    // pre-trigger position; free-runs when no edge shows up soon enough
+    void alignToTrigger(double rate, unsigned long sampleCount)
+    {
+        const double preSamples = sampleCount * (m_preTrigger / 100.0);
+        const double from = static_cast<double>(m_timeline) + preSamples;
+        const double limit = from + 16.0 * sampleCount;
+        double edge = -1.0;
+        forEachPulse(m_triggerChannel, rate, from, limit, [&](double begin, double end)
+                     {
+            const double candidate = m_triggerRising ? begin : end;
+            if (edge < 0.0 && candidate >= from && candidate < limit)
+                edge = candidate; });
+        if (edge >= 0.0)
+        {
+            m_timeline = static_cast<uint64_t>(std::ceil(edge - preSamples));
+        }
+    }
+
+    void generate(double rate, uint32_t *samples, unsigned long sampleCount)
+    {
+        const size_t words = (static_cast<size_t>(sampleCount) + 63) / 64;
+        m_bits.assign(32 * words, 0);
+
+        const double t0 = static_cast<double>(m_timeline);
+        const double t1 = t0 + sampleCount;
+        for (int ch = 0; ch < 32; ch++)
+        {
+            uint64_t *bits = m_bits.data() + ch * words;
+            forEachPulse(ch, rate, t0, t1, [&](double begin, double end)
+                         {
+                const double a = std::max(begin, t0) - t0;
+                const double b = std::min(end, t1) - t0;
+                if (b > a)
+                    setRange(bits, static_cast<size_t>(std::ceil(a)), static_cast<size_t>(std::ceil(b))); });
+            addNoise(ch, bits, sampleCount);
+        }
+
+        // Channel bitstreams back to one word per sample
+        BitSlicedFrame::packSamples(m_bits.data(), words, sampleCount, samples);
+    }
+
+    // Set bits [begin, end) of a bitstream
+    static void setRange(uint64_t *bits, size_t begin, size_t end)
+    {
+        if (begin >= end)
+            return;
+        const size_t first = begin >> 6;
+        const size_t last = (end - 1) >> 6;
+        const uint64_t headMask = ~0ULL << (begin & 63);
+        const uint64_t tailMask = ~0ULL >> (63 - ((end - 1) & 63));
+        if (first == last)
+        {
+            bits[first] |= headMask & tailMask;
+            return;
+        }
+        bits[first] |= headMask;
+        for (size_t k = first + 1; k < last; k++)
+        {
+            bits[k] = ~0ULL;
+        }
+        bits[last] |= tailMask;
+    }
+
+    // Flip isolated samples; gaps between glitches are drawn geometrically so
+    // the cost follows the number of glitches, not the number of samples
+    void addNoise(int ch, uint64_t *bits, unsigned long sampleCount) const
+    {
+        const double p = m_channels[ch].noise;
+        if (p <= 0.0)
+            return;
+        uint64_t state = mix(channelSeed(ch) ^ mix(m_frameIndex + 1));
+        const double logKeep = std::log1p(-std::min(p, 0.999999));
+        double position = -1.0;
+        while (true)
+        {
+            state = mix(state);
+            const double u = std::max(unit(state), 1e-300);
+            position += 1.0 + std::floor(std::log(u) / logKeep);
+            if (position >= sampleCount)
+                break;
+            const size_t index = static_cast<size_t>(position);
+            bits[index >> 6] ^= 1ULL << (index & 63);
+        }
+    }
+
+    std::string m_specPath;
+    uint64_t m_seed;
+    bool m_realtime;      // Make captures take as long as they would on hardware
+    int m_deviceCount;    // Devices that answer connect()
+    unsigned short m_deviceIndex;
+    bool m_connected;
+    std::array<SyntheticChannel, 32> m_channels;
+
+    unsigned short m_rateCode;
+    unsigned long m_depth;
+    bool m_triggerEnabled;
+    unsigned short m_triggerChannel;
+    bool m_triggerRising;
+    unsigned short m_preTrigger;
+
+    bool m_armed;
+    std::chrono::steady_clock::time_point m_armTime;
+    uint64_t m_timeline;   // Absolute sample index where the next capture starts
+    uint64_t m_frameIndex; // Captures read so far, seeds the noise
+    std::vector<uint64_t> m_bits; // Per-channel scratch bitstreams
+};
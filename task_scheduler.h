@@ -0,0 +1,629 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <new>
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <type_traits>
+#include <utility>
+#include <algorithm>
+#include <string>
+#include <chrono>
+#include "trace.h"
+#ifdef _WIN32
+#include <windows.h>
+#undef max
+#undef min
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// Type-erased void() closure. Closures up to INLINE_BYTES live inside the
+// task itself, so submitting them allocates nothing; larger ones fall back
+// to the heap.
+class SmallTask
+{
+public:
+    enum
+    {
+        INLINE_BYTES = 48
+    };
+
+    SmallTask() : m_ops(nullptr) {}
+
+    template <typename F, typename = typename std::enable_if<
+                              !std::is_same<typename std::decay<F>::type, SmallTask>::value>::type>
+    SmallTask(F &&function) : m_ops(nullptr)
+    {
+        typedef typename std::decay<F>::type Function;
+        emplace<Function>(std::forward<F>(function), std::integral_constant<bool, fitsInline<Function>()>());
+    }
+
+    SmallTask(SmallTask &&other) : m_ops(other.m_ops)
+    {
+        if (m_ops)
+        {
+            m_ops->relocate(&m_storage, &other.m_storage);
+            other.m_ops = nullptr;
+        }
+    }
+
+    SmallTask &operator=(SmallTask &&other)
+    {
+        if (this != &other)
+        {
+            reset();
+            m_ops = other.m_ops;
+            if (m_ops)
+            {
+                m_ops->relocate(&m_storage, &other.m_storage);
+                other.m_ops = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    SmallTask(const SmallTask &) = delete;
+    SmallTask &operator=(const SmallTask &) = delete;
+
+    ~SmallTask()
+    {
+        reset();
+    }
+
+    explicit operator bool() const
+    {
+        return m_ops != nullptr;
+    }
+
+    void operator()()
+    {
+        m_ops->invoke(&m_storage);
+    }
+
+    void reset()
+    {
+        if (m_ops)
+        {
+            m_ops->destroy(&m_storage);
+            m_ops = nullptr;
+        }
+    }
+
+    template <typename Function>
+    static constexpr bool fitsInline()
+    {
+        return sizeof(Function) <= INLINE_BYTES && alignof(Function) <= alignof(std::max_align_t) &&
+               std::is_nothrow_move_constructible<Function>::value;
+    }
+
+private:
+    struct Ops
+    {
+        void (*invoke)(void *);
+        void (*relocate)(void *destination, void *source); // Move into raw storage and destroy the source
+        void (*destroy)(void *);
+    };
+
+    template <typename Function>
+    struct InlineOps
+    {
+        static void invoke(void *storage)
+        {
+            (*static_cast<Function *>(storage))();
+        }
+        static void relocate(void *destination, void *source)
+        {
+            Function *from = static_cast<Function *>(source);
+            new (destination) Function(std::move(*from));
+            from->~Function();
+        }
+        static void destroy(void *storage)
+        {
+            static_cast<Function *>(storage)->~Function();
+        }
+        static const Ops ops;
+    };
+
+    template <typename Function>
+    struct HeapOps
+    {
+        static Function *&target(void *storage)
+        {
+            return *static_cast<Function **>(storage);
+        }
+        static void invoke(void *storage)
+        {
+            (*target(storage))();
+        }
+        static void relocate(void *destination, void *source)
+        {
+            new (destination) Function *(target(source));
+        }
+        static void destroy(void *storage)
+        {
+            delete target(storage);
+        }
+        static const Ops ops;
+    };
+
+    template <typename Function, typename F>
+    void emplace(F &&function, std::true_type)
+    {
+        new (&m_storage) Function(std::forward<F>(function));
+        m_ops = &InlineOps<Function>::ops;
+    }
+
+    template <typename Function, typename F>
+    void emplace(F &&function, std::false_type)
+    {
+        new (&m_storage) Function *(new Function(std::forward<F>(function)));
+        m_ops = &HeapOps<Function>::ops;
+    }
+
+    typename std::aligned_storage<INLINE_BYTES, alignof(std::max_align_t)>::type m_storage;
+    const Ops *m_ops;
+};
+
+template <typename Function>
+const SmallTask::Ops SmallTask::InlineOps<Function>::ops = {&invoke, &relocate, &destroy};
+
+template <typename Function>
+const SmallTask::Ops SmallTask::HeapOps<Function>::ops = {&invoke, &relocate, &destroy};
+
+// Test-and-test-and-set lock for the very short critical sections of a work queue
+class SpinLock
+{
+public:
+    SpinLock() : m_locked(false) {}
+
+    void lock()
+    {
+        int spins = 0;
+        while (m_locked.exchange(true, std::memory_order_acquire))
+        {
+            while (m_locked.load(std::memory_order_relaxed))
+            {
+                if (++spins > 64)
+                {
+                    std::this_thread::yield();
+                    spins = 0;
+                }
+            }
+        }
+    }
+
+    void unlock()
+    {
+        m_locked.store(false, std::memory_order_release);
+    }
+
+private:
+    std::atomic<bool> m_locked;
+};
+
+// Fixed-capacity double-ended task queue owned by one worker. The owner
+// pushes and pops at the back (newest first, cache-warm); thieves take from
+// the front (oldest first, usually the biggest remaining piece of work).
+class WorkQueue
+{
+public:
+    enum
+    {
+        CAPACITY = 256
+    };
+
+    WorkQueue() : m_tasks(CAPACITY), m_head(0), m_tail(0), m_size(0) {}
+
+    // false when full; the caller then runs the task itself
+    bool push(SmallTask &task)
+    {
+        std::lock_guard<SpinLock> lock(m_lock);
+        if (m_tail - m_head >= CAPACITY)
+        {
+            return false;
+        }
+        m_tasks[m_tail % CAPACITY] = std::move(task);
+        m_tail++;
+        m_size.store(m_tail - m_head, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(SmallTask &task)
+    {
+        if (empty())
+            return false;
+        std::lock_guard<SpinLock> lock(m_lock);
+        if (m_tail == m_head)
+        {
+            return false;
+        }
+        m_tail--;
+        task = std::move(m_tasks[m_tail % CAPACITY]);
+        m_size.store(m_tail - m_head, std::memory_order_release);
+        return true;
+    }
+
+    bool steal(SmallTask &task)
+    {
+        if (empty())
+            return false;
+        std::lock_guard<SpinLock> lock(m_lock);
+        if (m_tail == m_head)
+        {
+            return false;
+        }
+        task = std::move(m_tasks[m_head % CAPACITY]);
+        m_head++;
+        m_size.store(m_tail - m_head, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const
+    {
+        return m_size.load(std::memory_order_acquire) == 0;
+    }
+
+private:
+    SpinLock m_lock;
+    std::vector<SmallTask> m_tasks;
+    size_t m_head; // Next task to steal
+    size_t m_tail; // One past the newest task
+    std::atomic<size_t> m_size;
+};
+
+// Work-stealing scheduler for short compute tasks (phase analysis fan-out
+// and the like). Every worker has its own queue; tasks submitted from a
+// worker go to that worker's queue, tasks from other threads are spread
+// round-robin over the queues, and an idle worker steals from the others
+// before going to sleep. Threads waiting on a TaskGroup run queued tasks
+// instead of blocking, so nested fork/join cannot deadlock.
+// With zero threads every task runs inline on the submitting thread.
+class TaskScheduler
+{
+public:
+    struct Stats
+    {
+        uint64_t executed = 0; // Tasks run by workers or helping waiters
+        uint64_t stolen = 0;   // Tasks taken from another worker's queue
+        uint64_t inlined = 0;  // Tasks run by the submitter (no workers or queue full)
+    };
+
+    explicit TaskScheduler(unsigned threadCount, bool pinThreads = false)
+        : m_queues(threadCount), m_stop(false), m_queued(0), m_sleeping(0), m_nextQueue(0),
+          m_executed(0), m_stolen(0), m_inlined(0)
+    {
+        const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned i = 0; i < threadCount; i++)
+        {
+            m_queues[i].reset(new WorkQueue());
+        }
+        for (unsigned i = 0; i < threadCount; i++)
+        {
+            m_workers.emplace_back(&TaskScheduler::workerLoop, this, static_cast<int>(i));
+            if (pinThreads)
+            {
+                pinToCore(m_workers.back(), i % cores);
+            }
+        }
+    }
+
+    ~TaskScheduler()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_sleepMutex);
+            m_stop = true;
+        }
+        m_wake.notify_all();
+        for (std::thread &worker : m_workers)
+        {
+            worker.join();
+        }
+    }
+
+    unsigned threadCount() const
+    {
+        return static_cast<unsigned>(m_workers.size());
+    }
+
+    // Queue a fire-and-forget task
+    template <typename F>
+    void submit(F &&function)
+    {
+        SmallTask task(std::forward<F>(function));
+        if (!m_workers.empty())
+        {
+            const int self = currentWorker();
+            const size_t count = m_queues.size();
+            const size_t first = self >= 0 ? static_cast<size_t>(self) : m_nextQueue.fetch_add(1, std::memory_order_relaxed);
+            for (size_t attempt = 0; attempt < count; attempt++)
+            {
+                if (m_queues[(first + attempt) % count]->push(task))
+                {
+                    m_queued.fetch_add(1);
+                    if (m_sleeping.load() > 0)
+                    {
+                        std::lock_guard<std::mutex> lock(m_sleepMutex);
+                        m_wake.notify_one();
+                    }
+                    return;
+                }
+            }
+        }
+        m_inlined.fetch_add(1, std::memory_order_relaxed);
+        task();
+    }
+
+    // Run one queued task on the calling thread; false if there was none
+    bool runPending()
+    {
+        SmallTask task;
+        if (!take(currentWorker(), task))
+        {
+            return false;
+        }
+        execute(task);
+        return true;
+    }
+
+    // Call body(i) for every i in [begin, end), in chunks of grain indices;
+    // the calling thread takes part and returns when all are done
+    template <typename Body>
+    void parallelFor(int begin, int end, Body body, int grain = 1);
+
+    Stats stats() const
+    {
+        Stats result;
+        result.executed = m_executed.load(std::memory_order_relaxed);
+        result.stolen = m_stolen.load(std::memory_order_relaxed);
+        result.inlined = m_inlined.load(std::memory_order_relaxed);
+        return result;
+    }
+
+private:
+    // Index of the calling thread among this scheduler's workers, -1 for other threads
+    int currentWorker() const
+    {
+        const WorkerIdentity &identity = workerIdentity();
+        return identity.scheduler == this ? identity.index : -1;
+    }
+
+    struct WorkerIdentity
+    {
+        const TaskScheduler *scheduler = nullptr;
+        int index = -1;
+    };
+
+    static WorkerIdentity &workerIdentity()
+    {
+        static thread_local WorkerIdentity identity;
+        return identity;
+    }
+
+    // Own queue first, then steal starting at the next worker along
+    bool take(int self, SmallTask &task)
+    {
+        const size_t count = m_queues.size();
+        if (count == 0)
+            return false;
+        if (self >= 0 && m_queues[self]->pop(task))
+        {
+            m_queued.fetch_sub(1);
+            return true;
+        }
+        const size_t start = self >= 0 ? static_cast<size_t>(self) + 1 : m_nextQueue.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < count; i++)
+        {
+            const size_t victim = (start + i) % count;
+            if (static_cast<int>(victim) != self && m_queues[victim]->steal(task))
+            {
+                m_queued.fetch_sub(1);
+                if (self >= 0)
+                    m_stolen.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void execute(SmallTask &task)
+    {
+        TraceScope trace("task", "pool");
+        task();
+        task.reset();
+        m_executed.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void workerLoop(int index)
+    {
+        WorkerIdentity &identity = workerIdentity();
+        identity.scheduler = this;
+        identity.index = index;
+        TraceRecorder::instance().setThreadName("pool worker " + std::to_string(index));
+
+        const int SPIN_ROUNDS = 64; // Steal attempts before going to sleep
+        SmallTask task;
+        while (true)
+        {
+            bool found = false;
+            for (int round = 0; round < SPIN_ROUNDS && !found; round++)
+            {
+                found = take(index, task);
+                if (!found)
+                    std::this_thread::yield();
+            }
+            if (found)
+            {
+                execute(task);
+                continue;
+            }
+
+            // The sleeping count is raised before m_queued is checked and
+            // submit() raises m_queued before checking the sleeping count, so
+            // a task queued at this moment always wakes someone
+            // Traced as "idle" so pool starvation shows on the timeline
+            TraceScope idle("idle", "pool");
+            std::unique_lock<std::mutex> lock(m_sleepMutex);
+            m_sleeping.fetch_add(1);
+            m_wake.wait(lock, [this]
+                        { return m_stop || m_queued.load() > 0; });
+            m_sleeping.fetch_sub(1);
+            idle.end();
+            if (m_stop && m_queued.load() == 0)
+            {
+                return;
+            }
+        }
+    }
+
+    static void pinToCore(std::thread &thread, unsigned core)
+    {
+#ifdef _WIN32
+        SetThreadAffinityMask(thread.native_handle(), DWORD_PTR(1) << (core % (8 * sizeof(DWORD_PTR))));
+#else
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(core, &set);
+        pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+#endif
+    }
+
+    std::vector<std::unique_ptr<WorkQueue>> m_queues;
+    std::vector<std::thread> m_workers;
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wake;
+    bool m_stop;
+    std::atomic<int> m_queued;   // Tasks sitting in any queue
+    std::atomic<int> m_sleeping; // Workers waiting on m_wake
+    std::atomic<size_t> m_nextQueue;
+    std::atomic<uint64_t> m_executed;
+    std::atomic<uint64_t> m_stolen;
+    std::atomic<uint64_t> m_inlined;
+};
+
+// Fork/join scope: run() forks tasks onto the scheduler, wait() joins them,
+// helping with queued work meanwhile. Once there is nothing left to help
+// with, the waiter spins briefly and then sleeps until the last task is
+// done. The first exception thrown by a task is rethrown from wait().
+class TaskGroup
+{
+public:
+    explicit TaskGroup(TaskScheduler &scheduler) : m_scheduler(scheduler), m_pending(0) {}
+
+    ~TaskGroup()
+    {
+        join();
+    }
+
+    template <typename F>
+    void run(F function)
+    {
+        m_pending.fetch_add(1, std::memory_order_relaxed);
+        m_scheduler.submit([this, function]() mutable
+                           {
+            try
+            {
+                function();
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(m_errorMutex);
+                if (!m_error)
+                    m_error = std::current_exception();
+            }
+            finishTask(); });
+    }
+
+    void wait()
+    {
+        join();
+        std::lock_guard<std::mutex> lock(m_errorMutex);
+        if (m_error)
+        {
+            std::exception_ptr error = m_error;
+            m_error = nullptr;
+            std::rethrow_exception(error);
+        }
+    }
+
+private:
+    // Tasks other than the last only decrement the count. The last one does
+    // it under m_doneMutex, so a sleeping waiter cannot miss the wake-up and
+    // join() can tell when the task is done with the group.
+    void finishTask()
+    {
+        int pending = m_pending.load(std::memory_order_relaxed);
+        while (pending > 1)
+        {
+            if (m_pending.compare_exchange_weak(pending, pending - 1, std::memory_order_acq_rel))
+                return;
+        }
+        std::lock_guard<std::mutex> lock(m_doneMutex);
+        m_pending.fetch_sub(1, std::memory_order_acq_rel);
+        m_done.notify_all();
+    }
+
+    void join()
+    {
+        const int SPIN_ROUNDS = 64; // Empty polls before going to sleep
+        int idleRounds = 0;
+        while (m_pending.load(std::memory_order_acquire) != 0)
+        {
+            if (m_scheduler.runPending())
+            {
+                idleRounds = 0;
+            }
+            else if (++idleRounds < SPIN_ROUNDS)
+            {
+                std::this_thread::yield();
+            }
+            else
+            {
+                // Nobody wakes this thread for tasks queued meanwhile (nested
+                // groups), so it wakes now and then to look for them
+                std::unique_lock<std::mutex> lock(m_doneMutex);
+                m_done.wait_for(lock, std::chrono::milliseconds(1), [this]
+                                { return m_pending.load(std::memory_order_acquire) == 0; });
+                idleRounds = SPIN_ROUNDS - 1;
+            }
+        }
+        // The last task may still be inside finishTask()
+        std::lock_guard<std::mutex> lock(m_doneMutex);
+    }
+
+    TaskScheduler &m_scheduler;
+    std::atomic<int> m_pending;
+    std::mutex m_doneMutex;
+    std::condition_variable m_done;
+    std::mutex m_errorMutex;
+    std::exception_ptr m_error;
+};
+
+template <typename Body>
+void TaskScheduler::parallelFor(int begin, int end, Body body, int grain)
+{
+    if (end <= begin)
+        return;
+    grain = std::max(1, grain);
+
+    TaskGroup group(*this);
+    for (int chunk = begin + grain; chunk < end; chunk += grain)
+    {
+        const int chunkEnd = std::min(chunk + grain, end);
+        group.run([&body, chunk, chunkEnd]()
+                  {
+            for (int i = chunk; i < chunkEnd; i++)
+                body(i); });
+    }
+    for (int i = begin; i < std::min(begin + grain, end); i++)
+    {
+        body(i);
+    }
+    group.wait();
+}
@@ -0,0 +1,236 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <fstream>
+
+// Opt-in timeline tracing in the Chrome trace / Perfetto JSON format.
+// Every thread records complete events (name, start, duration) into its own
+// ring of EVENTS_PER_THREAD slots, so recording takes no lock and a long run
+// keeps the most recent events of each thread. dump() can run at any time
+// from any thread: each slot carries a sequence word (odd while written) and
+// the dump skips slots that change under it. Buffers outlive their threads,
+// so a dump on exit still shows threads that have already finished.
+//
+// While tracing is off a TraceScope costs one relaxed load. Event names and
+// categories must be string literals; only the pointers are stored.
+class TraceRecorder
+{
+public:
+    enum
+    {
+        EVENTS_PER_THREAD = 1 << 15
+    };
+
+    static TraceRecorder &instance()
+    {
+        static TraceRecorder recorder;
+        return recorder;
+    }
+
+    static bool enabled()
+    {
+        return instance().m_enabled.load(std::memory_order_relaxed);
+    }
+
+    void enable()
+    {
+        m_enabled.store(true, std::memory_order_relaxed);
+    }
+
+    // Nanoseconds since the recorder was created
+    int64_t now() const
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_origin).count();
+    }
+
+    // Label the calling thread in the timeline
+    void setThreadName(const std::string &name)
+    {
+        if (!enabled())
+            return;
+        ThreadBuffer &buffer = threadBuffer();
+        std::lock_guard<std::mutex> lock(m_registryMutex);
+        buffer.name = name;
+    }
+
+    // argName (a literal too) labels arg; nullptr records no argument
+    void record(const char *name, const char *category, int64_t startNs, int64_t endNs,
+                const char *argName = nullptr, int64_t arg = 0)
+    {
+        ThreadBuffer &buffer = threadBuffer();
+        const uint64_t n = buffer.written.load(std::memory_order_relaxed);
+        Slot &slot = buffer.slots[n % EVENTS_PER_THREAD];
+        slot.sequence.store(2 * n + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.name.store(reinterpret_cast<uintptr_t>(name), std::memory_order_relaxed);
+        slot.category.store(reinterpret_cast<uintptr_t>(category), std::memory_order_relaxed);
+        slot.startNs.store(startNs, std::memory_order_relaxed);
+        slot.durationNs.store(endNs - startNs, std::memory_order_relaxed);
+        slot.argName.store(reinterpret_cast<uintptr_t>(argName), std::memory_order_relaxed);
+        slot.arg.store(arg, std::memory_order_relaxed);
+        slot.sequence.store(2 * n + 2, std::memory_order_release);
+        buffer.written.store(n + 1, std::memory_order_release);
+    }
+
+    // Write every thread's retained events as Chrome trace JSON
+    bool dump(const std::string &path, size_t *eventCount = nullptr)
+    {
+        std::ofstream out(path, std::ios::trunc);
+        if (!out.is_open())
+        {
+            m_lastError = "Cannot create " + path;
+            return false;
+        }
+
+        std::vector<ThreadBuffer *> buffers;
+        std::vector<std::string> names;
+        {
+            std::lock_guard<std::mutex> lock(m_registryMutex);
+            for (const std::unique_ptr<ThreadBuffer> &buffer : m_buffers)
+            {
+                buffers.push_back(buffer.get());
+                names.push_back(buffer->name);
+            }
+        }
+
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        size_t events = 0;
+        char line[320];
+        for (size_t t = 0; t < buffers.size(); t++)
+        {
+            const ThreadBuffer &buffer = *buffers[t];
+            std::snprintf(line, sizeof(line), "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                          t ? ",\n" : "", buffer.tid, names[t].empty() ? "thread" : names[t].c_str());
+            out << line;
+
+            const uint64_t written = buffer.written.load(std::memory_order_acquire);
+            const uint64_t first = written > EVENTS_PER_THREAD ? written - EVENTS_PER_THREAD : 0;
+            for (uint64_t n = first; n < written; n++)
+            {
+                const Slot &slot = buffer.slots[n % EVENTS_PER_THREAD];
+                const uint64_t before = slot.sequence.load(std::memory_order_acquire);
+                const char *name = reinterpret_cast<const char *>(slot.name.load(std::memory_order_relaxed));
+                const char *category = reinterpret_cast<const char *>(slot.category.load(std::memory_order_relaxed));
+                const int64_t startNs = slot.startNs.load(std::memory_order_relaxed);
+                const int64_t durationNs = slot.durationNs.load(std::memory_order_relaxed);
+                const char *argName = reinterpret_cast<const char *>(slot.argName.load(std::memory_order_relaxed));
+                const int64_t arg = slot.arg.load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (before != 2 * n + 2 || slot.sequence.load(std::memory_order_relaxed) != before)
+                    continue; // Overwritten while we read it
+                int length = std::snprintf(line, sizeof(line),
+                                           ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f",
+                                           name, category, buffer.tid, startNs / 1000.0, durationNs / 1000.0);
+                if (argName && length > 0 && length < static_cast<int>(sizeof(line)))
+                    std::snprintf(line + length, sizeof(line) - length, ",\"args\":{\"%s\":%lld}", argName, static_cast<long long>(arg));
+                out << line << "}";
+                events++;
+            }
+        }
+        out << "\n]}\n";
+        if (eventCount)
+            *eventCount = events;
+        if (!out)
+        {
+            m_lastError = "Cannot write " + path;
+            return false;
+        }
+        return true;
+    }
+
+    std::string getLastError() const
+    {
+        return m_lastError;
+    }
+
+private:
+    struct Slot
+    {
+        std::atomic<uint64_t> sequence; // 2n+1 while event n is written, 2n+2 once complete
+        std::atomic<uintptr_t> name;
+        std::atomic<uintptr_t> category;
+        std::atomic<int64_t> startNs;
+        std::atomic<int64_t> durationNs;
+        std::atomic<uintptr_t> argName;
+        std::atomic<int64_t> arg;
+    };
+
+    struct ThreadBuffer
+    {
+        std::atomic<uint64_t> written; // Events recorded so far
+        int tid = 0;
+        std::string name; // Guarded by m_registryMutex
+        std::unique_ptr<Slot[]> slots;
+    };
+
+    TraceRecorder() : m_enabled(false), m_origin(std::chrono::steady_clock::now()) {}
+
+    // The calling thread's buffer, created on its first event
+    ThreadBuffer &threadBuffer()
+    {
+        static thread_local ThreadBuffer *buffer = nullptr;
+        if (!buffer)
+        {
+            std::unique_ptr<ThreadBuffer> created(new ThreadBuffer());
+            created->written.store(0, std::memory_order_relaxed);
+            created->slots.reset(new Slot[EVENTS_PER_THREAD]);
+            for (size_t i = 0; i < EVENTS_PER_THREAD; i++)
+                created->slots[i].sequence.store(0, std::memory_order_relaxed);
+            std::lock_guard<std::mutex> lock(m_registryMutex);
+            created->tid = static_cast<int>(m_buffers.size()) + 1;
+            buffer = created.get();
+            m_buffers.push_back(std::move(created));
+        }
+        return *buffer;
+    }
+
+    std::atomic<bool> m_enabled;
+    const std::chrono::steady_clock::time_point m_origin;
+    std::mutex m_registryMutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> m_buffers;
+    std::string m_lastError;
+};
+
+// Records the enclosing scope as one trace event when tracing is on
+class TraceScope
+{
+public:
+    TraceScope(const char *name, const char *category, const char *argName = nullptr, int64_t arg = 0)
+        : m_name(TraceRecorder::enabled() ? name : nullptr), m_category(category), m_argName(argName), m_arg(arg),
+          m_startNs(m_name ? TraceRecorder::instance().now() : 0)
+    {
+    }
+
+    ~TraceScope()
+    {
+        end();
+    }
+
+    // Close the event before the end of the scope
+    void end()
+    {
+        if (m_name)
+        {
+            TraceRecorder &recorder = TraceRecorder::instance();
+            recorder.record(m_name, m_category, m_startNs, recorder.now(), m_argName, m_arg);
+            m_name = nullptr;
+        }
+    }
+
+private:
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+
+    const char *m_name;
+    const char *m_category;
+    const char *m_argName;
+    int64_t m_arg;
+    int64_t m_startNs;
+};
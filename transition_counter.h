@@ -0,0 +1,275 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+#include <array>
+#include "cpu_features.h"
+
+// Per-channel edge counts for one capture frame
+struct TransitionCounts
+{
+    std::array<uint32_t, 32> transitions;                   // Edges over the whole frame
+    std::vector<std::array<uint32_t, 32>> sliceTransitions; // [slice][channel], edges inside each slice
+    uint32_t firstWord = 0;                                 // First sample of the frame
+    uint32_t lastWord = 0;                                  // Last sample of the frame
+
+    TransitionCounts()
+    {
+        transitions.fill(0);
+    }
+};
+
+// Single-pass, bit-parallel transition counter for all 32 channels.
+// Each sample word is XORed with its predecessor; every set bit of the result
+// is one edge on that channel. The per-bit counts for all channels are
+// accumulated together in byte lanes, so the frame is read once instead of
+// once per channel and once more per slice.
+class TransitionCounter
+{
+public:
+    // Count edges over the whole frame and inside each of numSlices slices.
+    // Slice boundaries match processData: slice s covers
+    // [s * (n / numSlices), (s + 1) * (n / numSlices)), the last slice runs to n,
+    // and an edge landing exactly on a slice start belongs to no slice.
+    static void count(const uint32_t *data, size_t n, int numSlices, TransitionCounts &out)
+    {
+        countWith(data, n, numSlices, out, cpu::hasAvx2() ? &accumulateAvx2 : &accumulateScalar);
+    }
+
+    static void countScalar(const uint32_t *data, size_t n, int numSlices, TransitionCounts &out)
+    {
+        countWith(data, n, numSlices, out, &accumulateScalar);
+    }
+
+    static void countAvx2(const uint32_t *data, size_t n, int numSlices, TransitionCounts &out)
+    {
+        countWith(data, n, numSlices, out, cpu::hasAvx2() ? &accumulateAvx2 : &accumulateScalar);
+    }
+
+private:
+    typedef void (*AccumulateFunc)(const uint32_t *, size_t, size_t, uint32_t *);
+
+    static void countWith(const uint32_t *data, size_t n, int numSlices, TransitionCounts &out,
+                          AccumulateFunc accumulate)
+    {
+        if (numSlices < 1)
+            numSlices = 1;
+
+        out.transitions.fill(0);
+        out.sliceTransitions.resize(numSlices);
+        for (auto &slice : out.sliceTransitions)
+        {
+            slice.fill(0);
+        }
+
+        if (n == 0)
+        {
+            out.firstWord = out.lastWord = 0;
+            return;
+        }
+
+        out.firstWord = data[0];
+        out.lastWord = data[n - 1];
+
+        const size_t samplesPerSlice = n / numSlices;
+        for (int slice = 0; slice < numSlices; slice++)
+        {
+            size_t start = slice * samplesPerSlice;
+            size_t end = (slice == numSlices - 1) ? n : (slice + 1) * samplesPerSlice;
+
+            if (start + 1 < end)
+            {
+                accumulate(data, start + 1, end, out.sliceTransitions[slice].data());
+            }
+            for (int ch = 0; ch < 32; ch++)
+            {
+                out.transitions[ch] += out.sliceTransitions[slice][ch];
+            }
+
+            // The edge into this slice is part of the frame total only
+            if (start >= 1)
+            {
+                uint32_t diff = data[start] ^ data[start - 1];
+                while (diff)
+                {
+                    uint32_t bit = diff & (0u - diff);
+                    out.transitions[bitIndex(bit)]++;
+                    diff ^= bit;
+                }
+            }
+        }
+    }
+
+    static int bitIndex(uint32_t singleBit)
+    {
+        int index = 0;
+        while (singleBit >>= 1)
+            index++;
+        return index;
+    }
+
+    // Byte b of spreadTable()[v] is 1 when bit b of v is set
+    static const uint64_t *spreadTable()
+    {
+        static const std::array<uint64_t, 256> table = []()
+        {
+            std::array<uint64_t, 256> t;
+            for (int v = 0; v < 256; v++)
+            {
+                uint64_t spread = 0;
+                for (int b = 0; b < 8; b++)
+                {
+                    if (v & (1 << b))
+                        spread |= 1ULL << (8 * b);
+                }
+                t[v] = spread;
+            }
+            return t;
+        }();
+        return table.data();
+    }
+
+    // Add the edges between data[i - 1] and data[i] for i in [begin, end) to counts.
+    // Four 64-bit accumulators hold one byte counter per channel and are flushed
+    // before any byte can overflow.
+    static void accumulateScalar(const uint32_t *data, size_t begin, size_t end, uint32_t *counts)
+    {
+        const uint64_t *spread = spreadTable();
+        size_t i = begin;
+        while (i < end)
+        {
+            const size_t blockEnd = (end - i > 255) ? i + 255 : end;
+            uint64_t acc0 = 0, acc1 = 0, acc2 = 0, acc3 = 0;
+            uint32_t prev = data[i - 1];
+            for (; i < blockEnd; i++)
+            {
+                const uint32_t cur = data[i];
+                const uint32_t diff = cur ^ prev;
+                prev = cur;
+                if (diff == 0)
+                    continue;
+                acc0 += spread[diff & 0xFF];
+                acc1 += spread[(diff >> 8) & 0xFF];
+                acc2 += spread[(diff >> 16) & 0xFF];
+                acc3 += spread[diff >> 24];
+            }
+            flushBytes(acc0, counts);
+            flushBytes(acc1, counts + 8);
+            flushBytes(acc2, counts + 16);
+            flushBytes(acc3, counts + 24);
+        }
+    }
+
+    static void flushBytes(uint64_t acc, uint32_t *counts)
+    {
+        for (int b = 0; b < 8; b++)
+        {
+            counts[b] += static_cast<uint32_t>((acc >> (8 * b)) & 0xFF);
+        }
+    }
+
+#ifdef LA_HAVE_X86
+    // Carry-save adder over three bit-planes
+    LA_TARGET_AVX2 static inline void csa(__m256i &high, __m256i &low, __m256i a, __m256i b, __m256i c)
+    {
+        const __m256i u = _mm256_xor_si256(a, b);
+        high = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(u, c));
+        low = _mm256_xor_si256(u, c);
+    }
+
+    LA_TARGET_AVX2 static inline __m256i diffAt(const uint32_t *data, size_t i)
+    {
+        const __m256i cur = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+        const __m256i prev = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i - 1));
+        return _mm256_xor_si256(cur, prev);
+    }
+
+    // Add (plane << shift) to counts for every lane and bit position
+    LA_TARGET_AVX2 static void flushPlane(__m256i plane, int shift, uint32_t *counts)
+    {
+        alignas(32) uint32_t lanes[8];
+        _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), plane);
+        for (int lane = 0; lane < 8; lane++)
+        {
+            uint32_t bits = lanes[lane];
+            while (bits)
+            {
+                counts[bitIndex(bits & (0u - bits))] += 1u << shift;
+                bits &= bits - 1;
+            }
+        }
+    }
+
+    // AVX2 kernel: Harley-Seal carry-save tree. Eight diff words per vector are
+    // reduced sixteen vectors at a time into ones/twos/fours/eights bit-planes,
+    // and the carries out of that tree go into an 8-bit vertical counter, so the
+    // per-channel totals are only materialised once every 32640 words.
+    LA_TARGET_AVX2 static void accumulateAvx2(const uint32_t *data, size_t begin, size_t end, uint32_t *counts)
+    {
+        const size_t blockWords = 16 * 8;
+        size_t i = begin;
+        while (end - i >= blockWords)
+        {
+            __m256i ones = _mm256_setzero_si256();
+            __m256i twos = _mm256_setzero_si256();
+            __m256i fours = _mm256_setzero_si256();
+            __m256i eights = _mm256_setzero_si256();
+            __m256i counter[8];
+            for (int k = 0; k < 8; k++)
+            {
+                counter[k] = _mm256_setzero_si256();
+            }
+
+            for (int block = 0; block < 255 && end - i >= blockWords; block++, i += blockWords)
+            {
+                __m256i twosA, twosB, foursA, foursB, eightsA, eightsB, sixteens;
+
+                csa(twosA, ones, ones, diffAt(data, i + 0), diffAt(data, i + 8));
+                csa(twosB, ones, ones, diffAt(data, i + 16), diffAt(data, i + 24));
+                csa(foursA, twos, twos, twosA, twosB);
+                csa(twosA, ones, ones, diffAt(data, i + 32), diffAt(data, i + 40));
+                csa(twosB, ones, ones, diffAt(data, i + 48), diffAt(data, i + 56));
+                csa(foursB, twos, twos, twosA, twosB);
+                csa(eightsA, fours, fours, foursA, foursB);
+                csa(twosA, ones, ones, diffAt(data, i + 64), diffAt(data, i + 72));
+                csa(twosB, ones, ones, diffAt(data, i + 80), diffAt(data, i + 88));
+                csa(foursA, twos, twos, twosA, twosB);
+                csa(twosA, ones, ones, diffAt(data, i + 96), diffAt(data, i + 104));
+                csa(twosB, ones, ones, diffAt(data, i + 112), diffAt(data, i + 120));
+                csa(foursB, twos, twos, twosA, twosB);
+                csa(eightsB, fours, fours, foursA, foursB);
+                csa(sixteens, eights, eights, eightsA, eightsB);
+
+                // Ripple the sixteens carry through the vertical counter
+                __m256i carry = sixteens;
+                for (int k = 0; k < 8; k++)
+                {
+                    const __m256i next = _mm256_and_si256(counter[k], carry);
+                    counter[k] = _mm256_xor_si256(counter[k], carry);
+                    carry = next;
+                }
+            }
+
+            flushPlane(ones, 0, counts);
+            flushPlane(twos, 1, counts);
+            flushPlane(fours, 2, counts);
+            flushPlane(eights, 3, counts);
+            for (int k = 0; k < 8; k++)
+            {
+                flushPlane(counter[k], 4 + k, counts);
+            }
+        }
+
+        if (i < end)
+        {
+            accumulateScalar(data, i, end, counts);
+        }
+    }
+#else
+    static void accumulateAvx2(const uint32_t *data, size_t begin, size_t end, uint32_t *counts)
+    {
+        accumulateScalar(data, begin, end, counts);
+    }
+#endif
+};
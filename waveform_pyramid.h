@@ -0,0 +1,207 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include "bitsliced_frame.h"
+
+// Bucket flags of a waveform view
+enum WaveformBucketFlags
+{
+    WAVEFORM_ANY_HIGH = 1, // The channel is high somewhere in the bucket
+    WAVEFORM_ANY_LOW = 2   // ... and/or low somewhere in it
+};
+
+// Zoomed view of one channel: count buckets of bucketSamples samples each,
+// the first starting at sample start. The last bucket may be cut short by
+// the end of the frame.
+struct WaveformView
+{
+    uint64_t start = 0;
+    uint64_t bucketSamples = 1;
+    std::vector<uint8_t> flags;    // WaveformBucketFlags per bucket
+    std::vector<uint32_t> toggles; // Edges per bucket (an edge at i belongs to the bucket holding sample i)
+};
+
+// Min/max level-of-detail pyramid of every channel of a frame, so a viewer
+// can draw the real waveform at any zoom with a bounded number of buckets.
+// Level 0 buckets cover BASE_SAMPLES samples and are summarised straight
+// from the frame's channel bitstreams (popcounts over BASE_SAMPLES / 64
+// words); every further level merges pairs of buckets of the level below.
+// Zooms finer than level 0 are answered from the bitstreams themselves,
+// which the pyramid keeps alive for that purpose.
+class WaveformPyramid
+{
+public:
+    enum
+    {
+        BASE_SAMPLES = 1024,
+        MAX_BUCKETS = 4096 // Most buckets query() returns
+    };
+
+    static std::shared_ptr<const WaveformPyramid> build(std::shared_ptr<const BitSlicedFrame> bits)
+    {
+        std::shared_ptr<WaveformPyramid> pyramid(new WaveformPyramid(std::move(bits)));
+        pyramid->buildBase();
+        while (pyramid->m_levels.back().count > 1)
+        {
+            pyramid->buildNextLevel();
+        }
+        return pyramid;
+    }
+
+    size_t size() const
+    {
+        return m_bits->size();
+    }
+
+    int levelCount() const
+    {
+        return static_cast<int>(m_levels.size());
+    }
+
+    // Buckets of at most maxBuckets (capped at MAX_BUCKETS) covering
+    // [begin, end) of one channel, at the finest power-of-two bucket size
+    // that fits. Buckets are aligned to their size, so the view can start a
+    // little before begin.
+    void query(int ch, uint64_t begin, uint64_t end, size_t maxBuckets, WaveformView &out) const
+    {
+        out.flags.clear();
+        out.toggles.clear();
+        end = std::min<uint64_t>(end, size());
+        maxBuckets = std::max<size_t>(1, std::min<size_t>(maxBuckets, MAX_BUCKETS));
+        if (begin >= end)
+        {
+            out.start = begin;
+            out.bucketSamples = 1;
+            return;
+        }
+
+        uint64_t bucketSamples = 1;
+        uint64_t start = begin;
+        uint64_t count = end - begin;
+        while (count > maxBuckets)
+        {
+            bucketSamples *= 2;
+            start = begin - begin % bucketSamples;
+            count = (end - start + bucketSamples - 1) / bucketSamples;
+        }
+        out.start = start;
+        out.bucketSamples = bucketSamples;
+        out.flags.resize(static_cast<size_t>(count));
+        out.toggles.resize(static_cast<size_t>(count));
+
+        if (bucketSamples >= BASE_SAMPLES)
+        {
+            int level = 0;
+            while ((static_cast<uint64_t>(BASE_SAMPLES) << level) < bucketSamples)
+                level++;
+            const Level &source = m_levels[level];
+            const size_t first = static_cast<size_t>(start / bucketSamples);
+            for (size_t b = 0; b < count; b++)
+            {
+                out.flags[b] = source.flags[ch * source.count + first + b];
+                out.toggles[b] = source.toggles[ch * source.count + first + b];
+            }
+        }
+        else
+        {
+            for (size_t b = 0; b < count; b++)
+            {
+                const uint64_t bucketBegin = start + b * bucketSamples;
+                summarize(ch, static_cast<size_t>(bucketBegin),
+                          static_cast<size_t>(std::min<uint64_t>(bucketBegin + bucketSamples, end)),
+                          out.flags[b], out.toggles[b]);
+            }
+        }
+    }
+
+private:
+    // Channel-major bucket summaries of one level
+    struct Level
+    {
+        size_t count = 0; // Buckets per channel
+        std::vector<uint8_t> flags;
+        std::vector<uint32_t> toggles;
+    };
+
+    explicit WaveformPyramid(std::shared_ptr<const BitSlicedFrame> bits) : m_bits(std::move(bits)) {}
+
+    // Flags and edge count of samples [begin, end) straight from the bitstream
+    void summarize(int ch, size_t begin, size_t end, uint8_t &flags, uint32_t &toggles) const
+    {
+        const size_t high = m_bits->countHigh(ch, begin, end);
+        flags = static_cast<uint8_t>((high > 0 ? WAVEFORM_ANY_HIGH : 0) | (high < end - begin ? WAVEFORM_ANY_LOW : 0));
+        // Edges at positions begin..end-1 are the ones strictly inside [begin - 1, end)
+        toggles = static_cast<uint32_t>(m_bits->countTransitions(ch, begin > 0 ? begin - 1 : 0, end));
+    }
+
+    // One pass over each channel's words: OR/AND for the flags, popcount of
+    // the XOR with the previous sample for the toggles
+    void buildBase()
+    {
+        enum
+        {
+            WORDS_PER_BUCKET = BASE_SAMPLES / 64
+        };
+        m_levels.emplace_back();
+        Level &base = m_levels.back();
+        base.count = std::max<size_t>(1, (size() + BASE_SAMPLES - 1) / BASE_SAMPLES);
+        base.flags.assign(32 * base.count, 0);
+        base.toggles.assign(32 * base.count, 0);
+        const size_t wordCount = m_bits->wordCount();
+        const size_t tail = size() % 64;
+        const uint64_t lastMask = tail ? (~0ULL >> (64 - tail)) : ~0ULL;
+        for (int ch = 0; ch < 32; ch++)
+        {
+            const uint64_t *words = m_bits->channel(ch);
+            for (size_t b = 0; b < base.count && b * WORDS_PER_BUCKET < wordCount; b++)
+            {
+                const size_t first = b * WORDS_PER_BUCKET;
+                const size_t last = std::min<size_t>(first + WORDS_PER_BUCKET, wordCount);
+                uint64_t any = 0, all = ~0ULL;
+                uint32_t toggles = 0;
+                for (size_t k = first; k < last; k++)
+                {
+                    const uint64_t valid = k + 1 == wordCount ? lastMask : ~0ULL;
+                    const uint64_t word = words[k] & valid;
+                    // Sample 0 has no predecessor, so it is compared with itself
+                    const uint64_t carry = k > 0 ? (words[k - 1] >> 63) : (words[0] & 1);
+                    any |= word;
+                    all &= word | ~valid;
+                    toggles += static_cast<uint32_t>(cpu::popcount64((word ^ ((word << 1) | carry)) & valid));
+                }
+                base.flags[ch * base.count + b] = static_cast<uint8_t>((any ? WAVEFORM_ANY_HIGH : 0) |
+                                                                       (all != ~0ULL ? WAVEFORM_ANY_LOW : 0));
+                base.toggles[ch * base.count + b] = toggles;
+            }
+        }
+    }
+
+    void buildNextLevel()
+    {
+        const size_t below = m_levels.size() - 1;
+        m_levels.emplace_back();
+        const Level &source = m_levels[below];
+        Level &level = m_levels.back();
+        level.count = (source.count + 1) / 2;
+        level.flags.resize(32 * level.count);
+        level.toggles.resize(32 * level.count);
+        for (int ch = 0; ch < 32; ch++)
+        {
+            const uint8_t *flags = source.flags.data() + ch * source.count;
+            const uint32_t *toggles = source.toggles.data() + ch * source.count;
+            for (size_t b = 0; b < level.count; b++)
+            {
+                const size_t left = 2 * b;
+                const bool paired = left + 1 < source.count;
+                level.flags[ch * level.count + b] = static_cast<uint8_t>(flags[left] | (paired ? flags[left + 1] : 0));
+                level.toggles[ch * level.count + b] = toggles[left] + (paired ? toggles[left + 1] : 0);
+            }
+        }
+    }
+
+    std::shared_ptr<const BitSlicedFrame> m_bits;
+    std::vector<Level> m_levels; // m_levels[l] has buckets of BASE_SAMPLES << l samples
+};